@@ -0,0 +1,253 @@
+/**
+ * @file: chain_item.cpp
+ * Implementation of graphics item for a chain of edges through edge controls
+ * @ingroup GUIGraph
+ */
+/*
+ * GUI for ShowGraph tool.
+ * Copyright (c) 2009, Boris Shurygin
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "gview_impl.h"
+
+/**
+ * Get point where line from node's center to outer point crosses node's outline
+ */
+static QPointF borderPoint( NodeItem *item, const QPointF &center, const QPointF &outer)
+{
+    QPolygonF outline = item->mapToScene( item->outlinePolygon());
+    QLineF line( center, outer);
+    QPointF res;
+
+    for ( int i = 1; i < outline.count(); i++)
+    {
+        if ( QLineF( outline[ i - 1], outline[ i]).intersect( line, &res) == QLineF::BoundedIntersection)
+            return res;
+    }
+    return center;
+}
+
+/**
+ * Get point where chain is attached to its end node
+ */
+static QPointF endPoint( GNode *n, const QPointF &outer)
+{
+    NodeItem *item = n->item();
+
+    if ( n->isEdgeLabel())
+        return item->mapToScene( item->borderRect().left(), item->borderRect().center().y());
+
+    QPointF center = item->mapToScene( item->boundingRect().center());
+
+    if ( n->isSimple())
+        return borderPoint( item, center, outer);
+    return center;
+}
+
+/**
+ * Get center of edge control from its model coordinates, see placementPos()
+ */
+static QPointF controlCenter( GNode *n)
+{
+    QRectF rect = NodeItem::controlBorderRect();
+
+    return QPointF( n->modelX() + rect.width() / 2, n->modelY() + rect.height() / 2);
+}
+
+/**
+ * Get vector of given length in direction of given one
+ */
+static QPointF scaledDir( const QPointF &dir, qreal len)
+{
+    qreal dir_len = sqrt( dir.x() * dir.x() + dir.y() * dir.y());
+
+    if ( dir_len < 1)
+        return QPointF();
+    return dir * len / dir_len;
+}
+
+/**
+ * Constructor. Collects edges of chain that starts with given edge
+ */
+EdgeChainItem::EdgeChainItem( GEdge *first):
+    chain_edges(),
+    points(),
+    path(),
+    shape_path(),
+    arrow(),
+    bounding_rect()
+{
+    GEdge *e = first;
+
+    chain_edges << e;
+    while ( e->succ()->isEdgeControl() && isNotNullP( e->succ()->firstSucc()))
+    {
+        e = e->succ()->firstSucc();
+        chain_edges << e;
+    }
+    QGraphicsItem::setCursor( Qt::ArrowCursor);
+    setFlag( ItemIsSelectable);
+    setZValue( 1);
+}
+
+/**
+ * Recompute spline from end nodes and controls. Each piece between two points is
+ * a cubic curve whose tangents follow the neighbouring points, like those of EdgeItem
+ */
+void
+EdgeChainItem::adjust()
+{
+    prepareGeometryChange();
+    if ( !pred()->item()->isVisible() || !succ()->item()->isVisible())
+    {
+        setVisible( false);
+        return;
+    }
+    setVisible( true);
+
+    points.clear();
+    for ( int i = 0; i < chain_edges.size() - 1; i++)
+    {
+        points << controlCenter( chain_edges[ i]->succ());
+    }
+    QPointF pred_center = pred()->item()->mapToScene( pred()->item()->boundingRect().center());
+    QPointF succ_center = succ()->item()->mapToScene( succ()->item()->boundingRect().center());
+
+    points.prepend( endPoint( pred(), points.isEmpty() ? succ_center : points.first()));
+    points.append( endPoint( succ(), points.count() == 1 ? pred_center : points.last()));
+
+    path = QPainterPath( points.first());
+    for ( int i = 0; i < points.count() - 1; i++)
+    {
+        QPointF src = points[ i];
+        QPointF dst = points[ i + 1];
+        QPointF dir1 = ( i > 0) ? dst - points[ i - 1] : dst - src;
+        QPointF dir2 = ( i + 2 < points.count()) ? src - points[ i + 2] : src - dst;
+        qreal size = min< qreal>( abs< qreal>( dst.x() - src.x()), abs< qreal>( dst.y() - src.y()));
+
+        size = max< qreal>( size, 2 * EdgeControlSize);
+        size = min< qreal>( size, 20 * EdgeControlSize);
+        path.cubicTo( src + scaledDir( dir1, size), dst + scaledDir( dir2, size), dst);
+    }
+
+    QLineF line( points[ points.count() - 2], points.last());
+
+    arrow.clear();
+    if ( succ()->isSimple() && line.length() > 0)
+    {
+        double angle = ::acos( line.dx() / line.length());
+        if ( line.dy() >= 0)
+            angle = TwoPi - angle;
+
+        arrow << line.p2()
+              << line.p2() + QPointF( sin( angle - Pi / 3) * arrowSize,
+                                      cos( angle - Pi / 3) * arrowSize)
+              << line.p2() + QPointF( sin( angle - Pi + Pi / 3) * arrowSize,
+                                      cos( angle - Pi + Pi / 3) * arrowSize);
+    }
+
+    QPainterPathStroker stroker;
+
+    stroker.setWidth( isNotNullP( firstEdge()->style()) ? firstEdge()->style()->pen().width() + 1 : 2);
+    shape_path = stroker.createStroke( path);
+    bounding_rect = path.controlPointRect()
+                    .united( arrow.boundingRect())
+                    .adjusted( -arrowSize, -arrowSize, arrowSize, arrowSize);
+    update();
+}
+
+/**
+ * Get bounding rectangle
+ */
+QRectF
+EdgeChainItem::boundingRect() const
+{
+    return bounding_rect;
+}
+
+/**
+ * Get shape of the chain, it is stroked once per adjust
+ */
+QPainterPath
+EdgeChainItem::shape() const
+{
+    return shape_path;
+}
+
+/**
+ * Paint chain, at small scale it is drawn as polyline
+ */
+void
+EdgeChainItem::paint( QPainter *painter,
+                      const QStyleOptionGraphicsItem *option,
+                      QWidget *widget)
+{
+    static const qreal spline_detail_level = 0.4;
+    static const qreal draw_arrow_detail_level = 0.3;
+
+    if ( option->levelOfDetail < 0.1 || points.count() < 2)
+        return;
+
+    if ( firstEdge()->graph()->view()->isContext())
+    {
+        painter->setOpacity( min< qreal>( pred()->item()->opacityLevel(),
+                                          succ()->item()->opacityLevel()));
+    }
+
+    QPen pen( option->palette.foreground().color(),
+              1, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin);
+
+    if ( isNotNullP( firstEdge()->style()))
+        pen = firstEdge()->style()->pen();
+
+    if ( option->levelOfDetail >= spline_detail_level)
+    {
+        if ( option->state & QStyle::State_Selected)
+            pen.setWidthF( pen.widthF() + 1);
+        painter->setPen( pen);
+        painter->drawPath( path);
+    } else
+    {
+        painter->setPen( QPen( pen.color(), 1));
+        painter->drawPolyline( points);
+    }
+    if ( option->levelOfDetail >= draw_arrow_detail_level && !arrow.isEmpty())
+    {
+        pen.setStyle( Qt::SolidLine);
+        painter->setPen( pen);
+        painter->setBrush( pen.color());
+        painter->drawPolygon( arrow);
+    }
+    painter->setOpacity( 1);
+}
+
+/**
+ * Event handler for mouse release, chain is selected as its first edge
+ */
+void
+EdgeChainItem::mouseReleaseEvent( QGraphicsSceneMouseEvent *ev)
+{
+    GGraph *graph = firstEdge()->graph();
+
+    update();
+    graph->emptySelection();
+    graph->selectEdge( firstEdge());
+    if ( ev->button() & Qt::RightButton)
+    {
+        QMenu *menu = graph->view()->createMenuForEdge( firstEdge());
+        graph->view()->setCurrPos( ev->pos());
+        menu->exec( ev->screenPos());
+        delete menu;
+    }
+    QGraphicsItem::mouseReleaseEvent( ev);
+}
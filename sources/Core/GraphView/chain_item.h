@@ -0,0 +1,94 @@
+/**
+ * @file: chain_item.h
+ * Graphics item for a chain of edges through edge controls
+ * @ingroup GUIGraph
+ */
+/*
+ * GUI for ShowGraph tool.
+ * Copyright (c) 2009, Boris Shurygin
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef CHAIN_ITEM_H
+#define CHAIN_ITEM_H
+
+/**
+ * Graphics item that draws a logical edge: a chain of edges from a node through
+ * edge controls to the next node that is not a control
+ * @ingroup GUIGraph
+ *
+ * In edge chain mode of GraphView the chain is drawn as one spline and its edge items
+ * and control node items are kept out of scene. Controls are taken as plain model
+ * coordinates, so only moves of the end nodes update the chain
+ */
+class EdgeChainItem: public QGraphicsItem
+{
+    /** Edges of chain in order from predecessor to successor */
+    QVector< GEdge *> chain_edges;
+    /** Points the spline passes through: end points on node borders and controls' centers */
+    QPolygonF points;
+    /** Spline through the points */
+    QPainterPath path;
+    /** Stroked path for hit tests */
+    QPainterPath shape_path;
+    /** Arrow at successor */
+    QPolygonF arrow;
+    /** Bounding rectangle */
+    QRectF bounding_rect;
+public:
+    /** Type of graphics item for edge chain */
+    enum {Type = TypeEdgeChain};
+    /** Constructor. Collects edges of chain that starts with given edge */
+    EdgeChainItem( GEdge *first);
+    /** Get item type */
+    int type() const
+    {
+        return Type;
+    }
+    /** Get edges of chain */
+    inline const QVector< GEdge *> &edges() const
+    {
+        return chain_edges;
+    }
+    /** Get the first edge of chain */
+    inline GEdge *firstEdge() const
+    {
+        return chain_edges.first();
+    }
+    /** Get the last edge of chain */
+    inline GEdge *lastEdge() const
+    {
+        return chain_edges.last();
+    }
+    /** Get predecessor of chain */
+    inline GNode *pred() const
+    {
+        return firstEdge()->pred();
+    }
+    /** Get successor of chain */
+    inline GNode *succ() const
+    {
+        return lastEdge()->succ();
+    }
+    /** Recompute spline from end nodes and controls */
+    void adjust();
+    /** Get bounding rectangle */
+    QRectF boundingRect() const;
+    /** Get shape of the chain */
+    QPainterPath shape() const;
+    /** Paint chain */
+    void paint( QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget);
+    /** Event handler for mouse release, chain is selected as its first edge */
+    void mouseReleaseEvent( QGraphicsSceneMouseEvent *event);
+};
+
+#endif /* CHAIN_ITEM_H */
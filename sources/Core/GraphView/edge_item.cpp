@@ -24,10 +24,10 @@
 //#define SHOW_BACKEDGES
 
 GEdge::GEdge( GGraph *graph_p, int _id, GNode *_pred, GNode* _succ):
-    AuxEdge( (AuxGraph *)graph_p, _id, (AuxNode *)_pred, (AuxNode *)_succ), _style( NULL)
+    AuxEdge( (AuxGraph *)graph_p, _id, (AuxNode *)_pred, (AuxNode *)_succ), chain_p( NULL), _style( NULL)
 {
     item_p = new EdgeItem( this);
-    graph()->view()->scene()->addItem( item_p);
+    graph()->view()->addGraphItem( item_p);
     item_p->adjust();
     graph()->invalidateRanking();
 }
@@ -35,6 +35,8 @@ GEdge::GEdge( GGraph *graph_p, int _id, GNode *_pred, GNode* _succ):
 GEdge::~GEdge()
 {
     graph()->invalidateRanking();
+    if ( isNotNullP( chain_p))
+        graph()->view()->removeEdgeChain( chain_p);
     item()->remove();
     graph()->view()->deleteLaterEdgeItem( item());
     if ( isNotNullP( _style))
@@ -155,7 +157,7 @@ GEdge::insertNode()
  * EdgeItem implementaion
  */
 /** Constructor */
-EdgeItem::EdgeItem( GEdge *e_p): edge_p( e_p)
+EdgeItem::EdgeItem( GEdge *e_p): edge_p( e_p), shape_width( -1)
 {
     curr_mode = ModeShow;
     QGraphicsItem::setCursor( Qt::ArrowCursor);
@@ -165,6 +167,19 @@ EdgeItem::EdgeItem( GEdge *e_p): edge_p( e_p)
     setZValue(1);
 }
 
+/**
+ * Remove from scene, item is disconnected from edge
+ */
+void
+EdgeItem::remove()
+{
+    setVisible( false);
+    removeFromIndex();
+    edge_p->graph()->view()->dropEdgeRoute( this);
+    edge_p->graph()->view()->removeGraphItem( this);
+    edge_p = NULL;
+}
+
 QVariant
 EdgeItem::itemChange( GraphicsItemChange change, const QVariant &value)
 {
@@ -172,6 +187,9 @@ EdgeItem::itemChange( GraphicsItemChange change, const QVariant &value)
     {
         pred()->item()->update();
         succ()->item()->update();
+    } else if ( change == QGraphicsItem::ItemVisibleHasChanged && isNotNullP( edge()))
+    {
+        edge()->graph()->view()->invalidateOverview();
     }
     return QGraphicsItem::itemChange( change, value);
 }    
@@ -191,102 +209,140 @@ QPainterPath EdgeItem::selfEdgePath() const
     return path;
 }
 
-void
-EdgeItem::adjust()
+/**
+ * Get end of edge for edge routing
+ */
+static EdgeRouteEnd
+routeEnd( const EdgeItem *edge_item, NodeItem *item)
 {
-    prepareGeometryChange();
-    if ( edge()->pred()->item()->isVisible()
-         && edge()->succ()->item()->isVisible())
+    EdgeRouteEnd end;
+    
+    end.pos = edge_item->mapFromItem( item, QPointF( 0, 0));
+    end.border_rect = item->borderRect();
+    end.visible = item->isVisible();
+    end.simple = item->node()->isSimple();
+    end.label = item->node()->isEdgeLabel();
+    if ( end.simple)
+        end.outline = item->outlinePolygon();
+    return end;
+}
+
+/**
+ * Copy data that route of edge is computed from. Only positions and cached geometry
+ * of end nodes are read, so the copy is cheap
+ */
+EdgeRouteJob
+EdgeItem::routeJob() const
+{
+    EdgeRouteJob job;
+
+    job.pred = routeEnd( this, pred()->item());
+    job.succ = routeEnd( this, succ()->item());
+    job.self = edge()->isSelf();
+    job.has_next_pred = false;
+    job.has_next_succ = false;
+    if ( ( pred()->isEdgeControl() || pred()->isEdgeLabel()) 
+         && isNotNullP( pred()->firstPred()))
     {
-        setVisible( true);
-    } else
+        NodeItem *next_pred = pred()->firstPred()->pred()->item();
+        job.has_next_pred = true;
+        job.next_pred = mapFromItem( next_pred, next_pred->borderRect().center());
+    } 
+    if ( ( succ()->isEdgeControl() || succ()->isEdgeLabel()) 
+         && isNotNullP( succ()->firstSucc()))
     {
-        setVisible( false);
+        NodeItem *next_succ = succ()->firstSucc()->succ()->item();
+        job.has_next_succ = true;
+        job.next_succ = mapFromItem( next_succ, next_succ->borderRect().center());
+    } 
+    return job;
+}
+
+/**
+ * Find where line crosses outline of node, point is left unchanged if they don't cross
+ */
+static void
+clipByOutline( const QLineF &line, const QPolygonF &outline, QPointF *point)
+{
+    if ( outline.isEmpty())
         return;
+
+    QPointF p1 = outline.first();
+    QPointF p2;
+    QLineF polyLine;
+    
+    for ( int i = 1; i < outline.count(); ++i) {
+        p2 = outline.at(i);
+        polyLine = QLineF(p1, p2);
+        QLineF::IntersectType intersectType =
+             polyLine.intersect( line, point);
+        if ( intersectType == QLineF::BoundedIntersection)
+             break;
+        p1 = p2;
     }
-    if ( edge()->isSelf())
-    {
-        QPointF center = mapFromItem( pred()->item(), pred()->item()->borderRect().center());
-        QRectF r = pred()->item()->borderRect();
-        srcP = center + QPointF( 3 * r.width()/8, r.height() /2);
-        dstP = center + QPointF( 3 * r.width()/8, -r.height() /2);
-        topLeft = center + QPointF( 3 * r.width()/8, -r.height()/2 - SE_VERT_MARGIN);
-        cp1 = center + QPointF( (r.width() / 2) + SE_HOR_MARGIN, 0);
-        btmRight = cp1 + QPointF( 0, r.height()/2 + SE_VERT_MARGIN);
-        
-        update();
-        return;
+}
+
+/**
+ * Compute route of edge. Only the job is read, so routes of many edges can be
+ * computed concurrently and give the same result as computing them one by one
+ */
+EdgeRoute
+EdgeItem::route( const EdgeRouteJob &job)
+{
+    EdgeRoute r;
+    
+    r.visible = job.pred.visible && job.succ.visible;
+    if ( !r.visible)
+        return r;
+
+    if ( job.self)
+    {
+        QRectF rect = job.pred.border_rect;
+        QPointF center = job.pred.pos + rect.center();
+        r.src = center + QPointF( 3 * rect.width()/8, rect.height() /2);
+        r.dst = center + QPointF( 3 * rect.width()/8, -rect.height() /2);
+        r.top_left = center + QPointF( 3 * rect.width()/8, -rect.height()/2 - SE_VERT_MARGIN);
+        r.cp1 = center + QPointF( (rect.width() / 2) + SE_HOR_MARGIN, 0);
+        r.cp2 = r.dst;
+        r.btm_right = r.cp1 + QPointF( 0, rect.height()/2 + SE_VERT_MARGIN);
+        return r;
     }
-    srcP = mapFromItem( pred()->item(), pred()->item()->boundingRect().center());
-    dstP = mapFromItem( succ()->item(), succ()->item()->boundingRect().center());
-    topLeft = srcP;
-    btmRight = dstP;
-    QPointF srcCP = srcP;
-    QPointF dstCP = dstP;
-
-    if ( pred()->isEdgeLabel())
-    {
-        srcP = mapFromItem( pred()->item(),
-                            pred()->item()->borderRect().left(),
-                            pred()->item()->borderRect().center().y());
-        qreal w = pred()->item()->borderRect().width();
-        //srcP += QPointF( -w, 0);
-        srcCP = srcP;
+    r.src = job.pred.pos + job.pred.border_rect.center();
+    r.dst = job.succ.pos + job.succ.border_rect.center();
+    QPointF srcCP = r.src;
+    QPointF dstCP = r.dst;
+
+    if ( job.pred.label)
+    {
+        r.src = job.pred.pos + QPointF( job.pred.border_rect.left(),
+                                        job.pred.border_rect.center().y());
+        srcCP = r.src;
     } 
-    if ( succ()->isEdgeLabel())
+    if ( job.succ.label)
     {
-        dstP = mapFromItem( succ()->item(),
-                            succ()->item()->borderRect().left(),
-                            succ()->item()->borderRect().center().y());
-        dstCP = dstP;
+        r.dst = job.succ.pos + QPointF( job.succ.border_rect.left(),
+                                        job.succ.border_rect.center().y());
+        dstCP = r.dst;
     } 
-
-    if ( pred()->isSimple())
+    if ( job.pred.simple)
     {
-        QLineF line( srcP, dstP);
-        QPolygonF endPolygon = mapFromItem( pred()->item(), pred()->item()->shape().toFillPolygon());
-        QPointF p1 = endPolygon.first();
-        QPointF p2;
-        QPointF intersectPoint;
-        QLineF polyLine;
-        
-        for (int i = 1; i < endPolygon.count(); ++i) {
-            p2 = endPolygon.at(i);
-            polyLine = QLineF(p1, p2);
-            QLineF::IntersectType intersectType =
-                 polyLine.intersect( line, &srcP);
-            if (intersectType == QLineF::BoundedIntersection)
-                 break;
-            p1 = p2;
-        }
+        clipByOutline( QLineF( r.src, r.dst), job.pred.outline.translated( job.pred.pos), &r.src);
     }
-    if ( succ()->isSimple())
+    if ( job.succ.simple)
     {
-        QLineF line2( srcP, dstP);
-        QPolygonF endPolygon = mapFromItem( succ()->item(), succ()->item()->shape().toFillPolygon());
-        QPointF p1 = endPolygon.first();;
-        QPointF p2;
-        QLineF polyLine;
-        
-        for ( int i = 1; i < endPolygon.count(); ++i) {
-            p2 = endPolygon.at(i);
-            polyLine = QLineF(p1, p2);
-            QLineF::IntersectType intersectType =
-                 polyLine.intersect( line2, &dstP);
-            if ( intersectType == QLineF::BoundedIntersection)
-                 break;
-            p1 = p2;
-        }
+        clipByOutline( QLineF( r.src, r.dst), job.succ.outline.translated( job.succ.pos), &r.dst);
     }
-    topLeft.setX( min< qreal>( srcP.x(), dstP.x()));
-    topLeft.setY( min< qreal>( srcP.y(), dstP.y()));
-    btmRight.setX( max< qreal>( srcP.x(), dstP.x()));
-    btmRight.setY( max< qreal>( srcP.y(), dstP.y()));
-
-    QLineF mainLine = QLineF( srcP, dstP);
+    r.top_left.setX( min< qreal>( r.src.x(), r.dst.x()));
+    r.top_left.setY( min< qreal>( r.src.y(), r.dst.y()));
+    r.btm_right.setX( max< qreal>( r.src.x(), r.dst.x()));
+    r.btm_right.setY( max< qreal>( r.src.y(), r.dst.y()));
+    r.cp1 = r.src;
+    r.cp2 = r.dst;
+
+    QLineF mainLine = QLineF( r.src, r.dst);
         
     if ( mainLine.length() < 1)
-        return;
+        return r;
 
     qreal size = abs< qreal>(( min< qreal>( abs< qreal>( mainLine.dx()),
                                             abs< qreal>( mainLine.dy()))));
@@ -300,62 +356,80 @@ EdgeItem::adjust()
         size = 20 * EdgeControlSize;
     }
     
-    NodeItem *next_pred = NULL;
-    NodeItem *next_succ = NULL;
-
-    if ( ( pred()->isEdgeControl() || pred()->isEdgeLabel()) 
-         && isNotNullP( pred()->firstPred()))
-    {
-        next_pred = pred()->firstPred()->pred()->item();
-    } 
-    if ( ( succ()->isEdgeControl() || succ()->isEdgeLabel()) 
-         && isNotNullP( succ()->firstSucc()))
-    {
-        next_succ = succ()->firstSucc()->succ()->item();
-    } 
     /** Place cp1 */
-    if ( isNotNullP( next_pred))
+    if ( job.has_next_pred)
     {
-        QPointF p1 = mapFromItem( next_pred, next_pred->borderRect().center());
-        QLineF line( p1, dstCP);
+        QLineF line( job.next_pred, dstCP);
         QPointF cp1_offset = QPointF( (line.dx() * size)/ line.length(),
                                       (line.dy() * size)/ line.length());
-        cp1 = srcP + cp1_offset;
+        r.cp1 = r.src + cp1_offset;
     } else
     {
         QPointF cp1_offset = QPointF( (mainLine.dx() * size)/ mainLine.length(),
                                       (mainLine.dy() * size)/ mainLine.length());
-        cp1 = srcP + cp1_offset;
+        r.cp1 = r.src + cp1_offset;
     }
     
-    topLeft.setX( min< qreal>( topLeft.x(), cp1.x()));
-    topLeft.setY( min< qreal>( topLeft.y(), cp1.y()));
-    btmRight.setX( max< qreal>( btmRight.x(), cp1.x()));
-    btmRight.setY( max< qreal>( btmRight.y(), cp1.y()));
+    r.top_left.setX( min< qreal>( r.top_left.x(), r.cp1.x()));
+    r.top_left.setY( min< qreal>( r.top_left.y(), r.cp1.y()));
+    r.btm_right.setX( max< qreal>( r.btm_right.x(), r.cp1.x()));
+    r.btm_right.setY( max< qreal>( r.btm_right.y(), r.cp1.y()));
 
     /** Place cp2 */
-    if ( isNotNullP( next_succ))
+    if ( job.has_next_succ)
     {
-        QPointF p2 = mapFromItem( next_succ, next_succ->borderRect().center());
-        QLineF line( p2, srcCP);
+        QLineF line( job.next_succ, srcCP);
         QPointF cp2_offset = QPointF( (line.dx() * size)/ line.length(),
                                       (line.dy() * size)/ line.length());
-        cp2 = dstP + cp2_offset;
+        r.cp2 = r.dst + cp2_offset;
     } else
     {
         QPointF cp2_offset = QPointF( -(mainLine.dx() * size)/ mainLine.length(),
                                       -(mainLine.dy() * size)/ mainLine.length());
-        cp2 = dstP + cp2_offset;
+        r.cp2 = r.dst + cp2_offset;
     }
     
-    topLeft.setX( min< qreal>( topLeft.x(), cp2.x()));
-    topLeft.setY( min< qreal>( topLeft.y(), cp2.y()));
-    btmRight.setX( max< qreal>( btmRight.x(), cp2.x()));
-    btmRight.setY( max< qreal>( btmRight.y(), cp2.y()));
+    r.top_left.setX( min< qreal>( r.top_left.x(), r.cp2.x()));
+    r.top_left.setY( min< qreal>( r.top_left.y(), r.cp2.y()));
+    r.btm_right.setX( max< qreal>( r.btm_right.x(), r.cp2.x()));
+    r.btm_right.setY( max< qreal>( r.btm_right.y(), r.cp2.y()));
+    return r;
+}
 
+/**
+ * Take computed route, edge is hidden if the route is not visible
+ */
+void
+EdgeItem::setRoute( const EdgeRoute &r)
+{
+    prepareGeometryChange();
+    shape_width = -1;
+    if ( !r.visible)
+    {
+        setVisible( false);
+        return;
+    }
+    setVisible( true);
+    srcP = r.src;
+    cp1 = r.cp1;
+    cp2 = r.cp2;
+    dstP = r.dst;
+    topLeft = r.top_left;
+    btmRight = r.btm_right;
     update();
 }
 
+/**
+ * Adjust edge to the current positions of its nodes, route computed
+ * in background for previous positions is dropped
+ */
+void
+EdgeItem::adjust()
+{
+    edge()->graph()->view()->dropEdgeRoute( this);
+    setRoute( route( routeJob()));
+}
+
 QRectF 
 EdgeItem::boundingRect() const
 {
@@ -369,6 +443,10 @@ EdgeItem::boundingRect() const
            .adjusted(-extra, -extra, extra, extra);
 }
 
+/**
+ * Shape of edge is its path stroked a bit wider than the pen. Stroking is costly
+ * so the shape is kept until the edge is adjusted or the pen width changes
+ */
 QPainterPath 
 EdgeItem::shape() const
 {
@@ -378,6 +456,14 @@ EdgeItem::shape() const
     if ( srcP == dstP)
         return path;
     
+    qreal width = 2;
+    if ( isNotNullP( edge()->style()))
+    {
+        width = edge()->style()->pen().width() + 1;
+    }
+    if ( width == shape_width)
+        return shape_path;
+
     if ( edge()->isSelf())
     {
         path = selfEdgePath();
@@ -385,14 +471,10 @@ EdgeItem::shape() const
     {
         path.cubicTo( cp1, cp2, dstP);
     }
-    if ( isNotNullP( edge()->style()))
-    {
-        stroker.setWidth( edge()->style()->pen().width() + 1);
-    } else
-    {
-        stroker.setWidth( 2);
-    }
-    return stroker.createStroke( path); 
+    stroker.setWidth( width);
+    shape_path = stroker.createStroke( path);
+    shape_width = width;
+    return shape_path; 
 }
 
 void 
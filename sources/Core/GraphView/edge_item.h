@@ -32,6 +32,8 @@ class GEdge: public AuxEdge
 {
     /** Pointer to corresponding graphics item */
     EdgeItem *item_p;
+    /** Item that draws the chain of edges this one belongs to in edge chain mode */
+    EdgeChainItem *chain_p;
     /** Graphical appearance style */
     GStyle *_style;
 protected:
@@ -57,6 +59,16 @@ public:
     {
         return item_p;
     }
+    /** Get item of edge chain, NULL if edge is drawn by its own item */
+    inline EdgeChainItem *chainItem() const
+    {
+        return chain_p;
+    }
+    /** Set item of edge chain */
+    inline void setChainItem( EdgeChainItem *chain)
+    {
+        chain_p = chain;
+    }
     /** 
      * Update DOM element
      */
@@ -144,6 +156,72 @@ public:
     /** Make all styles the same across complex edge */
     void adjustStyles();
 };
+
+/**
+ * End node of edge as seen by edge routing, copied from node's item
+ * @ingroup GUIGraph
+ */
+struct EdgeRouteEnd
+{
+    /** Position of node's item in edge's coordinates */
+    QPointF pos;
+    /** Border rectangle of node in its item's coordinates */
+    QRectF border_rect;
+    /** Outline of simple node in its item's coordinates */
+    QPolygonF outline;
+    /** Whether node is visible */
+    bool visible;
+    /** Whether node is simple, edge is clipped by its outline then */
+    bool simple;
+    /** Whether node is edge label, edge ends at its left side then */
+    bool label;
+};
+
+/**
+ * Input of edge routing. It holds copies of everything route is computed from,
+ * so routes can be computed by worker threads that don't touch items
+ * @ingroup GUIGraph
+ */
+struct EdgeRouteJob
+{
+    /** Predecessor */
+    EdgeRouteEnd pred;
+    /** Successor */
+    EdgeRouteEnd succ;
+    /** Whether edge is a self edge */
+    bool self;
+    /** Whether predecessor is a control or label with a node before it */
+    bool has_next_pred;
+    /** Center of node before predecessor in edge's coordinates */
+    QPointF next_pred;
+    /** Whether successor is a control or label with a node after it */
+    bool has_next_succ;
+    /** Center of node after successor in edge's coordinates */
+    QPointF next_succ;
+};
+
+/**
+ * Route of edge: ends and control points of its spline
+ * @ingroup GUIGraph
+ */
+struct EdgeRoute
+{
+    /** Whether edge is shown, other fields are not computed for hidden edges */
+    bool visible;
+    /** Start point */
+    QPointF src;
+    /** First control point */
+    QPointF cp1;
+    /** Second control point */
+    QPointF cp2;
+    /** End point */
+    QPointF dst;
+    /** Top left corner of rectangle spanned by the points */
+    QPointF top_left;
+    /** Bottom right corner of rectangle spanned by the points */
+    QPointF btm_right;
+};
+
 /**
  * Graphics item for visualizing a graph edge
  * @ingroup GUIGraph
@@ -169,6 +247,10 @@ private:
     QPointF topLeft;
     QPointF btmRight;
     EdgeMode curr_mode;
+    /** Stroked path returned by shape(), it is built again after adjust() */
+    mutable QPainterPath shape_path;
+    /** Width of stroke of cached shape, negative when shape is not built */
+    mutable qreal shape_width;
 public:
     /** Type of graphics item for edge */
     enum {Type = TypeEdge};
@@ -181,6 +263,12 @@ public:
     }
     /** Adjust edge image */
     void adjust();
+    /** Copy data that route of edge is computed from */
+    EdgeRouteJob routeJob() const;
+    /** Compute route of edge, it is safe to call from any thread */
+    static EdgeRoute route( const EdgeRouteJob &job);
+    /** Take computed route */
+    void setRoute( const EdgeRoute &r);
     /** Get corresponding edge of the graph */
     inline GEdge* edge() const
     {
@@ -223,13 +311,7 @@ public:
         return edge()->succ();
     }
     /** Remove from scene */
-    inline void remove()
-    {
-        setVisible( false);
-        removeFromIndex();
-        scene()->removeItem( this);
-        edge_p = NULL;
-    }
+    void remove();
     /** Convenience routine for self edge path */
     QPainterPath selfEdgePath() const;
 };
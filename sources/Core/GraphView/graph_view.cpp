@@ -20,6 +20,7 @@ inline qreal scaleVal( qreal zoom_scale)
 GGraph::~GGraph()
 {
     freeMarker( nodeTextIsShown);
+    context_nodes.clear();
     for ( GNode *node = firstNode();
           isNotNullP( node);
           )
@@ -309,10 +310,13 @@ void GGraph::showWholeGraph()
 {
     assert( !view()->isContext());
     emptySelection();
+    context_nodes.clear();
+    folded = false;
     GNode* n;
     foreachNode( n, this)
     {
         n->item()->setVisible( true);
+        n->item()->setFolded( false);
         n->item()->setOpacityLevel( 1);
         n->setPriority( MAX_OPACITY);
         n->setForPlacement( true);
@@ -329,6 +333,7 @@ void GGraph::findContext()
         return;
     
     QQueue< GNode *> border;
+    QVector< GNode *> marked;
     Marker m = newMarker();
     foreach( GNode *n, sel_nodes)
     {
@@ -336,6 +341,7 @@ void GGraph::findContext()
         n->setPriority( MAX_PRIORITY);
         //n->setStable( true);
         border.enqueue( n);
+        marked.push_back( n);
     }
     for ( int i = 0; i < MAX_PLACE_LEN; i++)
     {
@@ -365,6 +371,7 @@ void GGraph::findContext()
                         pred->setPriority( 0);
                     }*/
                     border.enqueue( pred);
+                    marked.push_back( pred);
                 }
             }
             foreachSucc( e, n)
@@ -381,56 +388,51 @@ void GGraph::findContext()
                         succ->setPriority( 0);
                     }*/
                     border.enqueue( succ);
+                    marked.push_back( succ);
                 }
             }
         }
     }
     if ( view()->isContext())
     {
-        GNode* n;
-        foreachNode( n, this)
+        QVector< AuxNode *> context;
+        QVector< AuxNode *> kept;
+        QVector< GNode *> faded;
+        
+        /**
+         * Only nodes of previous context are visited, so the work doesn't depend on graph size.
+         * Nodes that are left out fade away, edge controls are shown again by showContextEdges()
+         */
+        foreach ( AuxNode *node, context_nodes)
         {
-            /*if ( n->item()->isVisible())
-            {
-                n->setStable();
-            }*/
-            if ( n->isMarked( m))
+            GNode *n = static_cast< GNode *>( node);
+
+            if ( n->isMarked( m) && !n->isEdgeControl())
+                continue;
+            if ( n->isEdgeControl() || n->priority() < MAX_PRIORITY)
             {
-                if ( !n->item()->isVisible())
-                {
-                    n->item()->setVisible( true);
-                    n->item()->setOpacityLevel( 0);
-                }
-                n->setForPlacement( true);
-            } else
+                n->setPriority( 0);
+                n->setForPlacement( false);
+                faded.push_back( n);
+            } else if ( n->isForPlacement())
             {
-                if ( n->priority() < MAX_PRIORITY)
-                {
-                    n->setPriority( 0);
-                    n->setForPlacement( false);
-                }
-                n->setStable( false);
+                kept.push_back( n);
             }
+            n->setStable( false);
         }
-        GEdge *e;
-        foreachEdge( e, this)
+        foreach ( GNode *n, marked)
         {
-            if ( e->pred()->isPseudo() && e->succ()->isPseudo())
+            if ( n->isEdgeControl())
+                continue;
+            if ( !n->item()->isVisible())
             {
-                if ( e->realPred()->item()->isVisible()
-                     && e->realSucc()->item()->isVisible())
-                {
-                    int priority = 
-                        min<int>( e->realPred()->priority(), e->realSucc()->priority());
-                    e->pred()->item()->setVisible( true);   
-                    e->succ()->item()->setVisible( true);   
-                    e->pred()->setForPlacement( true);
-                    e->succ()->setForPlacement( true);
-                    e->pred()->setPriority( priority);
-                    e->succ()->setPriority( priority);
-                }
+                n->item()->setVisible( true);
+                n->item()->setOpacityLevel( 0);
             }
+            n->setForPlacement( true);
+            context.push_back( n);
         }
+        context_nodes = context + kept;
         selectOneNode( sel_nodes.first());
     
         if ( view()->hasSmoothFocus())
@@ -438,14 +440,22 @@ void GGraph::findContext()
             view()->focusOnNode( sel_nodes.first(), true);
         }
         doLayout(); 
-        foreachNode( n, this)
+        foreach ( AuxNode *node, context_nodes)
         {
+            GNode *n = static_cast< GNode *>( node);
+
+            n->item()->setTargetPos( QPointF( n->modelX(), n->modelY()));
             if ( n->item()->isVisible() && !n->item()->opacityLevel())
             {
                 n->item()->setPos( n->modelX(), n->modelY());
             }
+            view()->animateNode( n->item());
+        }
+        /** Only nodes that enter or leave context are animated, the rest of graph is not visited */
+        foreach ( GNode *n, faded)
+        {
+            view()->animateNode( n->item());
         }
-        view()->startAnimationNodes();
     }
     freeMarker( m);
     
@@ -485,37 +495,37 @@ void GGraph::deleteEdgeWithControls( GEdge *edge)
 	
 }
 
+/**
+ * Position of node's item that corresponds to node's placement coordinates
+ */
+static QPointF placementPos( GNode *n)
+{
+    if ( !n->isEdgeControl())
+    {
+        return QPointF( n->modelX() + ( n->item()->borderRect().width() - n->item()->textRect().width()) / 2,
+                        n->modelY() + ( n->item()->borderRect().height() - n->item()->textRect().height()) / 2);
+    }
+    return QPointF( n->modelX() + n->item()->borderRect().width() / 2,
+                    n->modelY() + n->item()->borderRect().height() / 2);
+}
+
 void GGraph::UpdatePlacement()
 {
-	QGraphicsScene *scene = view()->scene();
-	
-	/**
-	 * Prevent BSP tree from being modified - significantly speeds up node positioning 
-	 * For this purpose tree depth is set to one and indexing is turned off
-	 */
-	int depth = scene->bspTreeDepth();
-    scene->setBspTreeDepth( 1);
-    scene->setItemIndexMethod( QGraphicsScene::NoIndex);
+    /** Item grid is rebuilt once when all nodes are placed instead of following each of them */
+    view()->freezeItemGrid();
+    /** Edges are routed together when all nodes are placed, not after each node move */
+    view()->deferEdgeRouting();
     GNode *n;
 	for ( n = firstNode();
           isNotNullP( n);
           n = n->nextNode())
     {
-        qreal x, y;
-        
-        if ( !n->isEdgeControl())
-        {
-            x = n->modelX() + ( n->item()->borderRect().width() - n->item()->textRect().width()) / 2;
-            y = n->modelY() + ( n->item()->borderRect().height() - n->item()->textRect().height()) / 2;
+        QPointF pos = placementPos( n);
 
-            //QString str = QString("DFS num %1").arg(n->order());
-            //n->item()->setPlainText(str);
-        } else
-        {
-            x = n->modelX() + n->item()->borderRect().width() / 2;
-            y = n->modelY() + n->item()->borderRect().height() / 2;
-        }
-        n->item()->setPos( x, y);
+        //QString str = QString("DFS num %1").arg(n->order());
+        //n->item()->setPlainText(str);
+        n->item()->setTargetPos( pos);
+        n->item()->setPos( pos);
     }
 
     GEdge *e;
@@ -528,9 +538,9 @@ void GGraph::UpdatePlacement()
     {
         e->item()->show();
     }
-	/** Restore indexing */
-	scene->setItemIndexMethod( QGraphicsScene::BspTreeIndex);
-    scene->setBspTreeDepth( depth); 
+    view()->updateEdgeChains();
+    view()->routeEdges();
+    view()->rebuildItemGrid();
 }
 /**
  * Run layout procedure
@@ -539,20 +549,29 @@ void GGraph::doLayout()
 {
     if ( view()->isContext())
     {
-        if ( rankingValid())
-        {
-            arrangeHorizontally();
-        } else
-        {
-            /** Run layout algorithm */
-	        AuxGraph::doLayout();
-            UpdatePlacement();
-        }
+        layoutContext();
+    } else if ( folded)
+    {
+        layoutFolded();
     } else
     {
         GNode *n;
         GEdge *e;
         
+        if ( layout_cache_enabled)
+        {
+            /** Skip layout if it was computed for the same graph before */
+            QByteArray key = LayoutCache::graphKey( this);
+            
+            if ( layout_cache.load( this, key))
+            {
+                UpdatePlacement();
+                centerOnRoot();
+                emit layoutDone();
+                return;
+            }
+            layout_key = key;
+        }
         foreachNode( n, this)
         {
             n->item()->hide();
@@ -575,15 +594,10 @@ void GGraph::doLayoutSingle()
 {
     if ( view()->isContext())
     {
-        if ( rankingValid())
-        {
-            arrangeHorizontally();
-        } else
-        {
-            /** Run layout algorithm */
-	        AuxGraph::doLayout();
-            UpdatePlacement();
-        }
+        layoutContext();
+    } else if ( folded)
+    {
+        layoutFolded();
     } else
     {
         GNode *n;
@@ -605,9 +619,234 @@ void GGraph::doLayoutSingle()
 
 void GGraph::layoutPostProcess()
 {
-    UpdatePlacement();
+    if ( isDeadlinePassed())
+    {
+        GEdge *e;
+        GNode *n;
+
+        /** Intermediate placement is shown, nodes move to final positions and new edge controls appear in place */
+        updateTargetPositions();
+        foreachNode( n, this)
+        {
+            if ( n->isEdgeControl())
+                n->item()->setPos( n->item()->targetPos());
+            n->item()->show();
+        }
+        foreachEdge( e, this)
+        {
+            e->item()->show();
+        }
+        view()->startAnimationNodes();
+    } else
+    {
+        UpdatePlacement();
+    }
     
-    /** Center view on root node */
+    /** Store result of layout started by doLayout unless it was cancelled */
+    if ( !layout_key.isEmpty())
+    {
+        if ( !isLayoutCancelled())
+            layout_cache.save( this, layout_key);
+        layout_key.clear();
+    }
+    /** View was centered when intermediate placement was shown, user might have moved it since */
+    if ( !isDeadlinePassed())
+        centerOnRoot();
+    layout_root = NULL;
+}
+
+/**
+ * Remember intermediate placement of anytime layout in items, animate it if it is shown
+ */
+void GGraph::layoutRefined()
+{
+    updateTargetPositions();
+    layout_root = static_cast< GNode *>( rootNode());
+    if ( isDeadlinePassed())
+        view()->startAnimationNodes();
+}
+
+/**
+ * Show last intermediate placement. Node coordinates are being changed by layout
+ * so items are placed by positions remembered in layoutRefined()
+ */
+void GGraph::layoutDeadlinePassed()
+{
+    GNode *n;
+    GEdge *e;
+
+    foreachNode( n, this)
+    {
+        n->item()->setPos( n->item()->targetPos());
+        n->item()->show();
+    }
+    foreachEdge( e, this)
+    {
+        e->item()->show();
+    }
+    if ( isNotNullP( layout_root))
+        view_p->centerOn( layout_root->item());
+}
+
+/**
+ * Set target positions of node items, animation moves items there
+ */
+void GGraph::updateTargetPositions()
+{
+    GNode *n;
+
+    foreachNode( n, this)
+    {
+        n->item()->setTargetPos( placementPos( n));
+    }
+}
+
+/**
+ * Width of edge control nodes, same as GNode::width() of control gives
+ */
+qreal GGraph::controlWidth() const
+{
+    return NodeItem::controlBorderRect().width();
+}
+
+/**
+ * Height of edge control nodes, same as GNode::height() of control gives
+ */
+qreal GGraph::controlHeight() const
+{
+    qreal adjust = 2;
+    return NodeItem::controlBorderRect().adjusted( -adjust, -adjust, adjust, adjust).height();
+}
+
+/**
+ * Check if new edge controls take part in placement
+ */
+bool GGraph::isControlForPlacement() const
+{
+    return !view()->isContext();
+}
+
+/**
+ * Lay out nodes of context. Layout works on a copy of context subgraph
+ * so browsing a big graph is as fast as browsing a small one
+ */
+void GGraph::layoutContext()
+{
+    QVector< AuxNodePair> edges;
+
+    if ( folded)
+        foldedEdges( edges);
+    AuxGraph::doLayoutSubgraph( context_nodes, edges);
+    showContextEdges();
+}
+
+/**
+ * Lay out nodes that are shown in folded graph. Like in context view only they take part
+ * in layout, folded nodes affect it through the edges given by foldedEdges()
+ */
+void GGraph::layoutFolded()
+{
+    layoutContext();
+    foreach ( AuxNode *node, context_nodes)
+    {
+        GNode *n = static_cast< GNode *>( node);
+
+        n->item()->setTargetPos( placementPos( n));
+        view()->animateNode( n->item());
+    }
+    emit layoutDone();
+}
+
+/**
+ * Get edges that stand for edges of folded nodes. Graph that folds its nodes should
+ * give an edge between the shown nodes that stand for the ends of each hidden edge
+ */
+void GGraph::foldedEdges( QVector< AuxNodePair> &edges)
+{
+
+}
+
+/**
+ * Unfold nodes that given node stands for. Graph itself doesn't fold nodes
+ */
+bool GGraph::expandNode( GNode *n)
+{
+    return false;
+}
+
+/**
+ * Show edge controls of edges between nodes of context. Controls become part of context
+ * and take visibility from the less visible end of the edge
+ */
+void GGraph::showContextEdges()
+{
+    Marker m = newMarker();
+    int num = context_nodes.size();
+
+    foreach ( AuxNode *node, context_nodes)
+    {
+        node->mark( m);
+    }
+    for ( int i = 0; i < num; i++)
+    {
+        GNode *n = static_cast< GNode *>( context_nodes[ i]);
+        GEdge *e;
+
+        if ( n->isEdgeControl())
+            continue;
+        foreachSucc( e, n)
+        {
+            QList< GNode *> controls;
+            GNode *succ = e->succ();
+
+            while ( succ->isEdgeControl())
+            {
+                controls << succ;
+                succ = succ->firstSucc()->succ();
+            }
+            if ( controls.isEmpty() || !succ->isMarked( m))
+                continue;
+
+            int priority = min<int>( n->priority(), succ->priority());
+            foreach ( GNode *control, controls)
+            {
+                if ( !control->item()->isVisible())
+                {
+                    control->item()->setVisible( true);
+                    control->item()->setOpacityLevel( 0);
+                }
+                control->setForPlacement( true);
+                control->setPriority( priority);
+                if ( control->mark( m))
+                    context_nodes.push_back( control);
+            }
+        }
+    }
+    freeMarker( m);
+}
+
+/**
+ * Put all nodes in context. Used when view switches to context mode so that
+ * the first context fades out all the nodes that are not in it
+ */
+void GGraph::resetContext()
+{
+    GNode *n;
+
+    context_nodes.clear();
+    folded = false;
+    foreachNode( n, this)
+    {
+        n->item()->setFolded( false);
+        context_nodes.push_back( n);
+    }
+}
+
+/**
+ * Center view on root node
+ */
+void GGraph::centerOnRoot()
+{
     GNode *root = static_cast<GNode*>( rootNode());
     if ( isNotNullP( root))
     {
@@ -624,14 +863,40 @@ GraphView::GraphView():
     view_history( new GraphViewHistory),
     timer_id( 0),
     node_animation_timer( 0),
+    animated_nodes(),
+    animation_clock(),
     smooth_focus( false),
     editable( false),
     view_mode( WHOLE_GRAPH_VIEW),
     style_edit_info( NULL),
-    helper( new EdgeHelper)
+    helper( new EdgeHelper),
+    virtual_scene( false),
+    item_grid(),
+    item_grid_frozen( false),
+    attached_items(),
+    attached_rect(),
+    rubber_band( NULL),
+    rubber_band_origin(),
+    tile_cache( NULL),
+    tiles_complete( false),
+    image_export( NULL),
+    text_index( NULL),
+    overview( false),
+    overview_dirty( true),
+    overview_nodes(),
+    overview_edges(),
+    edge_chains( false),
+    chain_items(),
+    edge_routing_deferred( false),
+    route_watcher( NULL),
+    routed_edges()
 {
     QGraphicsScene *scene = new QGraphicsScene( this);
-    //scene->setItemIndexMethod( QGraphicsScene::NoIndex);
+    /**
+     * Scene keeps its BSP tree for painting and item queries while it has all items,
+     * it is switched off in virtual scene mode and while placement moves all items
+     */
+    scene->setItemIndexMethod( QGraphicsScene::BspTreeIndex);
     //scene->setSceneRect(0, 0, 10000, 10000);
     setScene( scene);
     //setCacheMode( CacheBackground);
@@ -650,27 +915,95 @@ GraphView::GraphView():
 	show_menus = true;
 	setAcceptDrops( false);
     scene->addItem( helper);
+    rubber_band = new QRubberBand( QRubberBand::Rectangle, viewport());
+    text_index = new TextIndex( this);
 }
 
 /** Destructor */
 GraphView::~GraphView()
 {
-    scene()->setItemIndexMethod( QGraphicsScene::NoIndex);
+    cancelEdgeRouting();
+    delete image_export;
+    delete tile_cache;
     delete graph_p;
+    delete text_index;
     delete view_history;
     delete helper;
 }
 
+/**
+ * Start animation for all nodes whose position or opacity differ from their targets.
+ * Graph is scanned once, animation steps visit moving nodes only
+ */
 void GraphView::startAnimationNodes()
 {
+    GNode *n;
+
+    foreachNode( n, graph())
+    {
+        if ( n->item()->isAnimated())
+            animateNode( n->item());
+    }
+}
+
+/**
+ * Start animation of given node
+ */
+void GraphView::animateNode( NodeItem *item)
+{
+    if ( !item->isAnimated())
+        return;
+    animated_nodes.insert( item);
     if ( !node_animation_timer)
-         node_animation_timer = startTimer(1000/25);
+    {
+         node_animation_timer = startTimer( NODE_ANIMATION_INTERVAL);
+         animation_clock.start();
+    }
 }
 
 void 
 GraphView::drawBackground(QPainter *painter, const QRectF &rect)
 {
+    if ( isOverviewShown())
+    {
+        tiles_complete = false;
+        drawOverview( painter);
+        return;
+    }
+    tiles_complete = isNotNullP( tile_cache)
+                     && tile_cache->draw( painter, rect, transform().m11());
+}
+
+/**
+ * Draw items. When tiles covered the painted part of scene or graph is drawn
+ * in overview mode only items that are not in tiles are painted
+ */
+void
+GraphView::drawItems( QPainter *painter, int numItems,
+                      QGraphicsItem *items[], const QStyleOptionGraphicsItem options[])
+{
+    if ( !tiles_complete && !isOverviewShown())
+    {
+        QGraphicsView::drawItems( painter, numItems, items, options);
+        return;
+    }
 
+    QVector< QGraphicsItem *> live_items;
+    QVector< QStyleOptionGraphicsItem> live_options;
+
+    for ( int i = 0; i < numItems; i++)
+    {
+        if ( !isTileItem( items[ i]))
+        {
+            live_items << items[ i];
+            live_options << options[ i];
+        }
+    }
+    if ( !live_items.isEmpty())
+    {
+        QGraphicsView::drawItems( painter, live_items.size(),
+                                  live_items.data(), live_options.data());
+    }
 }
 
 void 
@@ -680,7 +1013,7 @@ GraphView::mouseDoubleClickEvent(QMouseEvent *ev)
     if( ev->button() & Qt::LeftButton)
     {
         QPoint p = ev->pos();
-        if ( isEditable() && !scene()->itemAt( mapToScene( ev->pos())))
+        if ( isEditable() && !graphItemAt( mapToScene( ev->pos())))
         {
             GNode* node = graph()->newNode();
             QString text = QString("Node %1").arg( node->id());
@@ -690,7 +1023,7 @@ GraphView::mouseDoubleClickEvent(QMouseEvent *ev)
     } else if( isEditable() 
                && ev->button() & Qt::RightButton)
     {
-        QGraphicsItem *node = scene()->itemAt( mapToScene( ev->pos()));
+        QGraphicsItem *node = graphItemAt( mapToScene( ev->pos()));
         if ( isNotNullP( node) && qgraphicsitem_cast<NodeItem *>( node))
         {
             graph()->emptySelection();
@@ -708,6 +1041,16 @@ GraphView::mousePressEvent(QMouseEvent *ev)
         killTimer( timer_id);
         timer_id = 0;
     }
+    /** Ctrl + drag on empty space selects nodes by rubber band instead of scrolling */
+    if ( ev->button() == Qt::LeftButton
+         && ( ev->modifiers() & Qt::ControlModifier)
+         && !graphItemAt( mapToScene( ev->pos())))
+    {
+        rubber_band_origin = ev->pos();
+        rubber_band->setGeometry( QRect( rubber_band_origin, QSize()));
+        rubber_band->show();
+        return;
+    }
     QGraphicsView::mousePressEvent( ev);
 }
 
@@ -738,11 +1081,17 @@ GraphView::contextMenuEvent( QContextMenuEvent * e)
 void
 GraphView::mouseReleaseEvent( QMouseEvent *ev)
 {
+    if ( rubber_band->isVisible() && ( ev->button() & Qt::LeftButton))
+    {
+        rubber_band->hide();
+        selectNodesInRect( mapToScene( rubber_band->geometry()).boundingRect());
+        return;
+    }
     if( ev->button() & Qt::RightButton)
     {
         if ( createEdge)
         {
-            QGraphicsItem* item = scene()->itemAt( mapToScene( ev->pos()));
+            QGraphicsItem* item = graphItemAt( mapToScene( ev->pos()));
             if ( isNotNullP( item) && qgraphicsitem_cast<NodeItem *>(item))
             {
                 if ( tmpSrc != qgraphicsitem_cast<NodeItem *>(item)->node())
@@ -755,7 +1104,7 @@ GraphView::mouseReleaseEvent( QMouseEvent *ev)
                     }
 				}
             }
-        } else if ( !scene()->itemAt( mapToScene( ev->pos())))
+        } else if ( !graphItemAt( mapToScene( ev->pos())))
         {
             QMenu *menu = new QMenu( tr( "&View Menu"));
             menu->addAction( editableSwitchAct);
@@ -775,9 +1124,14 @@ GraphView::mouseReleaseEvent( QMouseEvent *ev)
 void
 GraphView::mouseMoveEvent(QMouseEvent *ev)
 {
+    if ( rubber_band->isVisible())
+    {
+        rubber_band->setGeometry( QRect( rubber_band_origin, ev->pos()).normalized());
+        return;
+    }
     if ( createEdge)
     {
-        QGraphicsItem* item = scene()->itemAt( mapToScene( ev->pos()));
+        QGraphicsItem* item = graphItemAt( mapToScene( ev->pos()));
         if ( isNotNullP( item))
         {
             NodeItem *node_item = qgraphicsitem_cast<NodeItem *>(item);
@@ -874,15 +1228,41 @@ void GraphView::updateMatrix()
      {
          setMatrix( scale);
      }
-     
+     updateVirtualScene();
+     /** Folded nodes open up when user zooms in on them */
+     if ( scale_ratio > 1 && scale_val >= FOLD_EXPAND_SCALE && graph()->isFolded())
+         expandFoldedInView();
+}
+
+/**
+ * Expand folded nodes whose items are in view and lay out the graph if there were any.
+ * Items are looked up in item grid, scene doesn't index them
+ */
+void GraphView::expandFoldedInView()
+{
+    bool expanded = false;
+    QRectF view_rect = mapToScene( viewport()->rect()).boundingRect();
+
+    foreach ( QGraphicsItem *item, item_grid.items( view_rect))
+    {
+        NodeItem *node_item = qgraphicsitem_cast< NodeItem *>( item);
+
+        if ( isNotNullP( node_item)
+             && isNotNullP( node_item->node())
+             && view_rect.intersects( node_item->sceneBoundingRect())
+             && node_item->isVisible()
+             && graph()->expandNode( node_item->node()))
+        {
+            expanded = true;
+        }
+    }
+    if ( expanded)
+        graph()->doLayout();
 }
 
 void
 GraphView::deleteItems()
 {
-    int depth = scene()->bspTreeDepth();
-    scene()->setBspTreeDepth( 1);
-    scene()->setItemIndexMethod( QGraphicsScene::NoIndex);
     foreach ( NodeItem* item, del_node_items)
     {
         del_node_items.removeAll( item);  
@@ -893,39 +1273,813 @@ GraphView::deleteItems()
         del_edge_items.removeAll( item);  
         delete item;  
     }
-    scene()->setItemIndexMethod( QGraphicsScene::BspTreeIndex);
-    scene()->setBspTreeDepth( depth);
 }
 
-void GraphView::deleteSelected()
+/**
+ * Scene follows viewport in virtual scene mode
+ */
+void
+GraphView::scrollContentsBy( int dx, int dy)
 {
-    graph()->deleteNodes();
-	graph()->deleteEdges();
+    QGraphicsView::scrollContentsBy( dx, dy);
+    updateVirtualScene();
 }
 
-void GraphView::createSESelected()
+/**
+ * Scene follows viewport in virtual scene mode
+ */
+void
+GraphView::resizeEvent( QResizeEvent *event)
 {
-    graph()->createSelfEdge();
+    QGraphicsView::resizeEvent( event);
+    updateVirtualScene();
 }
 
-void GraphView::createEdgeLabel()
+/**
+ * Get rectangle of item in grid. Edge is registered with the rectangle of its end nodes
+ * as its own geometry is not updated until it is adjusted, margins cover self edge loops
+ */
+QRectF
+GraphView::gridRect( QGraphicsItem *item) const
 {
-    graph()->createEdgeLabel( curr_pos);
-}
+    EdgeItem *edge_item = qgraphicsitem_cast< EdgeItem *>( item);
 
-void GraphView::showEdgePred()
-{
-    graph()->showEdgePred();
-}
+    if ( isNotNullP( edge_item))
+    {
+        GEdge *edge = edge_item->edge();
 
-void GraphView::showEdgeSucc()
-{
-    graph()->showEdgeSucc();
+        return edge->pred()->item()->sceneBoundingRect()
+               .united( edge->succ()->item()->sceneBoundingRect())
+               .adjusted( -SE_HOR_MARGIN, -SE_VERT_MARGIN, SE_HOR_MARGIN, SE_VERT_MARGIN);
+    }
+    return item->sceneBoundingRect();
 }
 
-void GraphView::findContext()
-{
-    graph()->findContext();
+/**
+ * Update rectangle of item in grid, in virtual scene mode item is put in scene if it moves
+ * near viewport. Items that move away stay in scene until viewport changes
+ */
+void
+GraphView::moveGridItem( QGraphicsItem *item)
+{
+    if ( !item_grid.contains( item))
+        return;
+
+    QRectF rect = gridRect( item);
+
+    item_grid.move( item, rect);
+    if ( !virtual_scene)
+        return;
+    if ( !scene()->sceneRect().contains( rect))
+        scene()->setSceneRect( scene()->sceneRect().united( rect));
+    if ( !attached_items.contains( item) && attached_rect.intersects( rect))
+    {
+        scene()->addItem( item);
+        attached_items.insert( item);
+    }
+}
+
+/**
+ * Set virtual scene mode. Items of graph are taken out of scene and updateVirtualScene()
+ * puts the ones near viewport back. Scene rectangle is set to the one of item grid
+ * as scene doesn't know the extent of graph in this mode
+ */
+void
+GraphView::setVirtualScene( bool virt)
+{
+    if ( virtual_scene == virt)
+        return;
+    virtual_scene = virt;
+    attached_items.clear();
+    attached_rect = QRectF();
+    /** Items near viewport are found in item grid, scene that has all items indexes them itself */
+    scene()->setItemIndexMethod( virt ? QGraphicsScene::NoIndex : QGraphicsScene::BspTreeIndex);
+    if ( isNullP( graph_p))
+        return;
+
+    if ( virt)
+    {
+        foreach ( QGraphicsItem *item, graphItems())
+        {
+            if ( isNotNullP( item->scene()))
+                scene()->removeItem( item);
+        }
+        scene()->setSceneRect( item_grid.boundingRect());
+        updateVirtualScene();
+    } else
+    {
+        foreach ( QGraphicsItem *item, graphItems())
+        {
+            if ( isNullP( item->scene()))
+                scene()->addItem( item);
+        }
+        /** Scene computes its rectangle from items again */
+        scene()->setSceneRect( QRectF());
+    }
+}
+
+/**
+ * Toggle virtual scene mode
+ */
+void GraphView::toggleVirtualScene( bool virt)
+{
+    setVirtualScene( virt);
+}
+
+/**
+ * Register new graph item in item grid and put it to scene.
+ * In virtual scene mode item gets to scene only if it is near viewport
+ */
+void
+GraphView::addGraphItem( QGraphicsItem *item)
+{
+    QRectF rect = gridRect( item);
+
+    invalidateOverview();
+
+    item_grid.insert( item, rect);
+    if ( !virtual_scene)
+    {
+        scene()->addItem( item);
+        return;
+    }
+    if ( !scene()->sceneRect().contains( rect))
+        scene()->setSceneRect( scene()->sceneRect().united( rect));
+    if ( attached_rect.intersects( rect))
+    {
+        scene()->addItem( item);
+        attached_items.insert( item);
+    }
+}
+
+/**
+ * Remove graph item from scene and item grid
+ */
+void
+GraphView::removeGraphItem( QGraphicsItem *item)
+{
+    invalidateOverview();
+    item_grid.remove( item);
+    attached_items.remove( item);
+    if ( isNotNullP( tile_cache))
+        tile_cache->removeItem( item);
+    if ( isNotNullP( item->scene()))
+        scene()->removeItem( item);
+}
+
+/**
+ * Update node's and its edges' rectangles in item grid when node moves
+ */
+void
+GraphView::itemMoved( NodeItem *item)
+{
+    invalidateOverview();
+    if ( item_grid_frozen || !item_grid.contains( item))
+        return;
+
+    GEdge *edge;
+
+    moveGridItem( item);
+    for ( edge = item->node()->firstSucc(); isNotNullP( edge); edge = edge->nextSucc())
+    {
+        if ( isNotNullP( edge->chainItem()))
+            moveGridItem( edge->chainItem());
+        else
+            moveGridItem( edge->item());
+    }
+    for ( edge = item->node()->firstPred(); isNotNullP( edge); edge = edge->nextPred())
+    {
+        if ( isNotNullP( edge->chainItem()))
+            moveGridItem( edge->chainItem());
+        else
+            moveGridItem( edge->item());
+    }
+}
+
+/**
+ * Register all graph items in item grid anew and resume its updates on item moves.
+ * In virtual scene mode items near viewport are attached again
+ */
+void
+GraphView::rebuildItemGrid()
+{
+    item_grid_frozen = false;
+    if ( !virtual_scene)
+        scene()->setItemIndexMethod( QGraphicsScene::BspTreeIndex);
+    item_grid.clear();
+    invalidateOverview();
+    if ( isNullP( graph_p))
+        return;
+
+    foreach ( QGraphicsItem *item, graphItems())
+    {
+        item_grid.insert( item, gridRect( item));
+    }
+    if ( virtual_scene)
+    {
+        scene()->setSceneRect( item_grid.boundingRect());
+        attached_rect = QRectF();
+        updateVirtualScene();
+    }
+}
+
+/**
+ * Get topmost visible graph item at given point of scene. Unlike QGraphicsScene::itemAt
+ * it looks through item grid, so it works in virtual scene mode as well and
+ * doesn't see helper items such as the edge under construction
+ */
+QGraphicsItem *
+GraphView::graphItemAt( const QPointF &pos) const
+{
+    QGraphicsItem *res = NULL;
+
+    foreach ( QGraphicsItem *item, item_grid.items( QRectF( pos, QSizeF( 0, 0))))
+    {
+        if ( !item->isVisible()
+             || !item->contains( item->mapFromScene( pos)))
+        {
+            continue;
+        }
+        if ( isNullP( res) || item->zValue() > res->zValue())
+            res = item;
+    }
+    return res;
+}
+
+/**
+ * Compare nodes by id
+ */
+static bool nodeIdLessThan( GNode *n1, GNode *n2)
+{
+    return n1->id() < n2->id();
+}
+
+/**
+ * Select simple nodes that are entirely inside given rectangle of scene.
+ * Selected nodes are ordered by id so that the first one doesn't depend on item grid
+ */
+void
+GraphView::selectNodesInRect( const QRectF &rect)
+{
+    QList< GNode *> nodes;
+
+    foreach ( QGraphicsItem *item, item_grid.items( rect))
+    {
+        NodeItem *node_item = qgraphicsitem_cast< NodeItem *>( item);
+
+        if ( isNotNullP( node_item)
+             && node_item->isVisible()
+             && node_item->node()->isSimple()
+             && rect.contains( node_item->sceneBoundingRect()))
+        {
+            nodes << node_item->node();
+        }
+    }
+    qSort( nodes.begin(), nodes.end(), nodeIdLessThan);
+    graph()->emptySelection();
+    foreach ( GNode *n, nodes)
+    {
+        graph()->selectNode( n);
+        n->item()->highlight();
+    }
+}
+
+/**
+ * Put items near viewport to scene and take away others in virtual scene mode.
+ * Items are kept for a margin around viewport so that nothing is done
+ * until viewport leaves the attached part of scene. Item grabbed by mouse is kept in scene
+ */
+void
+GraphView::updateVirtualScene()
+{
+    if ( !virtual_scene)
+        return;
+
+    /** Overview is drawn without items, scene is left empty */
+    if ( isOverviewShown())
+    {
+        foreach ( QGraphicsItem *item, attached_items)
+        {
+            scene()->removeItem( item);
+        }
+        attached_items.clear();
+        attached_rect = QRectF();
+        return;
+    }
+
+    QRectF view_rect = mapToScene( viewport()->rect()).boundingRect();
+
+    if ( attached_rect.contains( view_rect))
+        return;
+
+    attached_rect = view_rect.adjusted( -view_rect.width() * VIRTUAL_SCENE_MARGIN,
+                                        -view_rect.height() * VIRTUAL_SCENE_MARGIN,
+                                        view_rect.width() * VIRTUAL_SCENE_MARGIN,
+                                        view_rect.height() * VIRTUAL_SCENE_MARGIN);
+
+    QSet< QGraphicsItem *> near_items = item_grid.items( attached_rect).toSet();
+    QGraphicsItem *grabber = scene()->mouseGrabberItem();
+
+    if ( isNotNullP( grabber) && attached_items.contains( grabber))
+        near_items.insert( grabber);
+    foreach ( QGraphicsItem *item, attached_items)
+    {
+        if ( !near_items.contains( item))
+            scene()->removeItem( item);
+    }
+    foreach ( QGraphicsItem *item, near_items)
+    {
+        if ( !attached_items.contains( item))
+            scene()->addItem( item);
+    }
+    attached_items = near_items;
+}
+
+/**
+ * Set rendering of scene into cached tiles. Items are then drawn by drawItems(),
+ * so that those in tiles can be skipped, and scene reports changed regions
+ */
+void
+GraphView::setTileCache( bool tiles)
+{
+    if ( isTileCache() == tiles)
+        return;
+    if ( tiles)
+    {
+        tile_cache = new TileCache( this);
+        connect( scene(), SIGNAL( changed( const QList< QRectF> &)),
+                 this, SLOT( sceneChanged( const QList< QRectF> &)));
+    } else
+    {
+        disconnect( scene(), SIGNAL( changed( const QList< QRectF> &)),
+                    this, SLOT( sceneChanged( const QList< QRectF> &)));
+        delete tile_cache;
+        tile_cache = NULL;
+        tiles_complete = false;
+    }
+    setOptimizationFlag( IndirectPainting, tiles || overview);
+    viewport()->update();
+}
+
+/**
+ * Toggle rendering of scene into cached tiles
+ */
+void GraphView::toggleTileCache( bool tiles)
+{
+    setTileCache( tiles);
+}
+
+/**
+ * Drop tiles in changed parts of scene
+ */
+void
+GraphView::sceneChanged( const QList< QRectF> &region)
+{
+    if ( isNullP( tile_cache))
+        return;
+    foreach ( QRectF rect, region)
+    {
+        tile_cache->invalidate( rect);
+    }
+}
+
+/**
+ * Take rendered tiles
+ */
+void
+GraphView::tileRendered()
+{
+    if ( isNotNullP( tile_cache))
+        tile_cache->finishJobs();
+}
+
+/**
+ * Start export of visible items to image file in background
+ */
+void
+GraphView::startImageExport( const QString &file_name, qreal scale, qreal margin)
+{
+    if ( isNotNullP( image_export))
+    {
+        emit imageExported( false, tr( "Image export is in progress"));
+        return;
+    }
+    image_export = new ImageExport( this, file_name, scale, margin);
+    if ( !image_export->start())
+    {
+        QString error = image_export->errorString();
+
+        delete image_export;
+        image_export = NULL;
+        emit imageExported( false, error);
+    }
+}
+
+/**
+ * Write rendered band of exported image and start the next one
+ */
+void
+GraphView::imageBandRendered()
+{
+    if ( isNullP( image_export))
+        return;
+
+    if ( image_export->bandRendered())
+    {
+        emit imageExportProgress( image_export->bandsDone(), image_export->bandNum());
+        return;
+    }
+
+    QString error = image_export->errorString();
+
+    delete image_export;
+    image_export = NULL;
+    emit imageExported( error.isEmpty(), error);
+}
+
+/**
+ * Check if item is painted into tiles. Nodes and edges are, unless they are dragged
+ * or edited, as they change on every event then. Helper items are always painted directly
+ */
+bool
+GraphView::isTileItem( QGraphicsItem *item) const
+{
+    if ( item == scene()->mouseGrabberItem())
+        return false;
+
+    NodeItem *node_item = qgraphicsitem_cast< NodeItem *>( item);
+
+    if ( isNotNullP( node_item))
+        return !node_item->isEditing();
+    return isNotNullP( qgraphicsitem_cast< EdgeItem *>( item))
+           || isNotNullP( qgraphicsitem_cast< EdgeChainItem *>( item));
+}
+
+/**
+ * Enable overview mode. Items are then drawn by drawItems() so that they can be skipped
+ */
+void
+GraphView::setOverview( bool ov)
+{
+    if ( overview == ov)
+        return;
+    overview = ov;
+    overview_dirty = true;
+    setOptimizationFlag( IndirectPainting, overview || isTileCache());
+    updateVirtualScene();
+    viewport()->update();
+}
+
+/**
+ * Toggle overview mode
+ */
+void GraphView::toggleOverview( bool ov)
+{
+    setOverview( ov);
+}
+
+/**
+ * Mark overview arrays as outdated. Items may be out of scene in overview,
+ * so viewport is updated here and not by scene
+ */
+void
+GraphView::invalidateOverview()
+{
+    overview_dirty = true;
+    if ( isOverviewShown())
+        viewport()->update();
+}
+
+/**
+ * Fill overview arrays from items. Edge is a line between centers of its ends,
+ * so chains of edge controls make polylines. Edge controls themselves are not drawn
+ */
+void
+GraphView::updateOverview()
+{
+    overview_dirty = false;
+    overview_nodes.clear();
+    overview_edges.clear();
+    if ( isNullP( graph_p))
+        return;
+
+    GNode *n;
+    GEdge *e;
+
+    foreachNode( n, graph())
+    {
+        NodeItem *item = n->item();
+
+        if ( item->isVisible() && !n->isEdgeControl())
+            overview_nodes << item->borderRect().translated( item->pos());
+    }
+    foreachEdge( e, graph())
+    {
+        if ( !e->item()->isVisible())
+            continue;
+
+        NodeItem *pred = e->pred()->item();
+        NodeItem *succ = e->succ()->item();
+
+        overview_edges << pred->pos() + pred->borderRect().center()
+                       << succ->pos() + succ->borderRect().center();
+    }
+}
+
+/**
+ * Draw graph from overview arrays in two batched calls, edges go first so that nodes cover them
+ */
+void
+GraphView::drawOverview( QPainter *painter)
+{
+    if ( overview_dirty)
+        updateOverview();
+
+    painter->save();
+    painter->setRenderHint( QPainter::Antialiasing, false);
+    painter->setPen( QPen( palette().color( QPalette::Dark), 0));
+    painter->drawLines( overview_edges);
+    painter->setPen( QPen( palette().color( QPalette::WindowText), 0));
+    painter->setBrush( palette().color( QPalette::Base));
+    painter->drawRects( overview_nodes);
+    painter->restore();
+}
+
+/**
+ * Get items that represent graph in scene: nodes, edges and edge chains.
+ * Edges and controls that belong to chains are not included
+ */
+QList< QGraphicsItem *>
+GraphView::graphItems() const
+{
+    QList< QGraphicsItem *> items;
+    GNode *n;
+    GEdge *e;
+
+    foreachNode( n, graph())
+    {
+        if ( !n->isEdgeControl()
+             || isNullP( n->firstSucc())
+             || isNullP( n->firstSucc()->chainItem()))
+        {
+            items << n->item();
+        }
+    }
+    foreachEdge( e, graph())
+    {
+        if ( isNullP( e->chainItem()))
+            items << e->item();
+    }
+    foreach ( EdgeChainItem *chain, chain_items)
+    {
+        items << chain;
+    }
+    return items;
+}
+
+/**
+ * Set edge chain mode
+ */
+void
+GraphView::setEdgeChains( bool chains)
+{
+    if ( edge_chains == chains)
+        return;
+    edge_chains = chains;
+    updateEdgeChains();
+}
+
+/**
+ * Toggle edge chain mode
+ */
+void GraphView::toggleEdgeChains( bool chains)
+{
+    setEdgeChains( chains);
+}
+
+/**
+ * Build chain items for the current edge controls. Old chains are dropped, a chain starts
+ * at an edge from a node that is not a control to a control. Edges and controls
+ * that are left out of chains are put back to scene
+ */
+void
+GraphView::updateEdgeChains()
+{
+    foreach ( EdgeChainItem *chain, chain_items)
+    {
+        foreach ( GEdge *e, chain->edges())
+        {
+            e->setChainItem( NULL);
+        }
+        removeGraphItem( chain);
+        delete chain;
+    }
+    chain_items.clear();
+    if ( isNullP( graph_p))
+        return;
+
+    GNode *n;
+    GEdge *e;
+
+    if ( edge_chains)
+    {
+        foreachEdge( e, graph())
+        {
+            if ( e->pred()->isEdgeControl() || !e->succ()->isEdgeControl())
+                continue;
+
+            EdgeChainItem *chain = new EdgeChainItem( e);
+
+            foreach ( GEdge *chain_edge, chain->edges())
+            {
+                chain_edge->setChainItem( chain);
+                removeGraphItem( chain_edge->item());
+                if ( chain_edge != chain->lastEdge())
+                    removeGraphItem( chain_edge->succ()->item());
+            }
+            chain->adjust();
+            addGraphItem( chain);
+            chain_items << chain;
+        }
+    }
+    foreachNode( n, graph())
+    {
+        if ( !item_grid.contains( n->item())
+             && ( !n->isEdgeControl()
+                  || isNullP( n->firstSucc())
+                  || isNullP( n->firstSucc()->chainItem())))
+        {
+            addGraphItem( n->item());
+        }
+    }
+    foreachEdge( e, graph())
+    {
+        if ( !item_grid.contains( e->item()) && isNullP( e->chainItem()))
+        {
+            addGraphItem( e->item());
+            if ( !edge_routing_deferred)
+                e->item()->adjust();
+        }
+    }
+}
+
+/**
+ * Compute routes of all edges that are not drawn by chain items. Data of routes
+ * is copied from items first, then routes are computed by worker threads and
+ * edgesRouted() gives them to edges in one pass, GUI thread doesn't wait for them.
+ * Each route depends on its own job only, so the result doesn't depend on number of threads.
+ * Edges that are adjusted or removed meanwhile don't get their routes. A few edges
+ * are routed at once
+ */
+void
+GraphView::routeEdges()
+{
+    edge_routing_deferred = false;
+    cancelEdgeRouting();
+    if ( isNullP( graph_p))
+        return;
+
+    QVector< EdgeItem *> items;
+    QVector< EdgeRouteJob> jobs;
+    GEdge *e;
+
+    foreachEdge( e, graph())
+    {
+        if ( isNotNullP( e->chainItem()))
+            continue;
+        items.push_back( e->item());
+        jobs.push_back( e->item()->routeJob());
+    }
+    if ( jobs.size() < EDGE_ROUTING_PARALLEL_MIN_EDGES)
+    {
+        for ( int i = 0; i < items.size(); i++)
+        {
+            items[ i]->setRoute( EdgeItem::route( jobs[ i]));
+        }
+        return;
+    }
+    routed_edges.reserve( items.size());
+    for ( int i = 0; i < items.size(); i++)
+    {
+        routed_edges.insert( items[ i], i);
+    }
+    route_watcher = new QFutureWatcher< EdgeRoute>();
+    connect( route_watcher, SIGNAL( finished()), this, SLOT( edgesRouted()));
+    route_watcher->setFuture( QtConcurrent::mapped( jobs, EdgeItem::route));
+}
+
+/**
+ * Give edges routes computed in background. Signal of cancelled routing
+ * can come after a new one is started, it is ignored then
+ */
+void
+GraphView::edgesRouted()
+{
+    if ( sender() == route_watcher)
+        finishEdgeRouting();
+}
+
+/**
+ * Wait for routes computed in background and give them to edges that still wait for them.
+ * Edges that got into chain items meanwhile are drawn by chains and are skipped
+ */
+void
+GraphView::finishEdgeRouting()
+{
+    if ( isNullP( route_watcher))
+        return;
+
+    route_watcher->waitForFinished();
+
+    QFuture< EdgeRoute> future = route_watcher->future();
+
+    route_watcher->deleteLater();
+    route_watcher = NULL;
+    for ( QHash< EdgeItem *, int>::const_iterator it = routed_edges.constBegin();
+          it != routed_edges.constEnd();
+          ++it)
+    {
+        if ( isNullP( it.key()->edge()->chainItem()))
+            it.key()->setRoute( future.resultAt( it.value()));
+    }
+    routed_edges.clear();
+}
+
+/**
+ * Drop routing in background, edges keep their current routes
+ */
+void
+GraphView::cancelEdgeRouting()
+{
+    if ( isNotNullP( route_watcher))
+    {
+        route_watcher->cancel();
+        route_watcher->waitForFinished();
+        route_watcher->deleteLater();
+        route_watcher = NULL;
+    }
+    routed_edges.clear();
+}
+
+/**
+ * Remove chain item and put its remaining parts back to scene,
+ * called when an edge of chain is deleted. Parts that are being deleted are skipped
+ */
+void
+GraphView::removeEdgeChain( EdgeChainItem *chain)
+{
+    foreach ( GEdge *e, chain->edges())
+    {
+        e->setChainItem( NULL);
+    }
+    foreach ( GEdge *e, chain->edges())
+    {
+        if ( isNotNullP( e->item()->edge()) && !item_grid.contains( e->item()))
+        {
+            addGraphItem( e->item());
+            e->item()->adjust();
+        }
+        if ( e != chain->lastEdge()
+             && isNotNullP( e->succ()->item()->node())
+             && !item_grid.contains( e->succ()->item()))
+        {
+            addGraphItem( e->succ()->item());
+        }
+    }
+    chain_items.removeOne( chain);
+    removeGraphItem( chain);
+    delete chain;
+}
+
+void GraphView::deleteSelected()
+{
+    graph()->deleteNodes();
+	graph()->deleteEdges();
+}
+
+void GraphView::createSESelected()
+{
+    graph()->createSelfEdge();
+}
+
+void GraphView::createEdgeLabel()
+{
+    graph()->createEdgeLabel( curr_pos);
+}
+
+void GraphView::showEdgePred()
+{
+    graph()->showEdgePred();
+}
+
+void GraphView::showEdgeSucc()
+{
+    graph()->showEdgeSucc();
+}
+
+void GraphView::findContext()
+{
+    graph()->findContext();
 }
 
 /** Show text of the clicked node */
@@ -1068,16 +2222,45 @@ void GraphView::dragMoveEvent( QDragMoveEvent *event)
 	//event->acceptProposedAction();
 }
 
+/**
+ * Advance animated nodes by the time passed since the previous step. Nodes that
+ * reached their targets leave the animation. Edges of moved nodes are adjusted
+ * once per step after all nodes are advanced
+ */
 void GraphView::advanceNodes()
 {
-    GNode *n;
-    bool advanced = false;
-    foreachNode( n, graph())
+    qreal intervals = ( qreal)animation_clock.restart() / NODE_ANIMATION_INTERVAL;
+    QList< NodeItem *> stopped;
+    QSet< EdgeItem *> edges;
+    QSet< EdgeChainItem *> chains;
+
+    /** Node's own adjustment of edges on move is turned off while nodes advance */
+    bool deferred = edge_routing_deferred;
+    edge_routing_deferred = true;
+    foreach ( NodeItem *item, animated_nodes)
+    {
+        if ( item->advance( intervals))
+        {
+            item->collectAssociates( edges, chains);
+        } else
+        {
+            stopped << item;
+        }
+    }
+    edge_routing_deferred = deferred;
+    foreach ( EdgeChainItem *chain, chains)
     {
-        if ( n->item()->advance())
-            advanced = true;
+        chain->adjust();
     }
-    if ( !advanced)
+    foreach ( EdgeItem *edge, edges)
+    {
+        edge->adjust();
+    }
+    foreach ( NodeItem *item, stopped)
+    {
+        animated_nodes.remove( item);
+    }
+    if ( animated_nodes.isEmpty())
     {
         killTimer( node_animation_timer);
         node_animation_timer = 0;
@@ -1130,6 +2313,7 @@ void GraphView::advanceView()
             QMatrix scale;
             scale.scale( scaleVal( zoom_scale), scaleVal( zoom_scale));
             setMatrix( scale);
+            updateVirtualScene();
         } else
         {
             zoom_out_done = true;
@@ -1174,34 +2358,59 @@ void GraphView::focusOnNode( GNode *n, bool gen_event)
     graph()->setNodeInFocus( n);
 }
 
+/**
+ * Build index of node text in background
+ */
+void
+GraphView::buildTextIndex()
+{
+    text_index->build();
+}
+
+/**
+ * Take text index built in background
+ */
+void
+GraphView::textIndexBuilt()
+{
+    text_index->finishBuild();
+}
+
 GNode *
 GraphView::findNextNodeWithText( QString &findStr,
                                  QTextDocument::FindFlags flags)
 {
 	GNode *n;
 	
-    if ( isNullP( search_node))
+    if ( text_index->canFind( findStr, search_node))
     {
-        foreachNode( n, graph())
-        {
-            if ( isNullP( n->nextNode()))
-                break;
-        }
+        n = text_index->find( findStr, flags, search_node, true);
+        if ( isNotNullP( n))
+            search_node = n;
     } else
     {
-        n = search_node->prevNode();
-    }
+        if ( isNullP( search_node))
+        {
+            foreachNode( n, graph())
+            {
+                if ( isNullP( n->nextNode()))
+                    break;
+            }
+        } else
+        {
+            n = search_node->prevNode();
+        }
 
-    while ( isNotNullP( n))
-    {
-		QTextDocument *doc = n->doc();
-		if ( isNotNullP( doc) && !doc->find( findStr, 0, flags).isNull())
+        while ( isNotNullP( n))
         {
-            search_node = n;        
-            break;
+            if ( nodeTextContains( n, findStr, flags))
+            {
+                search_node = n;        
+                break;
+            }
+            n = n->prevNode();
         }
-        n = n->prevNode();
-	}
+    }
 	if ( isNotNullP( n))
 	{
 		if ( isContext())
@@ -1226,17 +2435,24 @@ GraphView::findPrevNodeWithText( QString &findStr,
 	GNode *n;
 	
     flags ^= QTextDocument::FindBackward; // Unset backward search flag
-    for ( n = isNullP( search_node) ? graph()->firstNode() : search_node->nextNode();
-          isNotNullP( n);
-          n = n->nextNode())
+    if ( text_index->canFind( findStr, search_node))
     {
-		QTextDocument *doc = n->doc();
-		if ( isNotNullP( doc) && !doc->find( findStr, 0, flags).isNull())
+        n = text_index->find( findStr, flags, search_node, false);
+        if ( isNotNullP( n))
+            search_node = n;
+    } else
+    {
+        for ( n = isNullP( search_node) ? graph()->firstNode() : search_node->nextNode();
+              isNotNullP( n);
+              n = n->nextNode())
         {
-            search_node = n;        
-            break;
+            if ( nodeTextContains( n, findStr, flags))
+            {
+                search_node = n;        
+                break;
+            }
         }
-	}
+    }
 	if ( isNotNullP( n))
 	{
 		if ( isContext())
@@ -1343,6 +2559,7 @@ void GraphView::toggleViewMode( bool context)
     {
         view_mode = CONTEXT_VIEW;
         graph()->clearNodesPriority();
+        graph()->resetContext();
     } else if ( !context && WHOLE_GRAPH_VIEW != view_mode)
     {
         view_mode = WHOLE_GRAPH_VIEW;
@@ -31,6 +31,7 @@
  * -# Create edge control point - double click on edge
  * -# Zoom view - press '-' and '+' or use mouse wheel
  * -# Invoke auto layout - select 'Run Layout' from View menu or simply press F5 
+ * -# Expand folded region of CFG - double click on it or zoom in on it
  */
 #ifndef GRAPH_VIEW_H
 #define GRAPH_VIEW_H
@@ -146,6 +147,38 @@ protected:
     QList< GEdge* > sel_edges;
     QHash< QString, GStyle *> styles;
     NodeNav node_in_focus;// Node in focus + navigation sector
+    /** Persistent cache of computed layouts */
+    LayoutCache layout_cache;
+    /** Whether layout cache is used */
+    bool layout_cache_enabled;
+    /** Key under which the running layout is to be stored */
+    QByteArray layout_key;
+    /** Root node of last intermediate placement of anytime layout */
+    GNode *layout_root;
+    /** Nodes that are placed in context view, focus node goes first */
+    QVector< AuxNode *> context_nodes;
+    /** Whether parts of graph are folded into single nodes, then context_nodes are the shown ones */
+    bool folded;
+
+    /** Center view on the root node */
+    void centerOnRoot();
+    /** Set target positions of node items to the placement coordinates */
+    void updateTargetPositions();
+    /** Lay out nodes of context only */
+    void layoutContext();
+    /** Show edge controls on edges between nodes of context */
+    void showContextEdges();
+    /** Lay out shown nodes of folded graph and move items to new positions */
+    void layoutFolded();
+    /** Get edges that stand for edges of folded nodes in layout */
+    virtual void foldedEdges( QVector< AuxNodePair> &edges);
+    
+    /** Width of edge control nodes */
+    virtual qreal controlWidth() const;
+    /** Height of edge control nodes */
+    virtual qreal controlHeight() const;
+    /** Edge controls are not placed in context view until they become visible */
+    virtual bool isControlForPlacement() const;
     
     /** Node creation reimplementaiton */
     virtual Node * createNode( int _id)
@@ -165,9 +198,16 @@ public:
     inline GGraph( GraphView *v, bool create_pools):
         AuxGraph( false),
         view_p( v),
-        node_in_focus( NULL, UNDEF_SECTOR)
+        node_in_focus( NULL, UNDEF_SECTOR),
+        layout_cache(),
+        layout_cache_enabled( true),
+        layout_key(),
+        layout_root( NULL),
+        context_nodes(),
+        folded( false)
     {
         nodeTextIsShown = newMarker();
+        setLayoutDeadline( LAYOUT_DEADLINE);
  
         /** Pools' creation routine */
         if ( create_pools)
@@ -228,6 +268,30 @@ public:
      * Reimplementation of layout's post processing step
      */
     void layoutPostProcess();
+    /**
+     * Animate nodes to intermediate placement of anytime layout if it is shown
+     */
+    void layoutRefined();
+    /**
+     * Show intermediate placement when layout is not done by deadline
+     */
+    void layoutDeadlinePassed();
+
+    /** Get layout cache */
+    inline LayoutCache *layoutCache()
+    {
+        return &layout_cache;
+    }
+    /** Check if layout cache is used by doLayout */
+    inline bool isLayoutCacheEnabled() const
+    {
+        return layout_cache_enabled;
+    }
+    /** Enable/disable layout cache */
+    inline void setLayoutCacheEnabled( bool enabled = true)
+    {
+        layout_cache_enabled = enabled;
+    }
 
     /** Get corresponding graph view widget */
     inline GraphView *view() const
@@ -306,6 +370,25 @@ public:
      */
     void findContext();
     
+    /** Consider all nodes to be in context, so next findContext fades out the ones left out */
+    void resetContext();
+
+    /** Check if parts of graph are folded */
+    inline bool isFolded() const
+    {
+        return folded;
+    }
+    /** Unfold nodes that given node stands for, layout is not run. Return false if node is not folded */
+    virtual bool expandNode( GNode *n);
+
+    /** Forget node that is being deleted */
+    inline void removeFromContext( GNode *n)
+    {
+        int i = context_nodes.indexOf( n);
+        if ( i >= 0)
+            context_nodes.remove( i);
+    }
+    
     /**
      * Make all nodes of graph visible and eligible for placement
      */
@@ -392,6 +475,62 @@ private:
     /** Deleted items lists */
     QList< NodeItem* > del_node_items;
     QList< EdgeItem* > del_edge_items;
+    /** Whether only items near viewport are kept in scene */
+    bool virtual_scene;
+    /** Index of graph items over scene coordinates, scene itself doesn't index items */
+    ItemGrid item_grid;
+    /** Whether item grid is not updated on item moves until it is rebuilt */
+    bool item_grid_frozen;
+    /** Items that are in scene in virtual scene mode */
+    QSet< QGraphicsItem *> attached_items;
+    /** Part of scene whose items are attached in virtual scene mode */
+    QRectF attached_rect;
+
+    /** Get rectangle of item in grid. Edge is registered with the rectangle of its end nodes */
+    QRectF gridRect( QGraphicsItem *item) const;
+    /** Update rectangle of item in grid, item is put in scene if it moves near viewport */
+    void moveGridItem( QGraphicsItem *item);
+
+    /** Rubber band for selection of nodes */
+    QRubberBand *rubber_band;
+    /** Point in viewport where rubber band selection started */
+    QPoint rubber_band_origin;
+
+    /** Cache of rendered tiles, NULL when scene is painted item by item */
+    TileCache *tile_cache;
+    /** Whether tiles covered the part of scene being painted, items are not painted then */
+    bool tiles_complete;
+    /** Export of image running in background, NULL if there is none */
+    ImageExport *image_export;
+    /** Index of node text for search */
+    TextIndex *text_index;
+
+    /** Whether graph is drawn in overview mode at small scale */
+    bool overview;
+    /** Whether overview arrays don't match items */
+    bool overview_dirty;
+    /** Scene rectangles of nodes drawn in overview mode */
+    QVector< QRectF> overview_nodes;
+    /** Pairs of end points of edges drawn in overview mode */
+    QVector< QPointF> overview_edges;
+
+    /** Whether edges through edge controls are drawn by one item per chain */
+    bool edge_chains;
+    /** Items of edge chains */
+    QList< EdgeChainItem *> chain_items;
+    /** Whether edges are not adjusted on node moves until routeEdges() is called */
+    bool edge_routing_deferred;
+    /** Routing of edges in background, NULL if there is none */
+    QFutureWatcher< EdgeRoute> *route_watcher;
+    /** Edges waiting for routes computed in background, with indexes of their routes */
+    QHash< EdgeItem *, int> routed_edges;
+
+    /** Get items that represent graph in scene: nodes, edges and edge chains, but not chains' parts */
+    QList< QGraphicsItem *> graphItems() const;
+    /** Fill overview arrays from items */
+    void updateOverview();
+    /** Draw graph from overview arrays */
+    void drawOverview( QPainter *painter);
 
     /** Actions */
     QAction *editableSwitchAct;
@@ -414,6 +553,10 @@ private:
     /** Temporary data */
     int timer_id;
     int node_animation_timer;
+    /** Nodes whose position or opacity differ from their targets, only they are advanced */
+    QSet< NodeItem *> animated_nodes;
+    /** Time of the last animation step */
+    QElapsedTimer animation_clock;
     QPointF curr_pos;
     bool createEdge;
     bool show_menus;
@@ -434,6 +577,10 @@ protected:
 signals:
     /** Signal that node is clicked */
     void nodeClicked( GNode *n);
+    /** Signal that given number of bands of exported image is written */
+    void imageExportProgress( int done, int total);
+    /** Signal that image export is finished, error is empty if it succeeded */
+    void imageExported( bool ok, const QString &error);
 public:
     /**
      * @brief Stores temporary info used for saving old style and node/edge being edited.
@@ -462,6 +609,8 @@ public slots:
     void navPrev();
     /** Navigate forward */
     void navNext();
+    /** Expand folded nodes that are in view */
+    void expandFoldedInView();
     /** Clear search node */
     void clearSearch();
     /** Delete one item     */
@@ -480,6 +629,24 @@ public slots:
     void toggleSmoothFocus( bool smooth);
     /** Toggle view mode */
     void toggleViewMode( bool context);
+    /** Toggle virtual scene mode */
+    void toggleVirtualScene( bool virt);
+    /** Toggle rendering of scene into cached tiles */
+    void toggleTileCache( bool tiles);
+    /** Toggle overview mode */
+    void toggleOverview( bool ov);
+    /** Toggle edge chain mode */
+    void toggleEdgeChains( bool chains);
+    /** Drop tiles in changed parts of scene */
+    void sceneChanged( const QList< QRectF> &region);
+    /** Take rendered tiles */
+    void tileRendered();
+    /** Write rendered band of exported image */
+    void imageBandRendered();
+    /** Give edges routes computed in background */
+    void edgesRouted();
+    /** Take text index built in background */
+    void textIndexBuilt();
     /** Show text of the clicked node */
     void showSelectedNodesText();
     /** Enable/disable edition */
@@ -531,6 +698,143 @@ public:
         return smooth_focus;
     }
     
+    /** Check if only items near viewport are kept in scene */
+    inline bool isVirtualScene() const
+    {
+        return virtual_scene;
+    }
+    /**
+     * Set virtual scene mode. In this mode graph items are kept in item grid and only
+     * those near viewport are in scene, so scene's cost depends on what is shown
+     */
+    void setVirtualScene( bool virt = true);
+    /** Register new graph item in item grid and put it to scene unless it is far from viewport */
+    void addGraphItem( QGraphicsItem *item);
+    /** Remove graph item from scene and item grid */
+    void removeGraphItem( QGraphicsItem *item);
+    /** Update node's and its edges' rectangles in item grid when node moves */
+    void itemMoved( NodeItem *item);
+    /** Put items near viewport to scene and take away others in virtual scene mode */
+    void updateVirtualScene();
+    /**
+     * Stop updating item grid on item moves, used before moving many items at once.
+     * rebuildItemGrid() registers all items anew and resumes updates
+     */
+    inline void freezeItemGrid()
+    {
+        item_grid_frozen = true;
+        /** Scene's BSP tree would follow each move as well, it is built anew with the grid */
+        if ( !virtual_scene)
+            scene()->setItemIndexMethod( QGraphicsScene::NoIndex);
+    }
+    /** Register all graph items in item grid anew */
+    void rebuildItemGrid();
+    /** Get topmost visible graph item at given point of scene */
+    QGraphicsItem *graphItemAt( const QPointF &pos) const;
+    /** Select nodes that are inside given rectangle of scene */
+    void selectNodesInRect( const QRectF &rect);
+    /** Get index of graph items */
+    inline const ItemGrid &itemGrid() const
+    {
+        return item_grid;
+    }
+
+    /** Check if scene is rendered into cached tiles */
+    inline bool isTileCache() const
+    {
+        return isNotNullP( tile_cache);
+    }
+    /**
+     * Set rendering of scene into cached tiles. Tiles are blitted during pan and zoom
+     * instead of painting items, only items that change are painted directly
+     */
+    void setTileCache( bool tiles = true);
+    /** Check if item is painted into tiles, items being dragged or edited are not */
+    bool isTileItem( QGraphicsItem *item) const;
+
+    /**
+     * Start export of visible items to image file in background. Progress is reported
+     * by imageExportProgress() and result by imageExported()
+     */
+    void startImageExport( const QString &file_name, qreal scale, qreal margin);
+    /** Check if image export is running */
+    inline bool isImageExporting() const
+    {
+        return isNotNullP( image_export);
+    }
+
+    /** Get index of node text */
+    inline TextIndex *textIndex() const
+    {
+        return text_index;
+    }
+    /**
+     * Build index of node text in background. Search walks node list until it is done
+     */
+    void buildTextIndex();
+
+    /** Check if overview mode is enabled */
+    inline bool isOverview() const
+    {
+        return overview;
+    }
+    /**
+     * Enable overview mode. When view is zoomed out below OVERVIEW_SCALE graph is drawn
+     * as batched rectangles and lines instead of painting items one by one
+     */
+    void setOverview( bool ov = true);
+    /** Check if graph is currently drawn in overview mode */
+    inline bool isOverviewShown() const
+    {
+        return overview && transform().m11() < OVERVIEW_SCALE;
+    }
+    /** Mark overview arrays as outdated, called when items move or are shown or hidden */
+    void invalidateOverview();
+
+    /** Check if edges through edge controls are drawn by one item per chain */
+    inline bool hasEdgeChains() const
+    {
+        return edge_chains;
+    }
+    /**
+     * Set edge chain mode. In this mode each chain of edges through edge controls is drawn
+     * by one EdgeChainItem, its edge items and control items are kept out of scene
+     */
+    void setEdgeChains( bool chains = true);
+    /** Build chain items for the current edge controls, called when placement changes */
+    void updateEdgeChains();
+    /** Remove chain item and put its remaining parts back to scene */
+    void removeEdgeChain( EdgeChainItem *chain);
+
+    /**
+     * Stop adjusting edges on node moves, used before placing all nodes at once.
+     * routeEdges() computes all routes in one pass and resumes adjusting
+     */
+    inline void deferEdgeRouting()
+    {
+        edge_routing_deferred = true;
+    }
+    /** Check if edges are not adjusted on node moves */
+    inline bool isEdgeRoutingDeferred() const
+    {
+        return edge_routing_deferred;
+    }
+    /**
+     * Compute routes of all edges that are not drawn by chain items. Routes of many edges
+     * are computed in background and are given to edges by edgesRouted()
+     */
+    void routeEdges();
+    /** Wait for routes computed in background and give them to edges */
+    void finishEdgeRouting();
+    /** Drop routing in background, edges keep their current routes */
+    void cancelEdgeRouting();
+    /** Don't give edge the route computed in background, used when edge is adjusted or removed */
+    inline void dropEdgeRoute( EdgeItem *item)
+    {
+        if ( !routed_edges.isEmpty())
+            routed_edges.remove( item);
+    }
+
     /** Return true if view operates in context mode */
     inline bool isContext() const
     {
@@ -595,8 +899,11 @@ public:
 
     void dragMoveEvent( QDragMoveEvent *event);
 
-    /** draw background reimplementation */
+    /** draw background reimplementation, tiles are drawn as background */
     void drawBackground( QPainter *painter, const QRectF &rect);
+    /** Items drawing reimplementation, items that are in drawn tiles or overview are skipped */
+    void drawItems( QPainter *painter, int numItems,
+                    QGraphicsItem *items[], const QStyleOptionGraphicsItem options[]);
     /** Mouse double click event handler reimplementation */
     void mouseDoubleClickEvent( QMouseEvent *event);
     /** Mouse press event handler reimplementation */
@@ -612,6 +919,10 @@ public:
 
     /** Mouse wheel event handler reimplementation */
     void wheelEvent( QWheelEvent *event);
+    /** Scrolling reimplementation, scene follows viewport in virtual scene mode */
+    void scrollContentsBy( int dx, int dy);
+    /** Resize event handler reimplementation */
+    void resizeEvent( QResizeEvent *event);
     /** Zoom the view in */
     void zoomIn();
     /** Zoom the view out */
@@ -622,8 +933,15 @@ public:
     void updateMatrix();
     /** Focus on node */
     void focusOnNode( GNode *n, bool gen_event);
-    /** Start animation for nodes */
+    /** Start animation for all nodes whose position or opacity differ from their targets */
     void startAnimationNodes();
+    /** Start animation of given node, it is advanced until it reaches its targets */
+    void animateNode( NodeItem *item);
+    /** Stop animation of given node */
+    inline void stopAnimation( NodeItem *item)
+    {
+        animated_nodes.remove( item);
+    }
     /** Advance view in animated focusing procedure */
     void advanceView();
     /** Advance nodes in animation sequence */
@@ -39,6 +39,7 @@ class GNode;
 class GEdge;
 class NodeItem;
 class EdgeItem;
+class EdgeChainItem;
 class GraphView;
 class StyleEdit;
 
@@ -49,6 +50,7 @@ class StyleEdit;
 #include <QGraphicsView>
 #include <QDebug>
 #include <QWheelEvent>
+#include <zlib.h>
 
 #include "../Graph/graph_iface.h"
 #include "../Layout/layout_iface.h"
@@ -60,7 +62,8 @@ enum {
     TypeNode = QGraphicsItem::UserType + 1, /** Node item */
     TypeEdge = QGraphicsItem::UserType + 2, /** Edge item */
     TypeEdgeControl = QGraphicsItem::UserType + 3,/** EdgeControl item */
-    TypeEdgeHelper = QGraphicsItem::UserType + 4 /** Edge helper item */
+    TypeEdgeHelper = QGraphicsItem::UserType + 4, /** Edge helper item */
+    TypeEdgeChain = QGraphicsItem::UserType + 5 /** Edge chain item */
 };
 
 /** Max opacity level for items in graph view */
@@ -92,7 +95,13 @@ private:
 #include "gstyle.h"
 #include "edge_item.h"
 #include "node_item.h"
+#include "chain_item.h"
 #include "edge_helper.h"
+#include "item_grid.h"
+#include "tile_cache.h"
+#include "image_export.h"
+#include "text_index.h"
+#include "layout_cache.h"
 #include "graph_view.h"
 #include "style_edit.h"
 
@@ -36,12 +36,15 @@ const qreal SE_VERT_MARGIN = 20;
 /** Self edge horizontal margin*/
 const qreal SE_HOR_MARGIN = 20;
 
-/** Node speed */
+/** Node speed, distance that node moves in one animation interval */
 const qreal NODE_SPEED = 4;
 
-/** Opacity step */
+/** Opacity step, change of opacity in one animation interval */
 const qreal OPACITY_STEP = 0.1;
 
+/** Interval of node animation in milliseconds, node speed and opacity step are given for it */
+const int NODE_ANIMATION_INTERVAL = 1000 / 25;
+
 /** Context visible border */
 const int MAX_VISIBLE_LEN = 3;
 
@@ -51,4 +54,37 @@ const int MAX_PRIORITY = 6;
 /** Context far border */
 const int MAX_PLACE_LEN = 3;
 
+/** View scale from which zooming in expands folded nodes in view */
+const qreal FOLD_EXPAND_SCALE = 1;
+
+/** Size of cell of item grid in scene coordinates */
+const qreal ITEM_GRID_CELL_SIZE = 256;
+
+/** Part of viewport size by which scene is kept around viewport in virtual scene mode */
+const qreal VIRTUAL_SCENE_MARGIN = 0.5;
+
+/** Size of rendered tile in pixels */
+const int TILE_SIZE = 256;
+/** Number of tile zoom levels per doubling of scale */
+const int TILE_LEVELS_PER_OCTAVE = 2;
+/** Maximal number of rendered tiles kept in cache */
+const int TILE_CACHE_MAX_TILES = 256;
+/** Maximal number of pixels of exported image in formats that are not written band by band, PNG is streamed above it */
+const qint64 IMAGE_EXPORT_MAX_PIXELS = 64 * 1024 * 1024;
+/** Margin by which tile's rectangle is widened to find items whose painting reaches the tile */
+const qreal TILE_ITEM_MARGIN = 40;
+
+/** View scale below which graph is drawn in overview mode */
+const qreal OVERVIEW_SCALE = 0.2;
+
+/** Kind of node outline for edge controls, kinds of other outlines are node shapes */
+const int NODE_OUTLINE_CONTROL = NODE_SHAPES_NUM;
+/** Kind of node outline for nodes without style */
+const int NODE_OUTLINE_PLAIN = NODE_SHAPES_NUM + 1;
+/** Maximal number of shared node outlines, cache is dropped when it is exceeded */
+const int NODE_OUTLINE_CACHE_SIZE = 1024;
+
+/** Minimal number of edges for which routes are computed in parallel after placement */
+const int EDGE_ROUTING_PARALLEL_MIN_EDGES = 500;
+
 #endif /* GVIEW_IMPL_H */
\ No newline at end of file
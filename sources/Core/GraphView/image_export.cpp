@@ -0,0 +1,569 @@
+/**
+ * @file: image_export.cpp
+ * Implementation of export of scene to image file by tiles
+ * @ingroup GUIGraph
+ */
+/*
+ * GUI for ShowGraph tool.
+ * Copyright (c) 2009, Boris Shurygin
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "gview_impl.h"
+
+/** Size of BMP file header and bitmap info header */
+const int BMP_HEADER_SIZE = 54;
+
+/** Size of buffer that deflate output of streamed PNG is taken by */
+const int PNG_DEFLATE_BUF_SIZE = 64 * 1024;
+
+/**
+ * Replay pictures of items into tile of exported image, runs in background
+ */
+static QImage renderExportTile( const ExportTileJob &job)
+{
+    QImage image( job.size, QImage::Format_RGB32);
+
+    image.fill( job.background);
+    if ( !job.pictures.isEmpty())
+    {
+        /** Pictures are scaled on replay by the ratio of resolutions, keep it at one */
+        image.setDotsPerMeterX( qRound( job.pictures.first().logicalDpiX() * 100 / 2.54));
+        image.setDotsPerMeterY( qRound( job.pictures.first().logicalDpiY() * 100 / 2.54));
+    }
+
+    QPainter painter( &image);
+
+    painter.translate( -job.origin);
+    foreach ( const QPicture &picture, job.pictures)
+    {
+        painter.drawPicture( 0, 0, picture);
+    }
+    painter.end();
+    return image;
+}
+
+/**
+ * Compare items by z value
+ */
+static bool zLessThan( QGraphicsItem *item1, QGraphicsItem *item2)
+{
+    return item1->zValue() < item2->zValue();
+}
+
+/**
+ * Rectangle of scene that covers visible items of view widened by margin
+ */
+static QRectF exportRect( GraphView *view, qreal margin)
+{
+    QRectF rect;
+
+    foreach ( QGraphicsItem *item, view->itemGrid().items( view->itemGrid().boundingRect()))
+    {
+        if ( item->isVisible())
+            rect |= item->sceneBoundingRect();
+    }
+    return rect.adjusted( -margin, -margin, margin, margin);
+}
+
+/**
+ * Size of image of given rectangle of scene at given scale
+ */
+static QSize exportSize( const QRectF &rect, qreal scale)
+{
+    return QSize( qMax( 1, ( int)( rect.width() * scale)),
+                  qMax( 1, ( int)( rect.height() * scale)));
+}
+
+/**
+ * Constructor. Exported rectangle covers visible items of view widened by margin.
+ * Edges that wait for routes computed in background get them first
+ */
+ImageExport::ImageExport( GraphView *v, const QString &name, qreal image_scale, qreal margin):
+    view( v),
+    file_name( name),
+    error_string(),
+    scene_rect(),
+    scale( image_scale),
+    size(),
+    bands_done( 0),
+    stream( IMAGE_STREAM_NONE),
+    png_zip(),
+    png_zip_open( false),
+    file( name),
+    image(),
+    watcher( NULL)
+{
+    view->finishEdgeRouting();
+    scene_rect = exportRect( view, margin);
+    size = exportSize( scene_rect, scale);
+
+    QString suffix = QFileInfo( name).suffix().toLower();
+
+    if ( suffix == "bmp")
+    {
+        stream = IMAGE_STREAM_BMP;
+    } else if ( suffix == "png" && !fitsInMemory( size))
+    {
+        stream = IMAGE_STREAM_PNG;
+    }
+}
+
+/**
+ * Get size in pixels of image of view's visible items, used to choose format before export
+ */
+QSize
+ImageExport::imageSize( GraphView *v, qreal image_scale, qreal margin)
+{
+    v->finishEdgeRouting();
+    return exportSize( exportRect( v, margin), image_scale);
+}
+
+/**
+ * Check if image of given size can be gathered in memory
+ */
+bool
+ImageExport::fitsInMemory( const QSize &image_size)
+{
+    return ( qint64)image_size.width() * image_size.height() <= IMAGE_EXPORT_MAX_PIXELS;
+}
+
+/**
+ * Check if image of given size can be exported to file of given name.
+ * BMP and PNG files are streamed, other formats need the whole image in memory
+ */
+bool
+ImageExport::canExport( const QString &name, const QSize &image_size)
+{
+    QString suffix = QFileInfo( name).suffix().toLower();
+
+    return suffix == "bmp" || suffix == "png" || fitsInMemory( image_size);
+}
+
+/**
+ * Destructor. Waits for rendering in progress, file of unfinished export is removed
+ */
+ImageExport::~ImageExport()
+{
+    if ( isNotNullP( watcher))
+    {
+        watcher->cancel();
+        watcher->waitForFinished();
+        watcher->deleteLater();
+    }
+    if ( png_zip_open)
+        deflateEnd( &png_zip);
+    if ( file.isOpen())
+        file.remove();
+}
+
+/**
+ * Get number of tiles in a row
+ */
+int
+ImageExport::columnNum() const
+{
+    return ( size.width() + TILE_SIZE - 1) / TILE_SIZE;
+}
+
+/**
+ * Get number of bands
+ */
+int
+ImageExport::bandNum() const
+{
+    return ( size.height() + TILE_SIZE - 1) / TILE_SIZE;
+}
+
+/**
+ * Record items of band and make jobs for its tiles. Items are recorded once per band
+ * and each tile gets pictures of items that reach it
+ */
+QList< ExportTileJob>
+ImageExport::bandJobs( int band) const
+{
+    int top = band * TILE_SIZE;
+    int height = qMin( TILE_SIZE, size.height() - top);
+    qreal pixel = 1 / scale;
+    QRectF rect( scene_rect.left(), scene_rect.top() + top / scale,
+                 scene_rect.width(), height / scale);
+    QList< QGraphicsItem *> items;
+    QList< QPicture> pictures;
+    QList< ExportTileJob> jobs;
+
+    foreach ( QGraphicsItem *item,
+              view->itemGrid().items( rect.adjusted( -TILE_ITEM_MARGIN, -TILE_ITEM_MARGIN,
+                                                     TILE_ITEM_MARGIN, TILE_ITEM_MARGIN)))
+    {
+        if ( item->isVisible()
+             && rect.adjusted( -pixel, -pixel, pixel, pixel).intersects( item->sceneBoundingRect()))
+        {
+            items << item;
+        }
+    }
+    qStableSort( items.begin(), items.end(), zLessThan);
+    foreach ( QGraphicsItem *item, items)
+    {
+        pictures << TileCache::itemPicture( view, item, scale);
+    }
+
+    for ( int column = 0; column < columnNum(); column++)
+    {
+        ExportTileJob job;
+        int left = column * TILE_SIZE;
+        int width = qMin( TILE_SIZE, size.width() - left);
+        QRectF tile_rect( scene_rect.left() + left / scale, rect.top(),
+                          width / scale, rect.height());
+
+        job.origin = QPointF( scene_rect.left() * scale + left, scene_rect.top() * scale + top);
+        job.size = QSize( width, height);
+        job.background = view->palette().base().color().rgb();
+        for ( int i = 0; i < items.size(); i++)
+        {
+            if ( tile_rect.adjusted( -pixel, -pixel, pixel, pixel).intersects( items[ i]->sceneBoundingRect()))
+                job.pictures << pictures[ i];
+        }
+        jobs << job;
+    }
+    return jobs;
+}
+
+/**
+ * Open file and write header for streamed image, allocate whole image otherwise
+ */
+bool
+ImageExport::open()
+{
+    if ( stream == IMAGE_STREAM_NONE)
+    {
+        if ( !fitsInMemory( size))
+        {
+            fail( QObject::tr( "Image of %1x%2 pixels is too big for this format, export it to PNG or BMP")
+                  .arg( size.width())
+                  .arg( size.height()));
+            return false;
+        }
+        image = QImage( size, QImage::Format_RGB32);
+        if ( image.isNull())
+        {
+            fail( QObject::tr( "Not enough memory for image of %1x%2 pixels")
+                  .arg( size.width())
+                  .arg( size.height()));
+            return false;
+        }
+        return true;
+    }
+    if ( stream == IMAGE_STREAM_PNG)
+    {
+        if ( !file.open( QIODevice::WriteOnly))
+        {
+            fail( file.errorString());
+            return false;
+        }
+
+        QByteArray header;
+        QDataStream out( &header, QIODevice::WriteOnly);
+
+        /** Width, height, 8 bit RGB, deflate, adaptive filtering, no interlace */
+        out << ( quint32)size.width() << ( quint32)size.height()
+            << ( quint8)8 << ( quint8)2 << ( quint8)0 << ( quint8)0 << ( quint8)0;
+        if ( file.write( "\x89PNG\r\n\x1a\n", 8) != 8
+             || !writePngChunk( "IHDR", header))
+        {
+            fail( file.errorString());
+            return false;
+        }
+        if ( deflateInit( &png_zip, Z_DEFAULT_COMPRESSION) != Z_OK)
+        {
+            fail( QObject::tr( "Cannot start compression of PNG data"));
+            return false;
+        }
+        png_zip_open = true;
+        return true;
+    }
+
+    qint64 row_size = ( ( qint64)size.width() * 3 + 3) & ~3;
+    qint64 file_size = BMP_HEADER_SIZE + row_size * size.height();
+
+    if ( file_size > 0xffffffffLL)
+    {
+        fail( QObject::tr( "Image of %1x%2 pixels is too big for BMP")
+              .arg( size.width())
+              .arg( size.height()));
+        return false;
+    }
+    if ( !file.open( QIODevice::WriteOnly))
+    {
+        fail( file.errorString());
+        return false;
+    }
+
+    QDataStream out( &file);
+
+    out.setByteOrder( QDataStream::LittleEndian);
+    /** File header */
+    out << ( quint8)'B' << ( quint8)'M' << ( quint32)file_size
+        << ( quint16)0 << ( quint16)0 << ( quint32)BMP_HEADER_SIZE;
+    /** Info header, negative height stands for rows stored from top to bottom */
+    out << ( quint32)40 << ( qint32)size.width() << ( qint32)-size.height()
+        << ( quint16)1 << ( quint16)24 << ( quint32)0 << ( quint32)( row_size * size.height())
+        << ( qint32)2835 << ( qint32)2835 << ( quint32)0 << ( quint32)0;
+    if ( out.status() != QDataStream::Ok)
+    {
+        fail( file.errorString());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Write chunk of streamed PNG: length, type, data and CRC of type and data
+ */
+bool
+ImageExport::writePngChunk( const char *type, const QByteArray &data)
+{
+    QByteArray head;
+    QByteArray tail;
+    QDataStream head_out( &head, QIODevice::WriteOnly);
+    QDataStream tail_out( &tail, QIODevice::WriteOnly);
+    uLong crc = crc32( 0L, Z_NULL, 0);
+
+    crc = crc32( crc, reinterpret_cast< const Bytef *>( type), 4);
+    crc = crc32( crc, reinterpret_cast< const Bytef *>( data.constData()), data.size());
+    head_out << ( quint32)data.size();
+    head.append( type, 4);
+    tail_out << ( quint32)crc;
+    return file.write( head) == head.size()
+           && file.write( data) == data.size()
+           && file.write( tail) == tail.size();
+}
+
+/**
+ * Compress data of streamed PNG and write what deflate gives out as IDAT chunk.
+ * Deflate keeps a bounded window, output is taken while it fills the whole buffer
+ */
+bool
+ImageExport::deflatePng( const QByteArray &data, int flush)
+{
+    QByteArray chunk;
+    QByteArray buf( PNG_DEFLATE_BUF_SIZE, 0);
+
+    png_zip.next_in = reinterpret_cast< Bytef *>( const_cast< char *>( data.constData()));
+    png_zip.avail_in = data.size();
+    do
+    {
+        png_zip.next_out = reinterpret_cast< Bytef *>( buf.data());
+        png_zip.avail_out = buf.size();
+        if ( deflate( &png_zip, flush) == Z_STREAM_ERROR)
+        {
+            fail( QObject::tr( "Cannot compress PNG data"));
+            return false;
+        }
+        chunk.append( buf.constData(), buf.size() - png_zip.avail_out);
+    } while ( png_zip.avail_out == 0);
+
+    if ( !chunk.isEmpty() && !writePngChunk( "IDAT", chunk))
+    {
+        fail( file.errorString());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Write rendered tiles of next band. Streamed image gets band's rows appended to file,
+ * streamed PNG gets band's rows compressed into IDAT chunk
+ */
+bool
+ImageExport::writeBand( const QList< QImage> &tiles)
+{
+    int top = bands_done * TILE_SIZE;
+
+    if ( tiles.size() != columnNum())
+    {
+        fail( QObject::tr( "Export is cancelled"));
+        return false;
+    }
+    if ( stream == IMAGE_STREAM_NONE)
+    {
+        QPainter painter( &image);
+
+        for ( int column = 0; column < tiles.size(); column++)
+        {
+            painter.drawImage( QPoint( column * TILE_SIZE, top), tiles[ column]);
+        }
+        bands_done++;
+        return true;
+    }
+
+    bool png = ( stream == IMAGE_STREAM_PNG);
+    /** PNG row starts with filter type, BMP row is padded to four bytes */
+    QByteArray row( png ? size.width() * 3 + 1 : ( size.width() * 3 + 3) & ~3, 0);
+    QByteArray band_data;
+
+    for ( int y = 0; y < tiles.first().height(); y++)
+    {
+        char *pixel = row.data() + ( png ? 1 : 0);
+
+        foreach ( const QImage &tile, tiles)
+        {
+            const QRgb *line = reinterpret_cast< const QRgb *>( tile.constScanLine( y));
+
+            for ( int x = 0; x < tile.width(); x++)
+            {
+                if ( png)
+                {
+                    *pixel++ = qRed( line[ x]);
+                    *pixel++ = qGreen( line[ x]);
+                    *pixel++ = qBlue( line[ x]);
+                } else
+                {
+                    *pixel++ = qBlue( line[ x]);
+                    *pixel++ = qGreen( line[ x]);
+                    *pixel++ = qRed( line[ x]);
+                }
+            }
+        }
+        if ( png)
+        {
+            band_data.append( row);
+        } else if ( file.write( row) != row.size())
+        {
+            fail( file.errorString());
+            return false;
+        }
+    }
+    if ( png && !deflatePng( band_data, Z_NO_FLUSH))
+        return false;
+    bands_done++;
+    return true;
+}
+
+/**
+ * Finish writing. Image that is not streamed is written as a whole here
+ */
+bool
+ImageExport::close()
+{
+    if ( stream == IMAGE_STREAM_PNG)
+    {
+        /** Data that deflate holds back is flushed with the end of zlib stream */
+        if ( !deflatePng( QByteArray(), Z_FINISH))
+            return false;
+        deflateEnd( &png_zip);
+        png_zip_open = false;
+        if ( !writePngChunk( "IEND", QByteArray()))
+        {
+            fail( file.errorString());
+            return false;
+        }
+    }
+    if ( stream != IMAGE_STREAM_NONE)
+    {
+        file.close();
+        if ( file.error() != QFile::NoError)
+        {
+            fail( file.errorString());
+            file.remove();
+            return false;
+        }
+        return true;
+    }
+
+    QImageWriter writer( file_name);
+
+    if ( !writer.canWrite() || !writer.write( image))
+    {
+        fail( writer.errorString());
+        return false;
+    }
+    image = QImage();
+    return true;
+}
+
+/**
+ * Remember error and drop partly written file or image
+ */
+void
+ImageExport::fail( const QString &error)
+{
+    error_string = error;
+    if ( png_zip_open)
+    {
+        deflateEnd( &png_zip);
+        png_zip_open = false;
+    }
+    if ( file.isOpen())
+        file.remove();
+    image = QImage();
+}
+
+/**
+ * Export image waiting for each band to be rendered, used where there is no event loop
+ */
+bool
+ImageExport::run()
+{
+    if ( !open())
+        return false;
+
+    while ( bands_done < bandNum())
+    {
+        QList< QImage> tiles =
+            QtConcurrent::blockingMapped< QList< QImage> >( bandJobs( bands_done), renderExportTile);
+
+        if ( !writeBand( tiles))
+            return false;
+    }
+    return close();
+}
+
+/**
+ * Start export in background. Each band is rendered by workers while GUI thread is free,
+ * view's imageBandRendered() is called when it is done
+ */
+bool
+ImageExport::start()
+{
+    if ( !open())
+        return false;
+
+    watcher = new QFutureWatcher< QImage>();
+    QObject::connect( watcher, SIGNAL( finished()), view, SLOT( imageBandRendered()));
+    watcher->setFuture( QtConcurrent::mapped( bandJobs( 0), renderExportTile));
+    return true;
+}
+
+/**
+ * Write rendered band and start rendering the next one.
+ * Returns false when export is done or failed, errorString() tells which
+ */
+bool
+ImageExport::bandRendered()
+{
+    QList< QImage> tiles = watcher->future().results();
+
+    watcher->deleteLater();
+    watcher = NULL;
+    if ( !writeBand( tiles))
+        return false;
+
+    if ( bands_done == bandNum())
+    {
+        close();
+        return false;
+    }
+    watcher = new QFutureWatcher< QImage>();
+    QObject::connect( watcher, SIGNAL( finished()), view, SLOT( imageBandRendered()));
+    watcher->setFuture( QtConcurrent::mapped( bandJobs( bands_done), renderExportTile));
+    return true;
+}
@@ -0,0 +1,149 @@
+/**
+ * @file: image_export.h
+ * Export of scene to image file by tiles
+ * @ingroup GUIGraph
+ */
+/*
+ * GUI for ShowGraph tool.
+ * Copyright (c) 2009, Boris Shurygin
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef IMAGE_EXPORT_H
+#define IMAGE_EXPORT_H
+
+/**
+ * Job of rendering one tile of exported image
+ * @ingroup GUIGraph
+ */
+struct ExportTileJob
+{
+    /** Top left corner of tile in pixels of image's scale */
+    QPointF origin;
+    /** Size of tile, tiles at the right and bottom borders of image are cut */
+    QSize size;
+    /** Background color */
+    QRgb background;
+    /** Pictures of items in painting order, recorded in pixels of image's scale */
+    QList< QPicture> pictures;
+};
+
+/**
+ * Ways of writing exported image
+ */
+enum ImageStream
+{
+    /** Bands are gathered into one image that is written by Qt */
+    IMAGE_STREAM_NONE,
+    /** BMP file is written row by row */
+    IMAGE_STREAM_BMP,
+    /** PNG file is written row by row, compressed by zlib */
+    IMAGE_STREAM_PNG
+};
+
+/**
+ * Export of scene to image file by tiles
+ * @ingroup GUIGraph
+ *
+ * Image is made of bands, band is a row of tiles of TILE_SIZE pixels. Items of band are
+ * recorded into pictures in GUI thread and tiles are replayed from pictures by background
+ * workers, as tile cache does it. Rendered band is written to file and dropped, so only one
+ * band is kept in memory. BMP files are written row by row as bands come; Qt has no writer
+ * that takes image by parts for other formats, their bands are gathered into one image
+ * which is limited by IMAGE_EXPORT_MAX_PIXELS. PNG image over the limit is written row by row
+ * as well, its data is compressed by zlib deflate band by band since Qt gives no streaming writer.
+ * Export runs in background by start() and bandRendered() or at once by run()
+ */
+class ImageExport
+{
+    /** View whose scene is exported */
+    GraphView *view;
+    /** Name of image file */
+    QString file_name;
+    /** Description of error, empty while there is none */
+    QString error_string;
+    /** Exported rectangle of scene */
+    QRectF scene_rect;
+    /** Scale of image relative to scene */
+    qreal scale;
+    /** Size of image in pixels */
+    QSize size;
+    /** Number of bands that are written */
+    int bands_done;
+    /** How image is written to file */
+    ImageStream stream;
+    /** Deflate stream of image data of streamed PNG */
+    z_stream png_zip;
+    /** Whether deflate stream is started and is to be ended */
+    bool png_zip_open;
+    /** File of streamed image */
+    QFile file;
+    /** Whole image for formats that are not streamed */
+    QImage image;
+    /** Rendering of band in progress, NULL if there is none */
+    QFutureWatcher< QImage> *watcher;
+
+    /** Get number of tiles in a row */
+    int columnNum() const;
+    /** Record items of band and make jobs for its tiles */
+    QList< ExportTileJob> bandJobs( int band) const;
+    /** Open file or allocate image */
+    bool open();
+    /** Write rendered tiles of next band */
+    bool writeBand( const QList< QImage> &tiles);
+    /** Compress data of streamed PNG and write it as IDAT chunk */
+    bool deflatePng( const QByteArray &data, int flush);
+    /** Write chunk of streamed PNG */
+    bool writePngChunk( const char *type, const QByteArray &data);
+    /** Finish writing and close file */
+    bool close();
+    /** Drop partly written file after failure */
+    void fail( const QString &error);
+public:
+    /** Constructor. Rectangle of visible items is widened by margin and exported at given scale */
+    ImageExport( GraphView *v, const QString &name, qreal image_scale, qreal margin);
+    /** Destructor. Waits for rendering in progress */
+    ~ImageExport();
+
+    /** Export image waiting for each band to be rendered. Returns true on success */
+    bool run();
+    /** Start export in background, view's imageBandRendered() is called when band is rendered */
+    bool start();
+    /** Write rendered band and start next one. Returns false when export is done or failed */
+    bool bandRendered();
+
+    /** Get number of bands */
+    int bandNum() const;
+    /** Get size of image in pixels */
+    inline QSize imageSize() const
+    {
+        return size;
+    }
+    /** Get size of image of view's visible items widened by margin at given scale */
+    static QSize imageSize( GraphView *v, qreal image_scale, qreal margin);
+    /** Check if image of given size can be gathered in memory for formats that are not streamed */
+    static bool fitsInMemory( const QSize &image_size);
+    /** Check if image of given size can be exported to file of given name */
+    static bool canExport( const QString &name, const QSize &image_size);
+    /** Get number of bands that are written */
+    inline int bandsDone() const
+    {
+        return bands_done;
+    }
+    /** Get description of error, it is empty if export succeeded */
+    inline QString errorString() const
+    {
+        return error_string;
+    }
+};
+
+#endif /* IMAGE_EXPORT_H */
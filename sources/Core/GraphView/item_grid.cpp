@@ -0,0 +1,218 @@
+/**
+ * @file: item_grid.cpp
+ * Implementation of spatial index of graph items
+ * @ingroup GUIGraph
+ */
+/*
+ * GUI for ShowGraph tool.
+ * Copyright (c) 2009, Boris Shurygin
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "gview_impl.h"
+
+/**
+ * Check if rectangles overlap, unlike QRectF::intersects it accepts rectangles of zero size
+ */
+static inline bool overlaps( const QRectF &r1, const QRectF &r2)
+{
+    return r1.left() <= r2.right() && r2.left() <= r1.right()
+           && r1.top() <= r2.bottom() && r2.top() <= r1.bottom();
+}
+
+/**
+ * Constructor
+ */
+ItemGrid::ItemGrid():
+    cells(),
+    rects(),
+    bounding_rect()
+{
+
+}
+
+/**
+ * Get range of cells that rectangle overlaps, bounds are inclusive
+ */
+QRect
+ItemGrid::cellRange( const QRectF &rect)
+{
+    return QRect( QPoint( ( int)floor( rect.left() / ITEM_GRID_CELL_SIZE),
+                          ( int)floor( rect.top() / ITEM_GRID_CELL_SIZE)),
+                  QPoint( ( int)floor( rect.right() / ITEM_GRID_CELL_SIZE),
+                          ( int)floor( rect.bottom() / ITEM_GRID_CELL_SIZE)));
+}
+
+/**
+ * Add item to cells of range
+ */
+void
+ItemGrid::addToCells( QGraphicsItem *item, const QRect &range)
+{
+    for ( int x = range.left(); x <= range.right(); x++)
+    {
+        for ( int y = range.top(); y <= range.bottom(); y++)
+        {
+            cells[ cellKey( x, y)].push_back( item);
+        }
+    }
+}
+
+/**
+ * Remove item from cells of range, empty cells are dropped
+ */
+void
+ItemGrid::removeFromCells( QGraphicsItem *item, const QRect &range)
+{
+    for ( int x = range.left(); x <= range.right(); x++)
+    {
+        for ( int y = range.top(); y <= range.bottom(); y++)
+        {
+            QHash< quint64, QVector< QGraphicsItem *> >::iterator cell = cells.find( cellKey( x, y));
+
+            if ( cell == cells.end())
+                continue;
+
+            QVector< QGraphicsItem *> &cell_items = cell.value();
+            int i = cell_items.indexOf( item);
+
+            if ( i >= 0)
+            {
+                /** Order of items in cell doesn't matter */
+                cell_items[ i] = cell_items.last();
+                cell_items.resize( cell_items.size() - 1);
+            }
+            if ( cell_items.isEmpty())
+                cells.erase( cell);
+        }
+    }
+}
+
+/**
+ * Remove all items
+ */
+void
+ItemGrid::clear()
+{
+    cells.clear();
+    rects.clear();
+    bounding_rect = QRectF();
+}
+
+/**
+ * Register item with given rectangle
+ */
+void
+ItemGrid::insert( QGraphicsItem *item, const QRectF &rect)
+{
+    GVIEW_ASSERTD( !contains( item), "Item is already in grid");
+    rects[ item] = rect;
+    addToCells( item, cellRange( rect));
+    bounding_rect = bounding_rect.isNull() ? rect : bounding_rect.united( rect);
+}
+
+/**
+ * Remove item
+ */
+void
+ItemGrid::remove( QGraphicsItem *item)
+{
+    QHash< QGraphicsItem *, QRectF>::iterator it = rects.find( item);
+
+    if ( it == rects.end())
+        return;
+    removeFromCells( item, cellRange( it.value()));
+    rects.erase( it);
+}
+
+/**
+ * Change rectangle of registered item, cells are updated only if the item moves to other ones
+ */
+void
+ItemGrid::move( QGraphicsItem *item, const QRectF &rect)
+{
+    QHash< QGraphicsItem *, QRectF>::iterator it = rects.find( item);
+
+    GVIEW_ASSERTD( it != rects.end(), "Item is not in grid");
+
+    QRect old_range = cellRange( it.value());
+    QRect new_range = cellRange( rect);
+
+    it.value() = rect;
+    if ( old_range != new_range)
+    {
+        removeFromCells( item, old_range);
+        addToCells( item, new_range);
+    }
+    bounding_rect = bounding_rect.united( rect);
+}
+
+/**
+ * Add items of cell that overlap the query to result. Item is reported
+ * from the first of its cells in query only
+ */
+void
+ItemGrid::collect( int x, int y,
+                   const QVector< QGraphicsItem *> &cell_items,
+                   const QRect &range,
+                   const QRectF &rect,
+                   QList< QGraphicsItem *> &res) const
+{
+    foreach ( QGraphicsItem *item, cell_items)
+    {
+        QRectF item_rect = rects.value( item);
+        QRect item_range = cellRange( item_rect);
+
+        if ( x == qMax( item_range.left(), range.left())
+             && y == qMax( item_range.top(), range.top())
+             && overlaps( item_rect, rect))
+        {
+            res << item;
+        }
+    }
+}
+
+/**
+ * Get items whose rectangles overlap given one. When query covers more cells than
+ * there are non-empty ones, non-empty cells are visited instead of looking up the query's ones
+ */
+QList< QGraphicsItem *>
+ItemGrid::items( const QRectF &rect) const
+{
+    QList< QGraphicsItem *> res;
+    QRect range = cellRange( rect);
+    qint64 range_size = ( qint64)range.width() * range.height();
+    QHash< quint64, QVector< QGraphicsItem *> >::const_iterator cell;
+
+    if ( range_size > cells.count())
+    {
+        for ( cell = cells.constBegin(); cell != cells.constEnd(); ++cell)
+        {
+            int x = ( qint32)( cell.key() >> 32);
+            int y = ( qint32)( cell.key() & 0xffffffff);
+
+            if ( range.contains( x, y))
+                collect( x, y, cell.value(), range, rect, res);
+        }
+        return res;
+    }
+    for ( int x = range.left(); x <= range.right(); x++)
+    {
+        for ( int y = range.top(); y <= range.bottom(); y++)
+        {
+            cell = cells.constFind( cellKey( x, y));
+            if ( cell != cells.constEnd())
+                collect( x, y, cell.value(), range, rect, res);
+        }
+    }
+    return res;
+}
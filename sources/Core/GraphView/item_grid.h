@@ -0,0 +1,91 @@
+/**
+ * @file: item_grid.h
+ * Spatial index of graph items
+ * @ingroup GUIGraph
+ */
+/*
+ * GUI for ShowGraph tool.
+ * Copyright (c) 2009, Boris Shurygin
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef ITEM_GRID_H
+#define ITEM_GRID_H
+
+/**
+ * Uniform grid over scene rectangles of graph items
+ * @ingroup GUIGraph
+ *
+ * Each item is registered in the cells its rectangle overlaps. Insertion, removal and move
+ * touch only these cells, so the grid is cheap to keep up to date while items are dragged
+ * or animated. Query visits the cells overlapped by the query rectangle and reports each
+ * item once, from the first of its cells that falls into the query.
+ */
+class ItemGrid
+{
+    /** Items that overlap each cell, cells are keyed by packed coordinates */
+    QHash< quint64, QVector< QGraphicsItem *> > cells;
+    /** Rectangle each item is registered with */
+    QHash< QGraphicsItem *, QRectF> rects;
+    /** Rectangle that covers all registered rectangles */
+    QRectF bounding_rect;
+
+    /** Get range of cells that rectangle overlaps */
+    static QRect cellRange( const QRectF &rect);
+    /** Get key of cell */
+    static inline quint64 cellKey( int x, int y)
+    {
+        return ( ( quint64)( quint32) x << 32) | ( quint32) y;
+    }
+    /** Add item to cells of range */
+    void addToCells( QGraphicsItem *item, const QRect &range);
+    /** Remove item from cells of range */
+    void removeFromCells( QGraphicsItem *item, const QRect &range);
+    /** Add items of cell that overlap the query to result */
+    void collect( int x, int y,
+                  const QVector< QGraphicsItem *> &cell_items,
+                  const QRect &range,
+                  const QRectF &rect,
+                  QList< QGraphicsItem *> &res) const;
+public:
+    /** Constructor */
+    ItemGrid();
+
+    /** Remove all items */
+    void clear();
+    /** Register item with given rectangle */
+    void insert( QGraphicsItem *item, const QRectF &rect);
+    /** Remove item */
+    void remove( QGraphicsItem *item);
+    /** Change rectangle of registered item */
+    void move( QGraphicsItem *item, const QRectF &rect);
+    /** Get items whose rectangles overlap given one */
+    QList< QGraphicsItem *> items( const QRectF &rect) const;
+
+    /** Check if item is registered */
+    inline bool contains( QGraphicsItem *item) const
+    {
+        return rects.contains( item);
+    }
+    /** Get number of registered items */
+    inline int count() const
+    {
+        return rects.count();
+    }
+    /** Get rectangle that covers all items, it doesn't shrink when items are removed */
+    inline QRectF boundingRect() const
+    {
+        return bounding_rect;
+    }
+};
+
+#endif /* ITEM_GRID_H */
@@ -0,0 +1,335 @@
+/**
+ * @file: layout_cache.cpp
+ * Implementation of persistent layout cache
+ * @ingroup GUIGraph
+ */
+/*
+ * GUI for ShowGraph tool.
+ * Copyright (c) 2009, Boris Shurygin
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "gview_impl.h"
+
+/** Edge control chain read from cache */
+struct CachedChain
+{
+    /** Type of chain's edges */
+    quint8 type;
+    /** Positions of edge controls from predecessor to successor */
+    QVector< QPointF> controls;
+};
+
+/** Compare nodes by id */
+static bool compareIds( GNode *n1, GNode *n2)
+{
+    return n1->id() < n2->id();
+}
+
+/** Find successor at the end of edge control chain */
+static GNode *chainSucc( GEdge *edge)
+{
+    GNode *succ = edge->succ();
+    while ( succ->isEdgeControl())
+    {
+        assert( isNotNullP( succ->firstSucc()));
+        succ = succ->firstSucc()->succ();
+    }
+    return succ;
+}
+
+/**
+ * Constructor. Cache is placed in system's cache location
+ */
+LayoutCache::LayoutCache()
+{
+    QString location = QDesktopServices::storageLocation( QDesktopServices::CacheLocation);
+    if ( location.isEmpty())
+    {
+        location = QDir::tempPath() + "/showgraph";
+    }
+    dir_name = location + "/layout";
+}
+
+/**
+ * Cache file name
+ */
+QString
+LayoutCache::fileName( const QByteArray &key) const
+{
+    return dir_name + "/" + QString( key.toHex()) + ".lcache";
+}
+
+/**
+ * Compute key that identifies graph structure and layout parameters.
+ * Nodes and edges are sorted so that the key doesn't depend on list order
+ * and on presence of edge controls left by previous layout
+ */
+QByteArray
+LayoutCache::graphKey( GGraph *graph)
+{
+    QByteArray data;
+    QDataStream stream( &data, QIODevice::WriteOnly);
+    stream.setVersion( QDataStream::Qt_4_6);
+
+    stream << LAYOUT_CACHE_VERSION
+           << NODE_NODE_MARGIN << NODE_CONTROL_MARGIN << CONTROL_CONTROL_MARGIN
+           << EDGE_CONTROL_WIDTH << EDGE_CONTROL_HEIGHT
+           << RANK_SPACING << COMPONENT_SPACING
+           << ( qint32)graph->cycleBreaking()
+           << ( qint32)graph->layoutEngine() << graph->isForceMultilevel()
+           << graph->isDeterministic();
+
+    QList< GNode *> nodes;
+    GNode *n;
+    foreachNode( n, graph)
+    {
+        if ( !n->isEdgeControl())
+            nodes << n;
+    }
+    qSort( nodes.begin(), nodes.end(), compareIds);
+    stream << ( quint32)nodes.count();
+    foreach ( n, nodes)
+    {
+        stream << ( quint64)n->id() << ( qint32)n->type() << n->width() << n->height();
+    }
+
+    QVector< QPair< quint64, quint64> > edges;
+    GEdge *e;
+    foreachEdge( e, graph)
+    {
+        if ( !e->pred()->isEdgeControl())
+            edges << qMakePair( ( quint64)e->pred()->id(), ( quint64)chainSucc( e)->id());
+    }
+    qSort( edges.begin(), edges.end());
+    stream << ( quint32)edges.count();
+    for ( int i = 0; i < edges.count(); i++)
+    {
+        stream << edges[ i].first << edges[ i].second;
+    }
+    return QCryptographicHash::hash( data, QCryptographicHash::Sha1);
+}
+
+/**
+ * Read cached layout and apply it to graph.
+ * Graph is changed only if the whole entry was read successfully
+ */
+bool
+LayoutCache::load( GGraph *graph, const QByteArray &key) const
+{
+    QFile file( fileName( key));
+
+    if ( !file.open( QIODevice::ReadOnly))
+        return false;
+
+    QDataStream stream( &file);
+    stream.setVersion( QDataStream::Qt_4_6);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    QByteArray stored_key;
+
+    stream >> magic >> version;
+    if ( magic != LAYOUT_CACHE_MAGIC || version != LAYOUT_CACHE_VERSION)
+        return false;
+    stream >> stored_key;
+    if ( stored_key != key)
+        return false;
+
+    /** Node coordinates */
+    quint32 node_num = 0;
+    stream >> node_num;
+    QHash< quint64, QPointF> positions;
+    positions.reserve( node_num);
+    for ( quint32 i = 0; i < node_num && stream.status() == QDataStream::Ok; i++)
+    {
+        quint64 id;
+        qreal x;
+        qreal y;
+        stream >> id >> x >> y;
+        positions.insert( id, QPointF( x, y));
+    }
+
+    /** Edge control chains */
+    quint32 chain_num = 0;
+    stream >> chain_num;
+    QHash< QPair< quint64, quint64>, QList< CachedChain> > chains;
+    for ( quint32 i = 0; i < chain_num && stream.status() == QDataStream::Ok; i++)
+    {
+        quint64 pred_id;
+        quint64 succ_id;
+        quint32 control_num;
+        CachedChain chain;
+
+        stream >> pred_id >> succ_id >> chain.type >> control_num;
+        chain.controls.resize( control_num);
+        for ( quint32 j = 0; j < control_num; j++)
+        {
+            stream >> chain.controls[ j];
+        }
+        chains[ qMakePair( pred_id, succ_id)] << chain;
+    }
+    if ( stream.status() != QDataStream::Ok)
+        return false;
+
+    /** Entry should cover every node, edge controls are replaced by cached ones */
+    GNode *n;
+    foreachNode( n, graph)
+    {
+        if ( !n->isEdgeControl() && !positions.contains( n->id()))
+            return false;
+    }
+
+    /** Apply layout */
+    graph->deleteEdgeControls();
+
+    foreachNode( n, graph)
+    {
+        QPointF pos = positions.value( n->id());
+        n->setX( pos.x());
+        n->setY( pos.y());
+    }
+
+    QList< GEdge *> edges;
+    GEdge *e;
+    foreachEdge( e, graph)
+    {
+        edges << e;
+    }
+    foreach ( e, edges)
+    {
+        QPair< quint64, quint64> ends = qMakePair( ( quint64)e->pred()->id(), ( quint64)e->succ()->id());
+        if ( !chains.contains( ends) || chains[ ends].isEmpty())
+            continue;
+
+        CachedChain chain = chains[ ends].takeFirst();
+        GEdge *curr_edge = e;
+
+        curr_edge->setType( ( AuxEdgeType)chain.type);
+        foreach ( QPointF pos, chain.controls)
+        {
+            GNode *node = static_cast< GNode *>( curr_edge->insertNode());
+            node->setType( AUX_EDGE_CONTROL);
+            node->setX( pos.x());
+            node->setY( pos.y());
+            curr_edge = node->firstSucc();
+            curr_edge->setType( ( AuxEdgeType)chain.type);
+        }
+    }
+    return true;
+}
+
+/**
+ * Write layout of graph to cache file.
+ * Data is written to temporary file first so that concurrent readers never see partial entry
+ */
+bool
+LayoutCache::save( GGraph *graph, const QByteArray &key) const
+{
+    if ( !QDir().mkpath( dir_name))
+        return false;
+
+    QString name = fileName( key);
+    QFile file( name + ".tmp");
+
+    if ( !file.open( QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    QDataStream stream( &file);
+    stream.setVersion( QDataStream::Qt_4_6);
+    stream << LAYOUT_CACHE_MAGIC << LAYOUT_CACHE_VERSION << key;
+
+    /** Node coordinates */
+    quint32 node_num = 0;
+    GNode *n;
+    foreachNode( n, graph)
+    {
+        if ( !n->isEdgeControl())
+            node_num++;
+    }
+    stream << node_num;
+    foreachNode( n, graph)
+    {
+        if ( !n->isEdgeControl())
+            stream << ( quint64)n->id() << ( qreal)n->modelX() << ( qreal)n->modelY();
+    }
+
+    /** Edge control chains */
+    quint32 chain_num = 0;
+    GEdge *e;
+    foreachEdge( e, graph)
+    {
+        if ( !e->pred()->isEdgeControl())
+            chain_num++;
+    }
+    stream << chain_num;
+    foreachEdge( e, graph)
+    {
+        if ( e->pred()->isEdgeControl())
+            continue;
+
+        QVector< QPointF> controls;
+        GNode *succ = e->succ();
+        while ( succ->isEdgeControl())
+        {
+            controls << QPointF( succ->modelX(), succ->modelY());
+            succ = succ->firstSucc()->succ();
+        }
+        stream << ( quint64)e->pred()->id() << ( quint64)succ->id()
+               << ( quint8)e->type() << ( quint32)controls.count();
+        foreach ( QPointF pos, controls)
+        {
+            stream << pos;
+        }
+    }
+    if ( stream.status() != QDataStream::Ok)
+    {
+        file.remove();
+        return false;
+    }
+    file.close();
+    QFile::remove( name);
+    if ( !file.rename( name))
+        return false;
+    evict();
+    return true;
+}
+
+/**
+ * Remove entries with the oldest modification time until number of entries
+ * and their total size fit into LAYOUT_CACHE_MAX_ENTRIES and LAYOUT_CACHE_MAX_SIZE
+ */
+void
+LayoutCache::evict() const
+{
+    QFileInfoList entries = QDir( dir_name).entryInfoList( QStringList( "*.lcache"),
+                                                           QDir::Files,
+                                                           QDir::Time | QDir::Reversed);
+    qint64 total_size = 0;
+    int entry_num = entries.count();
+
+    foreach ( const QFileInfo &info, entries)
+    {
+        total_size += info.size();
+    }
+    /** Entries go from the oldest to the newest, the newest one is always kept */
+    for ( int i = 0; i + 1 < entries.count(); i++)
+    {
+        if ( entry_num <= LAYOUT_CACHE_MAX_ENTRIES && total_size <= LAYOUT_CACHE_MAX_SIZE)
+            break;
+        if ( QFile::remove( entries[ i].filePath()))
+        {
+            entry_num--;
+            total_size -= entries[ i].size();
+        }
+    }
+}
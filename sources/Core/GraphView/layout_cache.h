@@ -0,0 +1,82 @@
+/**
+ * @file: layout_cache.h
+ * Persistent cache of graph layouts
+ * @ingroup GUIGraph
+ */
+/*
+ * GUI for ShowGraph tool.
+ * Copyright (c) 2009, Boris Shurygin
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef LAYOUT_CACHE_H
+#define LAYOUT_CACHE_H
+
+/** Signature of layout cache file */
+const quint32 LAYOUT_CACHE_MAGIC = 0x53474c43;
+
+/** Version of layout cache file format, increment when format or layout algorithm changes */
+const quint32 LAYOUT_CACHE_VERSION = 2;
+
+/** Maximal number of entries in layout cache, the oldest ones are removed on save */
+const int LAYOUT_CACHE_MAX_ENTRIES = 256;
+
+/** Maximal total size of layout cache files in bytes */
+const qint64 LAYOUT_CACHE_MAX_SIZE = 64 * 1024 * 1024;
+
+/**
+ * On-disk cache of computed layouts
+ * @ingroup GUIGraph
+ *
+ * Layout is stored in a file named after the structural key of the graph.
+ * The key covers node ids, types and sizes, logical edges ( with edge controls skipped)
+ * and layout parameters so a graph that is opened again gets its coordinates
+ * without running the layout. File consists of a header ( signature, version, key)
+ * followed by node coordinates and edge control chains.
+ * Number of entries and their total size are limited, entries with the oldest
+ * modification time are removed when a new one is saved.
+ */
+class LayoutCache
+{
+    /** Directory for cache files */
+    QString dir_name;
+
+    /** Name of file for given key */
+    QString fileName( const QByteArray &key) const;
+    /** Remove the oldest entries that exceed limits of cache */
+    void evict() const;
+public:
+    /** Constructor with default directory */
+    LayoutCache();
+
+    /** Get cache directory */
+    inline QString dir() const
+    {
+        return dir_name;
+    }
+    /** Set cache directory */
+    inline void setDir( QString name)
+    {
+        dir_name = name;
+    }
+
+    /** Compute structural key of graph */
+    static QByteArray graphKey( GGraph *graph);
+
+    /** Restore layout from cache, returns false if there is no valid entry */
+    bool load( GGraph *graph, const QByteArray &key) const;
+
+    /** Store current layout in cache */
+    bool save( GGraph *graph, const QByteArray &key) const;
+};
+
+#endif /* LAYOUT_CACHE_H */
@@ -23,18 +23,21 @@
 
 /** Constant for adjusting item's border rectangle */
 const qreal box_adjust = 5;
+/** Margin around label text, the same as the default margin of text document used by editor */
+const qreal text_margin = 4;
         
 
 /** We can't create nodes separately, do it through newNode method of graph */
 GNode::GNode( GGraph *graph_p, int _id):
     AuxNode( ( AuxGraph *)graph_p, _id),
-	_doc( NULL),
+	node_text(),
 	ir_id( GRAPH_MAX_NODE_NUM),
 	text_shown( false),
     _style( NULL)
 {
     item_p = new NodeItem( this);
-    graph()->view()->scene()->addItem( item_p);
+    graph()->view()->addGraphItem( item_p);
+    graph()->view()->textIndex()->addNode( this);
 	setIRId( id());
     graph()->invalidateRanking();
     if ( graph()->view()->isContext())
@@ -48,14 +51,15 @@ GNode::GNode( GGraph *graph_p, int _id):
 /** Contructor of node with specified position */
 GNode::GNode( GGraph *graph_p, int _id, QPointF _pos):
     AuxNode( ( AuxGraph *)graph_p, _id),
-	_doc( NULL),
+	node_text(),
 	ir_id( GRAPH_MAX_NODE_NUM),
 	text_shown( false),
     _style( NULL)
 {
     item_p = new NodeItem( this);
     item_p->setPos( _pos);
-	graph()->view()->scene()->addItem( item_p);
+	graph()->view()->addGraphItem( item_p);
+    graph()->view()->textIndex()->addNode( this);
 	setIRId( id());
     graph()->invalidateRanking();
     if ( graph()->view()->isContext())
@@ -66,12 +70,24 @@ GNode::GNode( GGraph *graph_p, int _id, QPointF _pos):
     }
 }
 
+/**
+ * Set node's text and index it for search
+ */
+void
+GNode::setText( const QString &text)
+{
+    node_text = text;
+    graph()->view()->textIndex()->textChanged( this);
+}
+
 /**
  * Destructor for node - removes edge controls on incidient edges and disconnects item from scene
  */
 GNode::~GNode()
 {
+    graph()->view()->textIndex()->removeNode( this);
     graph()->invalidateRanking();
+    graph()->removeFromContext( this);
     if ( ( isEdgeControl() || isEdgeLabel())
          && isNotNullP( firstPred()) 
          && isNotNullP( firstSucc())
@@ -132,7 +148,6 @@ GNode::~GNode()
     graph()->view()->viewHistory()->eraseNode( this);
     item()->remove();
     graph()->view()->deleteLaterNodeItem( item());
-    delete _doc;
             
     if ( isNotNullP( _style))
         _style->decNumItems();
@@ -226,6 +241,29 @@ bool GNode::isNodeInFocus() const
 
 /*********************** NodeItem implementation ***************************************/
 
+/**
+ * Text item that edits node's label, it lives only while label is edited
+ */
+class NodeTextEditor: public QGraphicsTextItem
+{
+public:
+    /** Constructor */
+    NodeTextEditor( NodeItem *parent): QGraphicsTextItem( parent){};
+
+    /** Node is adjusted to the text as it is typed */
+    void keyPressEvent( QKeyEvent *event)
+    {
+        QGraphicsTextItem::keyPressEvent( event);
+        static_cast< NodeItem *>( parentItem())->textEdited();
+    }
+    /** Editing ends when editor loses focus */
+    void focusOutEvent( QFocusEvent *event)
+    {
+        QGraphicsTextItem::focusOutEvent( event);
+        static_cast< NodeItem *>( parentItem())->finishEditing();
+    }
+};
+
 
 /** Initialization */
 void 
@@ -240,12 +278,160 @@ NodeItem::SetInitFlags()
     setCacheMode( DeviceCoordinateCache);
     setZValue(2);
     QGraphicsItem::setCursor( Qt::ArrowCursor);
-    /**
-     * Sets text to create text control. 
-     * FIXME: Should find a way to prevent this for edgeControl nodes, since text
-     *        contol is not needed for them and this procedure is quite expensive
-     */
-    setPlainText( "");
+    static_text.setTextFormat( Qt::PlainText);
+}
+
+/**
+ * Font of labels, static text is laid out and painted with it
+ */
+QFont
+NodeItem::labelFont()
+{
+    return QFont();
+}
+
+/**
+ * Lay out label for painting
+ */
+void
+NodeItem::updateStaticText()
+{
+    QString str( label);
+
+    /** Static text breaks lines on line separators only */
+    str.replace( QChar( '\n'), QChar( QChar::LineSeparator));
+    static_text.setText( str);
+    static_text.prepare( QTransform(), labelFont());
+}
+
+/**
+ * Get text of label
+ */
+QString
+NodeItem::toPlainText() const
+{
+    if ( isNotNullP( editor))
+        return editor->toPlainText();
+    return label;
+}
+
+/**
+ * Set text of label
+ */
+void
+NodeItem::setPlainText( const QString &text)
+{
+    prepareGeometryChange();
+    label = text;
+    updateStaticText();
+    if ( isNotNullP( editor))
+        editor->setPlainText( text);
+    update();
+}
+
+/**
+ * Height of line of label font, font metrics are computed once
+ */
+static qreal
+labelLineHeight()
+{
+    static qreal line_height = QFontMetricsF( NodeItem::labelFont()).height();
+    return line_height;
+}
+
+/**
+ * Rectangle occupied by label text with margins
+ */
+QRectF
+NodeItem::textRect() const
+{
+    if ( isNotNullP( editor))
+        return editor->boundingRect();
+
+    QSizeF size = static_text.size();
+    qreal line_height = labelLineHeight();
+
+    return QRectF( 0, 0,
+                   size.width() + 2 * text_margin,
+                   qMax( size.height(), line_height) + 2 * text_margin);
+}
+
+/**
+ * Turn label into editable text item
+ */
+void
+NodeItem::startEditing()
+{
+    if ( isNotNullP( editor))
+        return;
+
+    prepareGeometryChange();
+    editor = new NodeTextEditor( this);
+    editor->setFont( labelFont());
+    editor->setPlainText( label);
+    editor->setTextInteractionFlags( Qt::TextEditorInteraction);
+    editor->setFocus( Qt::MouseFocusReason);
+    update();
+}
+
+/**
+ * Take text from editor and return to static label
+ */
+void
+NodeItem::finishEditing()
+{
+    if ( isNullP( editor))
+        return;
+
+    /** Editor is detached first as its removal from scene makes it lose focus again */
+    NodeTextEditor *ed = editor;
+
+    prepareGeometryChange();
+    editor = NULL;
+    label = ed->toPlainText();
+    updateStaticText();
+    ed->setParentItem( NULL);
+    if ( isNotNullP( ed->scene()))
+        ed->scene()->removeItem( ed);
+    ed->deleteLater();
+    setFlag( ItemIsMovable, true);
+    if ( isNotNullP( node_p))
+        adjustAssociates();
+    update();
+}
+
+/**
+ * Remove from scene, item is disconnected from node
+ */
+void
+NodeItem::remove()
+{
+    finishEditing();
+    node_p->graph()->view()->stopAnimation( this);
+    setVisible( false);
+    removeFromIndex();
+    node_p->graph()->view()->removeGraphItem( this);
+    node_p = NULL;
+}
+
+/**
+ * Adjust node to the text typed in editor, size of item changes
+ */
+void
+NodeItem::textEdited()
+{
+    GEdge *edge = NULL;
+
+    prepareGeometryChange();
+    for ( edge = node()->firstSucc(); isNotNullP( edge); edge = edge->nextSucc())
+    {
+        edge->item()->adjust();
+    }
+    for ( edge = node()->firstPred(); isNotNullP( edge); edge = edge->nextPred())
+    {
+        edge->item()->adjust();
+    }
+    update();
 }
 
 /** Path of box type that given inner rectangle */
@@ -391,16 +577,14 @@ NodeItem::borderRect() const
 
     if ( node()->isEdgeControl())
     {
-        qreal adjust = 2;
-        return QRectF( -EdgeControlSize - adjust, -EdgeControlSize - adjust,
-              2*( EdgeControlSize + adjust), 2*( EdgeControlSize + adjust));
+        return controlBorderRect();
     } else if ( node()->isEdgeLabel())
     {
-        return QGraphicsTextItem::boundingRect()
+        return textRect()
             .adjusted( -box_adjust, -box_adjust, box_adjust, box_adjust);    
     } else
     {
-        QRectF rect =  QGraphicsTextItem::boundingRect();
+        QRectF rect =  textRect();
         if ( isNotNullP( node()->style()))
         {
             return shape2Rect( node()->style()->shape(), rect);
@@ -411,6 +595,17 @@ NodeItem::borderRect() const
     }
 }
 
+/**
+ * Border rectangle of edge control, it doesn't depend on text
+ */
+QRectF
+NodeItem::controlBorderRect()
+{
+    qreal adjust = 2;
+    return QRectF( -EdgeControlSize - adjust, -EdgeControlSize - adjust,
+          2*( EdgeControlSize + adjust), 2*( EdgeControlSize + adjust));
+}
+
 /**
  * Overload of QGraphicsItem::bounding rectangle
  */
@@ -422,32 +617,106 @@ NodeItem::boundingRect() const
 }
 
 /**
- * Shape of NodeItem: circle for EdgeControl and rectangle for simple
+ * Key of outline in cache of shared outlines
  */
-QPainterPath 
-NodeItem::shape() const
+struct NodeOutlineKey
 {
-    if ( isNullP( node_p))
-        return QPainterPath();
+    /** Kind of outline */
+    int kind;
+    /** Text rectangle */
+    QRectF text_rect;
+
+    /** Constructor */
+    NodeOutlineKey( int k, const QRectF &rect): kind( k), text_rect( rect)
+    {
+
+    }
+    /** Comparison */
+    inline bool operator == ( const NodeOutlineKey &key) const
+    {
+        return kind == key.kind && text_rect == key.text_rect;
+    }
+};
+
+/** Hash of outline key, coordinates are taken with 1/64 of pixel precision */
+inline uint qHash( const NodeOutlineKey &key)
+{
+    return ( uint)qRound( key.text_rect.width() * 64) * 31
+           ^ ( uint)qRound( key.text_rect.height() * 64) * 17
+           ^ ( uint)qRound( ( key.text_rect.left() + key.text_rect.top()) * 64) * 7
+           ^ ( uint)key.kind;
+}
+
+/**
+ * Get outline of given kind around given text rectangle. Nodes with equal text
+ * size share outlines through a cache that is dropped when it grows too big
+ */
+static NodeOutline
+sharedOutline( int kind, const QRectF &text_rect)
+{
+    static QHash< NodeOutlineKey, NodeOutline> outlines;
+    NodeOutlineKey key( kind, text_rect);
+    QHash< NodeOutlineKey, NodeOutline>::const_iterator it = outlines.constFind( key);
+
+    if ( it != outlines.constEnd())
+        return it.value();
+
+    NodeOutline outline;
+
+    outline.kind = kind;
+    outline.text_rect = text_rect;
+    if ( kind == NODE_OUTLINE_CONTROL)
+    {
+        outline.path.addEllipse( -EdgeControlSize, -EdgeControlSize, 2*EdgeControlSize, 2*EdgeControlSize);
+    } else if ( kind == NODE_OUTLINE_PLAIN)
+    {
+        outline.path.addRect( text_rect.adjusted( -box_adjust, -box_adjust, box_adjust, box_adjust));
+    } else
+    {
+        outline.path = shape2Path( ( NodeShape)kind, text_rect);
+    }
+    outline.polygon = outline.path.toFillPolygon();
+
+    if ( outlines.count() >= NODE_OUTLINE_CACHE_SIZE)
+        outlines.clear();
+    outlines.insert( key, outline);
+    return outline;
+}
+
+/**
+ * Get outline of node. Kind and text rectangle are compared with the ones of
+ * the cached outline, so edited text and changed style are noticed without notification
+ */
+const NodeOutline &
+NodeItem::outline() const
+{
+    int kind = NODE_OUTLINE_PLAIN;
+    QRectF rect;
 
     if ( node()->isEdgeControl())
     {
-        QPainterPath path;
-        path.addEllipse( -EdgeControlSize, -EdgeControlSize, 2*EdgeControlSize, 2*EdgeControlSize);
-        return path; 
+        kind = NODE_OUTLINE_CONTROL;
     } else
     {
-        QRectF rect =  QGraphicsTextItem::boundingRect();
+        rect = textRect();
         if ( isNotNullP( node()->style()))
-        {
-            return shape2Path( node()->style()->shape(), rect);
-        } else
-        {
-            QPainterPath path;
-            path.addRect( borderRect());
-            return path;
-        }
+            kind = node()->style()->shape();
     }
+    if ( kind != outline_cache.kind || rect != outline_cache.text_rect)
+        outline_cache = sharedOutline( kind, rect);
+    return outline_cache;
+}
+
+/**
+ * Shape of NodeItem: circle for EdgeControl and outline of style's shape for simple
+ */
+QPainterPath 
+NodeItem::shape() const
+{
+    if ( isNullP( node_p))
+        return QPainterPath();
+
+    return outline().path;
 }
 
 bool NodeItem::contains(const QPointF &point) const
@@ -503,19 +772,33 @@ NodeItem::paint( QPainter *painter,
 
         if ( node()->isSimple())
         {
-            QRectF rect =  QGraphicsTextItem::boundingRect();
-            if ( isNotNullP( node()->style()))
-            {
-                painter->drawPath( shape2Path( node()->style()->shape(), rect));
-            } else
+            QRectF rect =  textRect();
+            painter->drawPath( outline().path);
+            if ( folded)
             {
-                painter->drawRect( borderRect());
+                painter->setBrush( Qt::NoBrush);
+                if ( isNotNullP( node()->style()))
+                {
+                    painter->drawPath( shape2Path( node()->style()->shape(),
+                                                   rect.adjusted( adjust, adjust, -adjust, -adjust)));
+                } else
+                {
+                    painter->drawRect( borderRect().adjusted( adjust, adjust, -adjust, -adjust));
+                }
             }
         }
-        if ( option->levelOfDetail >= 0.2)
+        /** Editor paints the text itself while label is edited */
+        if ( option->levelOfDetail >= 0.2 && isNullP( editor))
         {
-            if ( painter->isActive())     
-                QGraphicsTextItem::paint( painter, option, widget);
+            painter->setFont( labelFont());
+            painter->setPen( option->palette.text().color());
+            painter->drawStaticText( QPointF( text_margin, text_margin), static_text);
+            if ( option->state & QStyle::State_Selected)
+            {
+                painter->setPen( QPen( option->palette.windowText(), 0, Qt::DashLine));
+                painter->setBrush( Qt::NoBrush);
+                painter->drawRect( textRect());
+            }
         }
     } else if ( node()->isEdgeControl())
     {
@@ -559,7 +842,7 @@ void NodeItem::mousePressEvent( QGraphicsSceneMouseEvent *event)
         node()->firstPred()->item()->setSelected( true);
         node()->firstSucc()->item()->setSelected( true);
     }
-    QGraphicsTextItem::mousePressEvent(event);
+    QGraphicsItem::mousePressEvent(event);
     update();
 }
 
@@ -600,7 +883,7 @@ void NodeItem::mouseReleaseEvent( QGraphicsSceneMouseEvent *event)
         }
 	}
 	if ( call_baseclass)
-        QGraphicsTextItem::mouseReleaseEvent( event);
+        QGraphicsItem::mouseReleaseEvent( event);
 	update();
     setFlag( ItemIsMovable, true);
 }
@@ -610,17 +893,20 @@ void NodeItem::mouseReleaseEvent( QGraphicsSceneMouseEvent *event)
  */
 void NodeItem::mouseDoubleClickEvent(QGraphicsSceneMouseEvent *event)
 {
+    GGraph *graph = node()->graph();
+
+    /** Double click on folded node opens it up */
+    if ( graph->expandNode( node()))
+    {
+        graph->doLayout();
+        return;
+    }
     setFlag( ItemIsMovable, false);
     if ( node()->graph()->view()->isEditable())
     {
         if ( event->button() & Qt::LeftButton && !node()->isEdgeControl())
         {
-            if ( textInteractionFlags() == Qt::NoTextInteraction)
-            {
-                setTextInteractionFlags(Qt::TextEditorInteraction);
-                setFocus( Qt::MouseFocusReason);
-            }
-			    //QGraphicsTextItem::mousePressEvent(event);
+            startEditing();
         }
     } else
     {
@@ -628,69 +914,45 @@ void NodeItem::mouseDoubleClickEvent(QGraphicsSceneMouseEvent *event)
     }
 }
 
-void NodeItem::focusOutEvent(QFocusEvent *event)
-{
-    setTextInteractionFlags(Qt::NoTextInteraction);
-	QGraphicsTextItem::focusOutEvent(event);
-    setFlag( ItemIsFocusable, true);
-}
-
 /**
- * We should adjust edges when entering the text as the size of item changes
+ * Arrow keys move focus to edges, text is typed to editor item
  */
 void NodeItem::keyPressEvent(QKeyEvent *event)
 {
-    
-    prepareGeometryChange();
-    if ( textInteractionFlags() == Qt::TextEditorInteraction)
+    int key = event->key();
+    GEdge *edge = NULL;
+    NavSector sector = UNDEF_SECTOR;
+    if ( node()->isNodeInFocus())
     {
-        GEdge *edge = NULL;
-        QGraphicsTextItem::keyPressEvent(event);
-        for ( edge = node()->firstSucc(); isNotNullP( edge); edge = edge->nextSucc())
+        switch( key)
         {
-            edge->item()->adjust();
+            case Qt::Key_Up:
+                sector = TOP_SECTOR;
+                break;
+            case Qt::Key_Down:
+                sector = BOTTOM_SECTOR;
+                break;
+            case Qt::Key_Left:
+                sector = LEFT_SECTOR;
+                break;
+            case Qt::Key_Right:
+                sector = RIGHT_SECTOR;
+                break;
+            default:
+                sector = UNDEF_SECTOR;
+                break;
         }
-        for ( edge = node()->firstPred(); isNotNullP( edge); edge = edge->nextPred())
+        
+        node()->graph()->setNodeInFocus( node(), sector);
+        edge = NodeNav( node(), sector).firstEdgeInSector();
+                
+        if ( isNotNullP( edge))
         {
-            edge->item()->adjust();
-        }
-    } else
-    {
-        int key = event->key();
-        GEdge *edge = NULL;
-        NavSector sector = UNDEF_SECTOR;
-        if ( node()->isNodeInFocus())
-        {
-            switch( key)
-            {
-                case Qt::Key_Up:
-                    sector = TOP_SECTOR;
-                    break;
-                case Qt::Key_Down:
-                    sector = BOTTOM_SECTOR;
-                    break;
-                case Qt::Key_Left:
-                    sector = LEFT_SECTOR;
-                    break;
-                case Qt::Key_Right:
-                    sector = RIGHT_SECTOR;
-                    break;
-                default:
-                    sector = UNDEF_SECTOR;
-                    break;
-            }
-            
-            node()->graph()->setNodeInFocus( node(), sector);
-            edge = NodeNav( node(), sector).firstEdgeInSector();
-                    
-            if ( isNotNullP( edge))
-            {
-                // Get focus on edge
-                scene()->clearFocus();
-                scene()->clearSelection();
-                edge->item()->setFocus();
-                edge->item()->setSelected( true);
-            }
+            // Get focus on edge
+            scene()->clearFocus();
+            scene()->clearSelection();
+            edge->item()->setFocus();
+            edge->item()->setSelected( true);
         }
     }
     update();
@@ -698,14 +960,18 @@ void NodeItem::keyPressEvent(QKeyEvent *event)
 
 /** 
  * Perform animation step
- * Advance node's coordinates and opacity towards goal values of these parameters
+ * Advance node's position and opacity towards target position and node's priority.
+ * Target is kept in item so that model coordinates can change in background layout meanwhile.
+ * Steps are proportional to the time passed, node reaches its target when it is closer than a step.
+ * Edges are not adjusted here, GraphView adjusts edges of all advanced nodes once per frame.
  * Return true if node have advanced somehow. False if node hasn't change
  */
-bool NodeItem::advance()
+bool NodeItem::advance( qreal intervals)
 {
-    QPointF target( node()->modelX(), node()->modelY());
-    QLineF line( pos(), target); 
+    QLineF line( pos(), target_pos); 
     qreal dist = line.length();
+    qreal speed = NODE_SPEED * intervals;
+    qreal opacity_step = OPACITY_STEP * intervals;
     bool changed = false;
 
     if ( !isVisible())
@@ -713,45 +979,79 @@ bool NodeItem::advance()
 
     qreal target_opacity = ((qreal)node()->priority())/ MAX_PRIORITY;
     
-    if ( target_opacity > opacityLevel() + OPACITY_STEP)
+    if ( target_opacity > opacityLevel() + opacity_step)
     {
-        setOpacityLevel( opacityLevel() + OPACITY_STEP);
+        setOpacityLevel( opacityLevel() + opacity_step);
         changed = true;
-    } else if ( target_opacity < opacityLevel() - OPACITY_STEP)
+    } else if ( target_opacity < opacityLevel() - opacity_step)
     {
-        setOpacityLevel( opacityLevel() - OPACITY_STEP);
+        setOpacityLevel( opacityLevel() - opacity_step);
         changed = true;
-    } else
+    } else if ( opacityLevel() != target_opacity)
     {
         setOpacityLevel( target_opacity);
-        if ( !target_opacity)
-        {
-            setVisible( false);
-            changed = true;
-        }
+        changed = true;
     }
-    if ( changed)
+    if ( !target_opacity && !opacityLevel())
     {
-        adjustAssociates();
-        updateAssociates();
-        update();
+        setVisible( false);
+        changed = true;
     }
+    if ( changed)
+        update();
 
-    if ( dist > NODE_SPEED)
+    if ( dist > speed)
     {
-        QPointF displacement( NODE_SPEED * line.dx() / dist, NODE_SPEED * line.dy() / dist);
+        QPointF displacement( speed * line.dx() / dist, speed * line.dy() / dist);
         setPos( pos() + displacement);   
         changed = true;
+    } else if ( dist > 0)
+    {
+        setPos( target_pos);
+        changed = true;
     }
     return changed;
 }
 
+/**
+ * Check if node's position or opacity differ from their targets, hidden nodes are not animated
+ */
+bool NodeItem::isAnimated() const
+{
+    if ( !isVisible())
+        return false;
+
+    qreal target_opacity = ((qreal)node()->priority())/ MAX_PRIORITY;
+
+    return pos() != target_pos
+           || opacityLevel() != target_opacity
+           || !target_opacity;
+}
+
+/**
+ * Check if node is a control of edge chain. Such controls are plain model data,
+ * moving their items changes nothing
+ */
+static bool isChainControl( GNode *n)
+{
+    return n->isEdgeControl()
+           && isNotNullP( n->firstSucc())
+           && isNotNullP( n->firstSucc()->chainItem());
+}
+
 void NodeItem::adjustAssociates()
 {
     GEdge *edge = NULL;
 
+    if ( isChainControl( node()) || node()->graph()->view()->isEdgeRoutingDeferred())
+        return;
     for ( edge = node()->firstSucc(); isNotNullP( edge); edge = edge->nextSucc())
     {
+        if ( isNotNullP( edge->chainItem()))
+        {
+            edge->chainItem()->adjust();
+            continue;
+        }
         edge->item()->adjust();
         GNode* succ = edge->succ();
 
@@ -763,6 +1063,11 @@ void NodeItem::adjustAssociates()
     }
     for ( edge = node()->firstPred(); isNotNullP( edge); edge = edge->nextPred())
     {
+        if ( isNotNullP( edge->chainItem()))
+        {
+            edge->chainItem()->adjust();
+            continue;
+        }
         edge->item()->adjust();
         GNode* pred = edge->pred();
 
@@ -775,12 +1080,64 @@ void NodeItem::adjustAssociates()
     prepareGeometryChange();
 }
 
+/**
+ * Collect edges and edge chains that adjustAssociates() would adjust, so that
+ * edges shared by several moving nodes are adjusted once
+ */
+void NodeItem::collectAssociates( QSet< EdgeItem *> &edges, QSet< EdgeChainItem *> &chains) const
+{
+    GEdge *edge = NULL;
+
+    if ( isChainControl( node()))
+        return;
+    for ( edge = node()->firstSucc(); isNotNullP( edge); edge = edge->nextSucc())
+    {
+        if ( isNotNullP( edge->chainItem()))
+        {
+            chains.insert( edge->chainItem());
+            continue;
+        }
+        edges.insert( edge->item());
+        GNode* succ = edge->succ();
+
+        if ( succ->isEdgeControl() || succ->isEdgeLabel())
+        {
+            assert( isNotNullP( succ->firstSucc()));
+            edges.insert( succ->firstSucc()->item());
+        }
+    }
+    for ( edge = node()->firstPred(); isNotNullP( edge); edge = edge->nextPred())
+    {
+        if ( isNotNullP( edge->chainItem()))
+        {
+            chains.insert( edge->chainItem());
+            continue;
+        }
+        edges.insert( edge->item());
+        GNode* pred = edge->pred();
+
+        if ( pred->isEdgeControl() || pred->isEdgeLabel())
+        {
+            assert( isNotNullP( pred->firstPred()));
+            edges.insert( pred->firstPred()->item());
+        }
+    }
+}
+
 void NodeItem::updateAssociates()
 {
     GEdge *edge = NULL;
 
+    if ( isChainControl( node()))
+        return;
+
     for ( edge = node()->firstSucc(); isNotNullP( edge); edge = edge->nextSucc())
     {
+        if ( isNotNullP( edge->chainItem()))
+        {
+            edge->chainItem()->adjust();
+            continue;
+        }
         edge->item()->adjust();
         GNode* succ = edge->succ();
 
@@ -792,6 +1149,11 @@ void NodeItem::updateAssociates()
     }
     for ( edge = node()->firstPred(); isNotNullP( edge); edge = edge->nextPred())
     {
+        if ( isNotNullP( edge->chainItem()))
+        {
+            edge->chainItem()->adjust();
+            continue;
+        }
         edge->item()->adjust();
         GNode* pred = edge->pred();
 
@@ -809,12 +1171,25 @@ QVariant NodeItem::itemChange( GraphicsItemChange change, const QVariant &value)
 {
     GEdge *edge = NULL;
 
-    if ( change != QGraphicsItem::ItemSceneChange 
-         || change != QGraphicsItem::ItemSceneHasChanged)
+    /** Edges depend on node's geometry only, other changes don't move them */
+    if ( change == QGraphicsItem::ItemPositionHasChanged
+         || change == QGraphicsItem::ItemVisibleHasChanged
+         || change == QGraphicsItem::ItemTransformHasChanged)
     {
         adjustAssociates();
     }
-    return QGraphicsTextItem::itemChange(change, value);
+    if ( change == QGraphicsItem::ItemPositionHasChanged)
+    {
+        node()->graph()->view()->itemMoved( this);
+    } else if ( change == QGraphicsItem::ItemVisibleHasChanged && isNotNullP( node()))
+    {
+        node()->graph()->view()->invalidateOverview();
+    } else if ( change == QGraphicsItem::ItemSceneHasChanged)
+    {
+        /** Pixmap cache is dropped while item is out of scene in virtual scene mode */
+        setCacheMode( isNotNullP( scene()) ? DeviceCoordinateCache : NoCache);
+    }
+    return QGraphicsItem::itemChange(change, value);
 }
 
 
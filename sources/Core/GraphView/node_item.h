@@ -20,20 +20,61 @@
 #ifndef NODE_W_H
 #define NODE_W_H
 
+class NodeTextEditor;
+
+/**
+ * Outline of node, nodes of the same shape and text size share its path and polygon
+ * @ingroup GUIGraph
+ */
+struct NodeOutline
+{
+    /** Kind of outline: shape of node's style, NODE_OUTLINE_CONTROL or NODE_OUTLINE_PLAIN */
+    int kind;
+    /** Text rectangle the outline is built around */
+    QRectF text_rect;
+    /** Outline path */
+    QPainterPath path;
+    /** Outline as polygon, edges are clipped by it */
+    QPolygonF polygon;
+
+    /** Default constructor, the outline matches no node */
+    inline NodeOutline(): kind( -1)
+    {
+
+    }
+};
+
 /**
  * Subclass of QGraphicsItem for representing a node in scene
  * @ingroup GUIGraph
+ * Label is kept as QStaticText that is laid out once and painted from cached glyphs,
+ * so node doesn't own a text document. Text editor item is created only while
+ * user edits the label, see startEditing()
  */
-class NodeItem: public QGraphicsTextItem
+class NodeItem: public QGraphicsItem
 {    
     GNode *node_p;
 	QDockWidget *text_dock;
     qreal opacity;
     bool bold_border;
     bool alternate_background; 
+    /** Whether node stands for a folded part of graph */
+    bool folded;
+    /** Position that animation moves item to */
+    QPointF target_pos;
+    /** Text of label */
+    QString label;
+    /** Label laid out for painting */
+    QStaticText static_text;
+    /** Editor of label, NULL when label is not edited */
+    NodeTextEditor *editor;
+    /** Outline computed for the last shape and text size */
+    mutable NodeOutline outline_cache;
 
     /** Initialization */
     void SetInitFlags();
+    /** Lay out label for painting */
+    void updateStaticText();
 public:
     /** Type of graphics item that corresponds to node */
     enum {Type = TypeNode};
@@ -42,7 +83,13 @@ public:
 	inline NodeItem( GNode *n_p):
         opacity( MAX_OPACITY),
         bold_border( false),
-        alternate_background( false)
+        alternate_background( false),
+        folded( false),
+        target_pos(),
+        label(),
+        static_text(),
+        editor( NULL),
+        outline_cache()
     {
         node_p = n_p;
         SetInitFlags();
@@ -57,6 +104,16 @@ public:
     {
         opacity = op_l;
     }
+    /** Get position that animation moves item to */
+    inline QPointF targetPos() const
+    {
+        return target_pos;
+    }
+    /** Set position that animation moves item to */
+    inline void setTargetPos( QPointF pos)
+    {
+        target_pos = pos;
+    }
     /** Set node to be highlighted */
     inline void highlight()
     {
@@ -71,6 +128,17 @@ public:
         alternate_background = false;
         update();
     }
+    /** Check if node stands for a folded part of graph */
+    inline bool isFolded() const
+    {
+        return folded;
+    }
+    /** Mark node as standing for a folded part of graph, it is drawn with double border */
+    inline void setFolded( bool f = true)
+    {
+        folded = f;
+        update();
+    }
     /** Get corresponding text doc */
 	inline QDockWidget *textDock() const
 	{
@@ -91,15 +159,41 @@ public:
     {
         return Type;
     }
-    /** Get text border rectangle */
-    inline QRectF textRect() const
+    /** Get text of label */
+    QString toPlainText() const;
+    /** Set text of label */
+    void setPlainText( const QString &text);
+    /** Check if label is being edited */
+    inline bool isEditing() const
     {
-        return QGraphicsTextItem::boundingRect();
+        return isNotNullP( editor);
     }
+    /** Turn label into editable text item */
+    void startEditing();
+    /** Take text from editor and return to static label */
+    void finishEditing();
+    /** Adjust node to the text typed in editor */
+    void textEdited();
+    /** Get font of labels */
+    static QFont labelFont();
+    /** Get text border rectangle */
+    QRectF textRect() const;
     /** Get the inner border rectangle */
     QRectF borderRect() const;
+    /** Get the inner border rectangle of edge control */
+    static QRectF controlBorderRect();
     /** Get the bounding rectangle */
     QRectF boundingRect() const;
+    /**
+     * Get outline of node. It is rebuilt only when node's type, style shape or
+     * text size differ from the ones of the cached outline
+     */
+    const NodeOutline &outline() const;
+    /** Get outline as polygon */
+    inline QPolygonF outlinePolygon() const
+    {
+        return outline().polygon;
+    }
     /** Get node shape */
     QPainterPath shape() const;
     /** Determine that node's shape contains point */
@@ -112,8 +206,6 @@ public:
     void mouseReleaseEvent(QGraphicsSceneMouseEvent *event);
     /** Reimplementation of double click event handler */
     void mouseDoubleClickEvent(QGraphicsSceneMouseEvent *event);
-    /** Reimplementation of focus out event */
-    void focusOutEvent(QFocusEvent *event);
     /** Reimplementation of key press event */
     void keyPressEvent(QKeyEvent *event);
     /** Adjust associated items */
@@ -124,19 +216,18 @@ public:
     QVariant itemChange(GraphicsItemChange change, const QVariant &value);
 	/** 
      * Perform animation step
-     * Advance node's coordinates and opacity towards goal values of these parameters
+     * Advance node's position and opacity towards target position and node's priority
+     * by given number of animation intervals.
      * Return true if node have advanced somehow. False if node hasn't change
      */
-    bool advance();
+    bool advance( qreal intervals);
+    /** Check if node's position or opacity differ from their targets */
+    bool isAnimated() const;
+    /** Collect edges and edge chains that should be adjusted when node moves */
+    void collectAssociates( QSet< EdgeItem *> &edges, QSet< EdgeChainItem *> &chains) const;
     
     /** Remove from scene */
-    inline void remove()
-    {
-        setVisible( false);
-        removeFromIndex();
-        scene()->removeItem( this);
-        node_p = NULL;
-    }
+    void remove();
 
     /** Change shape */
     void shapeChanged();
@@ -154,8 +245,8 @@ class GNode: public AuxNode
     /** Graphical appearance style */
     GStyle *_style;
 
-    /** Representation of node as text */
-    QTextDocument* _doc;
+    /** Representation of node as text, null string if node has no text */
+    QString node_text;
 protected:    
     /** We can't create nodes separately, do it through newNode method of graph */
     GNode( GGraph *graph_p, int _id);
@@ -198,16 +289,18 @@ public:
     {
         return item_p;
     }
-    /** Get the corresponding text */
-    inline QTextDocument *doc() const
+    /** Check if node has text, e.g. IR of the block it stands for */
+    inline bool hasText() const
     {
-        return _doc;
+        return !node_text.isNull();
     }
-    /** Set node's text document */
-    inline void setDoc( QTextDocument* doc)
+    /** Get the corresponding text */
+    inline const QString &text() const
     {
-        _doc = doc;
+        return node_text;
     }
+    /** Set node's text, it is indexed for search */
+    void setText( const QString &text);
     
     /** 
      * Update DOM element
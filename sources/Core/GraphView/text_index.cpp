@@ -0,0 +1,320 @@
+/**
+ * @file: text_index.cpp
+ * Implementation of trigram index of node text
+ * @ingroup GUIGraph
+ */
+/*
+ * GUI for ShowGraph tool.
+ * Copyright (c) 2009, Boris Shurygin
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "gview_impl.h"
+
+/**
+ * Check if node's text contains given string, flags are interpreted as by QTextDocument::find
+ */
+bool
+nodeTextContains( GNode *n, const QString &str, QTextDocument::FindFlags flags)
+{
+    if ( !n->hasText())
+        return false;
+
+    Qt::CaseSensitivity cs = ( flags & QTextDocument::FindCaseSensitively)
+                             ? Qt::CaseSensitive
+                             : Qt::CaseInsensitive;
+    if ( flags & QTextDocument::FindWholeWords)
+    {
+        QRegExp rx( QString( "\\b%1\\b").arg( QRegExp::escape( str)), cs);
+        return rx.indexIn( n->text()) != -1;
+    }
+    return n->text().contains( str, cs);
+}
+
+/**
+ * Build posting lists from text of nodes given in descending order of keys, runs in background
+ */
+static TextPostings buildPostings( const QVector< QPair< int, QString> > &texts)
+{
+    TextPostings postings;
+
+    for ( int i = texts.size() - 1; i >= 0; i--)
+    {
+        int key = texts[ i].first;
+        QString text = texts[ i].second.toCaseFolded();
+
+        for ( int pos = 0; pos + 3 <= text.length(); pos++)
+        {
+            QVector< int> &list = postings[ TextIndex::trigram( text, pos)];
+
+            /** Keys come in ascending order, repeated trigram of the same text is the last key */
+            if ( list.isEmpty() || list.last() != key)
+                list.push_back( key);
+        }
+    }
+    return postings;
+}
+
+/**
+ * Compare posting lists by size
+ */
+static bool sizeLessThan( const QVector< int> *list1, const QVector< int> *list2)
+{
+    return list1->size() < list2->size();
+}
+
+/**
+ * Constructor
+ */
+TextIndex::TextIndex( GraphView *v):
+    view( v),
+    state( TEXT_INDEX_EMPTY),
+    postings(),
+    nodes(),
+    keys(),
+    next_key( 0),
+    pending(),
+    watcher( NULL)
+{
+
+}
+
+/**
+ * Destructor. Waits for building in progress, it doesn't refer to nodes
+ */
+TextIndex::~TextIndex()
+{
+    clear();
+}
+
+/**
+ * Get trigram that starts at given position of case folded text
+ */
+quint64
+TextIndex::trigram( const QString &text, int pos)
+{
+    return ( ( quint64)text[ pos].unicode() << 32)
+           | ( ( quint64)text[ pos + 1].unicode() << 16)
+           | ( quint64)text[ pos + 2].unicode();
+}
+
+/**
+ * Start building index of view's graph. Nodes get their keys here, text is copied
+ * and posting lists are built from the copy by background worker
+ */
+void
+TextIndex::build()
+{
+    clear();
+    if ( isNullP( view->graph()))
+        return;
+
+    QVector< QPair< int, QString> > texts;
+    GNode *n;
+
+    foreachNode( n, view->graph())
+    {
+        next_key++;
+    }
+    int key = next_key;
+    foreachNode( n, view->graph())
+    {
+        key--;
+        nodes[ key] = n;
+        keys[ n] = key;
+        if ( n->hasText())
+            texts.push_back( qMakePair( key, n->text()));
+    }
+    state = TEXT_INDEX_BUILDING;
+    watcher = new QFutureWatcher< TextPostings>();
+    QObject::connect( watcher, SIGNAL( finished()), view, SLOT( textIndexBuilt()));
+    watcher->setFuture( QtConcurrent::run( buildPostings, texts));
+}
+
+/**
+ * Take posting lists built in background and index text that changed meanwhile
+ */
+void
+TextIndex::finishBuild()
+{
+    if ( isNullP( watcher) || !watcher->isFinished())
+        return;
+
+    postings = watcher->result();
+    watcher->deleteLater();
+    watcher = NULL;
+    state = TEXT_INDEX_READY;
+    foreach ( GNode *n, pending)
+    {
+        addText( n);
+    }
+    pending.clear();
+}
+
+/**
+ * Drop index, building in progress is waited for and its result is dropped
+ */
+void
+TextIndex::clear()
+{
+    if ( isNotNullP( watcher))
+    {
+        watcher->waitForFinished();
+        watcher->deleteLater();
+        watcher = NULL;
+    }
+    postings.clear();
+    nodes.clear();
+    keys.clear();
+    pending.clear();
+    next_key = 0;
+    state = TEXT_INDEX_EMPTY;
+}
+
+/**
+ * Add trigrams of node's text to posting lists. Keys of new nodes are the greatest
+ * ones so they are appended, keys of other nodes are inserted in order
+ */
+void
+TextIndex::addText( GNode *n)
+{
+    if ( !keys.contains( n) || !n->hasText())
+        return;
+
+    int key = keys[ n];
+    QString text = n->text().toCaseFolded();
+
+    for ( int pos = 0; pos + 3 <= text.length(); pos++)
+    {
+        QVector< int> &list = postings[ trigram( text, pos)];
+        QVector< int>::iterator it = qLowerBound( list.begin(), list.end(), key);
+
+        if ( it == list.end() || *it != key)
+            list.insert( it, key);
+    }
+}
+
+/**
+ * Give key to new node. New node is the head of node list, so it gets the greatest key
+ */
+void
+TextIndex::addNode( GNode *n)
+{
+    if ( state == TEXT_INDEX_EMPTY)
+        return;
+
+    int key = next_key++;
+
+    nodes[ key] = n;
+    keys[ n] = key;
+    textChanged( n);
+}
+
+/**
+ * Forget deleted node. Its keys in posting lists are left, they lead to no node
+ */
+void
+TextIndex::removeNode( GNode *n)
+{
+    if ( state == TEXT_INDEX_EMPTY || !keys.contains( n))
+        return;
+
+    nodes.remove( keys.take( n));
+    pending.remove( n);
+}
+
+/**
+ * Index new text of node. Trigrams of old text are left, search checks text anyway
+ */
+void
+TextIndex::textChanged( GNode *n)
+{
+    if ( state == TEXT_INDEX_BUILDING)
+    {
+        pending.insert( n);
+    } else if ( state == TEXT_INDEX_READY)
+    {
+        addText( n);
+    }
+}
+
+/**
+ * Check if search for given string can be answered by index. String should have
+ * at least one trigram and node search starts from should be indexed
+ */
+bool
+TextIndex::canFind( const QString &str, GNode *from) const
+{
+    return isReady()
+           && str.length() >= 3
+           && ( isNullP( from) || keys.contains( from));
+}
+
+/**
+ * Find the nearest node after given one in given direction whose text contains string.
+ * Keys are taken from the shortest posting list of string's trigrams, the other lists
+ * are checked by binary search and the node is checked by exact match
+ */
+GNode *
+TextIndex::find( const QString &str, QTextDocument::FindFlags flags, GNode *from, bool forward) const
+{
+    QString folded = str.toCaseFolded();
+    QVector< const QVector< int> *> lists;
+
+    for ( int pos = 0; pos + 3 <= folded.length(); pos++)
+    {
+        TextPostings::const_iterator it = postings.constFind( trigram( folded, pos));
+
+        if ( it == postings.constEnd())
+            return NULL;
+        lists.push_back( &it.value());
+    }
+    qSort( lists.begin(), lists.end(), sizeLessThan);
+
+    const QVector< int> &shortest = *lists.first();
+    QVector< int>::const_iterator it;
+    int from_key;
+
+    if ( forward)
+    {
+        from_key = isNotNullP( from) ? keys[ from] : -1;
+        it = qUpperBound( shortest.constBegin(), shortest.constEnd(), from_key);
+    } else
+    {
+        from_key = isNotNullP( from) ? keys[ from] : next_key;
+        it = qLowerBound( shortest.constBegin(), shortest.constEnd(), from_key);
+    }
+    while ( forward ? it != shortest.constEnd() : it != shortest.constBegin())
+    {
+        if ( !forward)
+            --it;
+
+        int key = *it;
+        bool in_all = true;
+
+        for ( int i = 1; i < lists.size() && in_all; i++)
+        {
+            in_all = qBinaryFind( lists[ i]->constBegin(), lists[ i]->constEnd(), key)
+                     != lists[ i]->constEnd();
+        }
+        if ( in_all)
+        {
+            GNode *n = nodes.value( key, NULL);
+
+            if ( isNotNullP( n) && nodeTextContains( n, str, flags))
+                return n;
+        }
+        if ( forward)
+            ++it;
+    }
+    return NULL;
+}
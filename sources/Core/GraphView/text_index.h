@@ -0,0 +1,116 @@
+/**
+ * @file: text_index.h
+ * Trigram index of node text for search
+ * @ingroup GUIGraph
+ */
+/*
+ * GUI for ShowGraph tool.
+ * Copyright (c) 2009, Boris Shurygin
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef TEXT_INDEX_H
+#define TEXT_INDEX_H
+
+/** Posting lists of trigrams: keys of nodes whose text contains trigram, in ascending order */
+typedef QHash< quint64, QVector< int> > TextPostings;
+
+/**
+ * Inverted index of node text by trigrams
+ * @ingroup GUIGraph
+ *
+ * Each node with text gets a key that grows from the tail of graph's node list to its head,
+ * so keys order nodes the way search walks them. Text is case folded, so the same index
+ * serves case sensitive and insensitive search, and every trigram of text has a posting list
+ * of keys. Search intersects posting lists of the string's trigrams and checks found nodes
+ * with the exact match, strings shorter than a trigram are not answered by the index.
+ *
+ * Index is built by build() in background from a copy of node text and is updated when
+ * nodes are created, deleted or get new text. Changed text only adds keys to posting lists:
+ * stale keys are dropped by the exact check, keys of deleted nodes lead to no node.
+ */
+class TextIndex
+{
+    /** State of index */
+    enum State
+    {
+        /** Index is not built, changes of graph are ignored */
+        TEXT_INDEX_EMPTY,
+        /** Posting lists are being built in background */
+        TEXT_INDEX_BUILDING,
+        /** Index answers search */
+        TEXT_INDEX_READY
+    };
+
+    /** View that index belongs to, it is notified when building is done */
+    GraphView *view;
+    /** State */
+    State state;
+    /** Posting lists */
+    TextPostings postings;
+    /** Indexed nodes by their keys */
+    QHash< int, GNode *> nodes;
+    /** Keys of indexed nodes */
+    QHash< GNode *, int> keys;
+    /** Key of the next new node */
+    int next_key;
+    /** Nodes whose text changed while posting lists were built */
+    QSet< GNode *> pending;
+    /** Building in progress, NULL if there is none */
+    QFutureWatcher< TextPostings> *watcher;
+
+    /** Add trigrams of node's text to posting lists */
+    void addText( GNode *n);
+public:
+    /** Constructor */
+    TextIndex( GraphView *v);
+    /** Destructor. Waits for building in progress */
+    ~TextIndex();
+
+    /** Get trigram that starts at given position of case folded text */
+    static quint64 trigram( const QString &text, int pos);
+
+    /** Start building index of view's graph in background, view's textIndexBuilt() is called when it is done */
+    void build();
+    /** Take posting lists built in background */
+    void finishBuild();
+    /** Drop index */
+    void clear();
+    /** Check if index answers search */
+    inline bool isReady() const
+    {
+        return state == TEXT_INDEX_READY;
+    }
+
+    /** Give key to new node */
+    void addNode( GNode *n);
+    /** Forget deleted node */
+    void removeNode( GNode *n);
+    /** Index new text of node */
+    void textChanged( GNode *n);
+
+    /**
+     * Check if search for given string can be answered by index
+     */
+    bool canFind( const QString &str, GNode *from) const;
+    /**
+     * Find the nearest node after given one in given direction whose text contains string.
+     * Forward direction goes from the tail of node list to its head, NULL node stands for
+     * the end of list search starts from
+     */
+    GNode *find( const QString &str, QTextDocument::FindFlags flags, GNode *from, bool forward) const;
+};
+
+/** Check if node's text contains given string, flags are interpreted as by QTextDocument::find */
+bool nodeTextContains( GNode *n, const QString &str, QTextDocument::FindFlags flags);
+
+#endif /* TEXT_INDEX_H */
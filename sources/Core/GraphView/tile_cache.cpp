@@ -0,0 +1,355 @@
+/**
+ * @file: tile_cache.cpp
+ * Implementation of cache of rendered tiles of scene
+ * @ingroup GUIGraph
+ */
+/*
+ * GUI for ShowGraph tool.
+ * Copyright (c) 2009, Boris Shurygin
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "gview_impl.h"
+
+/**
+ * Replay pictures of items into tile image, runs in background
+ */
+static TileJob renderTile( TileJob job)
+{
+    job.image = QImage( TILE_SIZE, TILE_SIZE, QImage::Format_ARGB32_Premultiplied);
+    job.image.fill( 0);
+    if ( !job.pictures.isEmpty())
+    {
+        /** Pictures are scaled on replay by the ratio of resolutions, keep it at one */
+        job.image.setDotsPerMeterX( qRound( job.pictures.first().logicalDpiX() * 100 / 2.54));
+        job.image.setDotsPerMeterY( qRound( job.pictures.first().logicalDpiY() * 100 / 2.54));
+    }
+
+    QPainter painter( &job.image);
+
+    painter.translate( -job.origin);
+    foreach ( const QPicture &picture, job.pictures)
+    {
+        painter.drawPicture( 0, 0, picture);
+    }
+    painter.end();
+    job.pictures.clear();
+    return job;
+}
+
+/**
+ * Compare items by z value
+ */
+static bool zLessThan( QGraphicsItem *item1, QGraphicsItem *item2)
+{
+    return item1->zValue() < item2->zValue();
+}
+
+/**
+ * Constructor
+ */
+TileCache::TileCache( GraphView *v):
+    view( v),
+    tiles( TILE_CACHE_MAX_TILES),
+    jobs(),
+    stale_jobs(),
+    wanted(),
+    pictures()
+{
+
+}
+
+/**
+ * Destructor. Waits for jobs in progress, they don't refer to items so they are just dropped
+ */
+TileCache::~TileCache()
+{
+    foreach ( QFutureWatcher< TileJob> *watcher, jobs)
+    {
+        watcher->waitForFinished();
+        delete watcher;
+    }
+}
+
+/**
+ * Get zoom level for given scale, scale is rounded up to the nearest level
+ */
+int
+TileCache::level( qreal scale)
+{
+    return ( int)ceil( log( scale) / log( 2.0) * TILE_LEVELS_PER_OCTAVE - 0.001);
+}
+
+/**
+ * Get scale of zoom level
+ */
+qreal
+TileCache::levelScale( int level)
+{
+    return pow( 2.0, ( qreal)level / TILE_LEVELS_PER_OCTAVE);
+}
+
+/**
+ * Get rectangle of tile in scene coordinates
+ */
+QRectF
+TileCache::tileRect( const TileKey &key)
+{
+    qreal size = TILE_SIZE / levelScale( key.level);
+
+    return QRectF( key.x * size, key.y * size, size, size);
+}
+
+/**
+ * Check if change of given scene rectangle affects tile.
+ * Tile is widened by a pixel as antialiased painting spreads over item's border
+ */
+bool
+TileCache::isAffected( const TileKey &key, const QRectF &rect)
+{
+    qreal pixel = 1 / levelScale( key.level);
+
+    return tileRect( key).adjusted( -pixel, -pixel, pixel, pixel).intersects( rect);
+}
+
+/**
+ * Record painting of view's item at given scale. Picture is recorded in pixels of the scale
+ * so that item paints itself with the level of detail of tile
+ */
+QPicture
+TileCache::itemPicture( GraphView *view, QGraphicsItem *item, qreal scale)
+{
+    QPicture picture;
+    QPainter painter( &picture);
+    QStyleOptionGraphicsItem option;
+
+    painter.setRenderHints( view->renderHints());
+    painter.setWorldTransform( item->sceneTransform() * QTransform::fromScale( scale, scale));
+    painter.setOpacity( item->effectiveOpacity());
+    option.rect = item->boundingRect().toAlignedRect();
+    option.exposedRect = item->boundingRect();
+    option.levelOfDetail = scale;
+    option.palette = view->palette();
+    option.state = QStyle::State_None;
+    if ( item->isEnabled())
+        option.state |= QStyle::State_Enabled;
+    if ( item->isSelected())
+        option.state |= QStyle::State_Selected;
+    item->paint( &painter, &option, NULL);
+    painter.end();
+    return picture;
+}
+
+/**
+ * Start rendering tile. Items are taken from item grid with a margin as grid keeps edges
+ * with the rectangle of their ends, pictures of items are shared by tiles of one level
+ * and are recorded only for items that have none
+ */
+void
+TileCache::startJob( const TileKey &key)
+{
+    qreal scale = levelScale( key.level);
+    QRectF rect = tileRect( key);
+    QList< QGraphicsItem *> items;
+    TileJob job;
+
+    foreach ( QGraphicsItem *item,
+              view->itemGrid().items( rect.adjusted( -TILE_ITEM_MARGIN, -TILE_ITEM_MARGIN,
+                                                     TILE_ITEM_MARGIN, TILE_ITEM_MARGIN)))
+    {
+        if ( item->isVisible()
+             && view->isTileItem( item)
+             && isAffected( key, item->sceneBoundingRect()))
+        {
+            items << item;
+        }
+    }
+    qStableSort( items.begin(), items.end(), zLessThan);
+
+    job.key = key;
+    job.origin = QPointF( rect.left() * scale, rect.top() * scale);
+
+    QHash< QGraphicsItem *, TilePicture> &level_pictures = pictures[ key.level];
+
+    foreach ( QGraphicsItem *item, items)
+    {
+        QHash< QGraphicsItem *, TilePicture>::iterator it = level_pictures.find( item);
+
+        if ( it == level_pictures.end())
+        {
+            TilePicture recorded;
+
+            recorded.picture = itemPicture( view, item, scale);
+            recorded.rect = item->sceneBoundingRect();
+            it = level_pictures.insert( item, recorded);
+        }
+        job.pictures << it.value().picture;
+    }
+
+    QFutureWatcher< TileJob> *watcher = new QFutureWatcher< TileJob>();
+
+    QObject::connect( watcher, SIGNAL( finished()), view, SLOT( tileRendered()));
+    jobs[ key] = watcher;
+    watcher->setFuture( QtConcurrent::run( renderTile, job));
+}
+
+/**
+ * Start rendering wanted tiles while there are free workers
+ */
+void
+TileCache::schedule()
+{
+    int max_jobs = qMax( 1, QThread::idealThreadCount());
+
+    while ( jobs.count() < max_jobs && !wanted.isEmpty())
+    {
+        startJob( wanted.takeFirst());
+    }
+}
+
+/**
+ * Draw tiles that cover given scene rectangle at zoom level of given scale.
+ * Missing tiles are scheduled for rendering unless an item is dragged,
+ * they would be outdated by the next move anyway. Returns true if all tiles were drawn.
+ * Pictures of items are kept only for the level being drawn
+ */
+bool
+TileCache::draw( QPainter *painter, const QRectF &rect, qreal scale)
+{
+    int lvl = level( scale);
+    qreal size = TILE_SIZE / levelScale( lvl);
+    bool complete = true;
+
+    if ( pictures.count() > 1 || ( !pictures.isEmpty() && !pictures.contains( lvl)))
+    {
+        QHash< QGraphicsItem *, TilePicture> level_pictures = pictures.value( lvl);
+
+        pictures.clear();
+        if ( !level_pictures.isEmpty())
+            pictures.insert( lvl, level_pictures);
+    }
+    wanted.clear();
+    painter->save();
+    painter->setRenderHint( QPainter::SmoothPixmapTransform);
+    for ( int y = ( int)floor( rect.top() / size); y <= ( int)floor( rect.bottom() / size); y++)
+    {
+        for ( int x = ( int)floor( rect.left() / size); x <= ( int)floor( rect.right() / size); x++)
+        {
+            TileKey key( lvl, x, y);
+            QPixmap *tile = tiles.object( key);
+
+            if ( isNotNullP( tile))
+            {
+                painter->drawPixmap( tileRect( key), *tile, tile->rect());
+            } else
+            {
+                complete = false;
+                if ( !jobs.contains( key))
+                    wanted << key;
+            }
+        }
+    }
+    painter->restore();
+    if ( isNullP( view->scene()->mouseGrabberItem()))
+        schedule();
+    return complete;
+}
+
+/**
+ * Drop tiles affected by change of given scene rectangle,
+ * jobs in progress that are affected are marked as stale. Pictures of items whose
+ * rectangle intersects the change are dropped, the rectangle is the one they were recorded
+ * with, so items are not touched here
+ */
+void
+TileCache::invalidate( const QRectF &rect)
+{
+    for ( QHash< int, QHash< QGraphicsItem *, TilePicture> >::iterator level_it = pictures.begin();
+          level_it != pictures.end();
+          ++level_it)
+    {
+        qreal pixel = 1 / levelScale( level_it.key());
+        QRectF changed = rect.adjusted( -pixel, -pixel, pixel, pixel);
+        QHash< QGraphicsItem *, TilePicture>::iterator it = level_it.value().begin();
+
+        while ( it != level_it.value().end())
+        {
+            if ( changed.intersects( it.value().rect))
+                it = level_it.value().erase( it);
+            else
+                ++it;
+        }
+    }
+    foreach ( TileKey key, tiles.keys())
+    {
+        if ( isAffected( key, rect))
+            tiles.remove( key);
+    }
+    foreach ( TileKey key, jobs.keys())
+    {
+        if ( isAffected( key, rect))
+            stale_jobs.insert( key);
+    }
+}
+
+/**
+ * Drop all tiles
+ */
+void
+TileCache::clear()
+{
+    tiles.clear();
+    wanted.clear();
+    pictures.clear();
+    foreach ( TileKey key, jobs.keys())
+    {
+        stale_jobs.insert( key);
+    }
+}
+
+/**
+ * Drop pictures of item that is removed from scene, its region is invalidated by scene
+ */
+void
+TileCache::removeItem( QGraphicsItem *item)
+{
+    for ( QHash< int, QHash< QGraphicsItem *, TilePicture> >::iterator it = pictures.begin();
+          it != pictures.end();
+          ++it)
+    {
+        it.value().remove( item);
+    }
+}
+
+/**
+ * Take results of finished jobs and start new ones. Viewport is updated
+ * where tiles are ready and where stale ones are to be requested again
+ */
+void
+TileCache::finishJobs()
+{
+    foreach ( TileKey key, jobs.keys())
+    {
+        QFutureWatcher< TileJob> *watcher = jobs[ key];
+
+        if ( !watcher->isFinished())
+            continue;
+
+        if ( !stale_jobs.contains( key))
+            tiles.insert( key, new QPixmap( QPixmap::fromImage( watcher->result().image)));
+        stale_jobs.remove( key);
+        jobs.remove( key);
+        watcher->deleteLater();
+        view->viewport()->update( view->mapFromScene( tileRect( key)).boundingRect());
+    }
+    schedule();
+}
@@ -0,0 +1,151 @@
+/**
+ * @file: tile_cache.h
+ * Cache of rendered tiles of scene
+ * @ingroup GUIGraph
+ */
+/*
+ * GUI for ShowGraph tool.
+ * Copyright (c) 2009, Boris Shurygin
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef TILE_CACHE_H
+#define TILE_CACHE_H
+
+/**
+ * Key of tile: zoom level and position in the grid of tiles of this level
+ * @ingroup GUIGraph
+ */
+struct TileKey
+{
+    /** Zoom level */
+    int level;
+    /** Column */
+    int x;
+    /** Row */
+    int y;
+
+    /** Default constructor */
+    inline TileKey(): level( 0), x( 0), y( 0)
+    {
+
+    }
+    /** Constructor */
+    inline TileKey( int l, int tile_x, int tile_y): level( l), x( tile_x), y( tile_y)
+    {
+
+    }
+    /** Comparison */
+    inline bool operator == ( const TileKey &key) const
+    {
+        return level == key.level && x == key.x && y == key.y;
+    }
+};
+
+/** Hash of tile key */
+inline uint qHash( const TileKey &key)
+{
+    return qHash( ( ( quint64)( quint32)key.x << 32) | ( quint32)key.y) ^ ( uint)key.level * 31;
+}
+
+/**
+ * Recorded painting of item shared by tiles of one zoom level
+ * @ingroup GUIGraph
+ */
+struct TilePicture
+{
+    /** Picture recorded in pixels of zoom level */
+    QPicture picture;
+    /** Scene rectangle of item when it was recorded */
+    QRectF rect;
+};
+
+/**
+ * Job of rendering one tile in background
+ * @ingroup GUIGraph
+ */
+struct TileJob
+{
+    /** Tile */
+    TileKey key;
+    /** Top left corner of tile in pixels of its level */
+    QPointF origin;
+    /** Pictures of items in painting order, recorded in pixels of tile's level */
+    QList< QPicture> pictures;
+    /** Rendered tile */
+    QImage image;
+};
+
+/**
+ * Cache of scene rendered into tiles at discrete zoom levels
+ * @ingroup GUIGraph
+ *
+ * Tiles are square images of TILE_SIZE pixels. Zoom levels are TILE_LEVELS_PER_OCTAVE
+ * per doubling of scale, view's scale is rounded up to the nearest level so tiles are
+ * never blown up by more than that step. Items are recorded into pictures in GUI thread
+ * and pictures are replayed into tile images by background workers, so workers don't
+ * touch graphics items. Tile is dropped when scene changes in its region, a job whose
+ * region changes while it runs is discarded when it finishes. Pictures of items are kept
+ * for the zoom level being drawn, so item is recorded once however many tiles it reaches;
+ * picture is dropped when scene changes in item's rectangle or item is removed.
+ */
+class TileCache
+{
+    /** View whose scene is rendered */
+    GraphView *view;
+    /** Rendered tiles, least recently drawn ones are dropped first */
+    QCache< TileKey, QPixmap> tiles;
+    /** Jobs in progress */
+    QHash< TileKey, QFutureWatcher< TileJob> *> jobs;
+    /** Jobs whose region changed after they had been started */
+    QSet< TileKey> stale_jobs;
+    /** Tiles missed by last drawing, in order of drawing */
+    QList< TileKey> wanted;
+    /** Pictures of items by zoom level */
+    QHash< int, QHash< QGraphicsItem *, TilePicture> > pictures;
+
+    /** Get scale of zoom level */
+    static qreal levelScale( int level);
+    /** Get rectangle of tile in scene coordinates */
+    static QRectF tileRect( const TileKey &key);
+    /** Check if change of given scene rectangle affects tile */
+    static bool isAffected( const TileKey &key, const QRectF &rect);
+    /** Start rendering tile, pictures of items are shared by tiles of one level */
+    void startJob( const TileKey &key);
+    /** Start rendering wanted tiles while there are free workers */
+    void schedule();
+public:
+    /** Constructor */
+    TileCache( GraphView *v);
+    /** Destructor. Waits for jobs in progress */
+    ~TileCache();
+
+    /** Get zoom level for given scale */
+    static int level( qreal scale);
+    /** Record painting of view's item at given scale */
+    static QPicture itemPicture( GraphView *view, QGraphicsItem *item, qreal scale);
+    /**
+     * Draw tiles that cover given scene rectangle at zoom level of given scale.
+     * Missing tiles are scheduled for rendering. Returns true if all tiles were drawn
+     */
+    bool draw( QPainter *painter, const QRectF &rect, qreal scale);
+    /** Drop tiles affected by change of given scene rectangle */
+    void invalidate( const QRectF &rect);
+    /** Drop all tiles */
+    void clear();
+    /** Drop pictures of item that is removed from scene */
+    void removeItem( QGraphicsItem *item);
+    /** Take results of finished jobs and start new ones */
+    void finishJobs();
+};
+
+#endif /* TILE_CACHE_H */
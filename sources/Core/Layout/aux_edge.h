@@ -57,6 +57,9 @@ class AuxEdge: public Edge
     bool priv_fixed;
 
     AuxEdgeType priv_type;
+
+    /** Chain of pseudo nodes that represents this edge during layout */
+    int priv_chain;
    
 protected:
     /** Constructors are made private, only nodes and graph can create edges */
@@ -105,6 +108,16 @@ public:
     {
         return nextEdgeInDir( GRAPH_DIR_UP);
     } 
+    /** Get chain of pseudo nodes, -1 if edge doesn't have one */
+    inline int chain() const
+    {
+        return priv_chain;
+    }
+    /** Set chain of pseudo nodes */
+    inline void setChain( int chain)
+    {
+        priv_chain = chain;
+    }
     /** Check if an edge is fixed */
     inline bool isFixed() const
     {
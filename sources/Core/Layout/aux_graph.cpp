@@ -30,12 +30,32 @@ AuxGraph::AuxGraph( bool create_pools):
     Graph( false),
     ranking_valid( false),
     levels(),
-    layout_in_process( false) 
+    chains(),
+    components(),
+    layout_in_process( false),
+    progress(),
+    progress_total( 0),
+    layout_deadline( 0),
+    deadline_passed( false),
+    arrange_pass( 0),
+    parallel_ranking_min( PARALLEL_RANKING_MIN_NODES),
+    cycle_breaking( CYCLE_BREAKING_DFS),
+    inverted_num( 0),
+    layout_engine( LAYOUT_ENGINE_LAYERED),
+    force_multilevel( true),
+    force_layout( NULL),
+    deterministic( false),
+    phase_timer(),
+    phase_time( LAYOUT_PHASE_NUM, 0)
 {
     ranking = newNum();
     order = newNum();
     
     watcher = new QFutureWatcher<void>();
+    progress_timer = new QTimer();
+    progress_timer->setInterval( LAYOUT_PROGRESS_INTERVAL);
+    deadline_timer = new QTimer();
+    deadline_timer->setSingleShot( true);
     
     /** Pools' creation routine */
     if ( create_pools)
@@ -44,7 +64,9 @@ AuxGraph::AuxGraph( bool create_pools):
         edge_pool = new FixedPool< AuxEdge>();
     }
  
-    connect( watcher, SIGNAL(finished()), this, SLOT( layoutNextStep()));
+    connect( watcher, SIGNAL(finished()), this, SLOT( finishLayout()));
+    connect( progress_timer, SIGNAL(timeout()), this, SLOT( reportProgress()));
+    connect( deadline_timer, SIGNAL(timeout()), this, SLOT( deadlineTimeout()));
 }
 
 /**
@@ -70,16 +92,34 @@ AuxGraph::deleteLevels()
     {
         delete levels[ i];
     } 
+    levels.clear();
 }
 
 
+/**
+ * Delete components
+ */
+void
+AuxGraph::deleteComponents()
+{
+    for ( int i = 0; i < components.size(); i++)
+    {
+        delete components[ i];
+    }
+    components.clear();
+}
+
 /**
  * Destructor. Cleans up level info
  */
 AuxGraph::~AuxGraph()
 {
+    deleteComponents();
     deleteLevels();
+    delete force_layout;
     delete watcher;
+    delete progress_timer;
+    delete deadline_timer;
     freeNum( ranking);
     freeNum( order);
 }
@@ -90,6 +130,10 @@ AuxGraph::~AuxGraph()
 AuxNode*
 AuxGraph::rootNode()
 {
+    if ( levels.isEmpty())
+    {
+        return firstNode();
+    }
     Level* root_level = levels[ 0];
 
     if( isNullP( root_level) || isNullP( firstNode()))
@@ -61,6 +61,53 @@ AuxNode::AddSucc( AuxEdge *edge)
 {
     AddEdgeInDir( edge, GRAPH_DIR_DOWN);
 }
+/**
+ * Progress of layout running in background
+ *
+ * @ingroup Layout
+ * Worker thread counts processed levels, GUI thread polls the counter.
+ * Cancellation is requested by GUI thread and checked by worker before each level
+ */
+class LayoutProgress
+{
+    /** Number of processed levels */
+    QAtomicInt steps_done;
+    /** Non-zero if cancellation was requested */
+    QAtomicInt cancel_requested;
+public:
+    /** Default constructor */
+    inline LayoutProgress(): steps_done( 0), cancel_requested( 0){};
+    /** Prepare for new layout */
+    inline void reset()
+    {
+        steps_done.fetchAndStoreOrdered( 0);
+        cancel_requested.fetchAndStoreOrdered( 0);
+    }
+    /** Count one processed level */
+    inline void step()
+    {
+        steps_done.fetchAndAddRelaxed( 1);
+    }
+    /** Get number of processed levels */
+    inline int stepsDone() const
+    {
+        return steps_done;
+    }
+    /** Request cancellation */
+    inline void cancel()
+    {
+        cancel_requested.fetchAndStoreOrdered( 1);
+    }
+    /** Check if cancellation was requested */
+    inline bool isCancelled() const
+    {
+        return cancel_requested != 0;
+    }
+};
+
+/** Pair of nodes that stands for an edge */
+typedef QPair< AuxNode *, AuxNode *> AuxNodePair;
+
 /**
  * Graph with nodes of two types: simple nodes and edge controls
  *
@@ -72,15 +119,34 @@ class AuxGraph: public QObject, public Graph
 private:
     /** Layout algorithm inner variables */
     bool layout_in_process;
-    int cur_level; //last processed level
-    int cur_pass; // current pass
     
     /** Watcher for processing layout in parallel with main event loop */
     QFutureWatcher< void> *watcher;
 
+    /** Progress of background layout */
+    LayoutProgress progress;
+    /** Number of level steps in background layout */
+    int progress_total;
+    /** Timer for polling progress of background layout */
+    QTimer *progress_timer;
+    /** Time in milliseconds after which unfinished layout is shown, 0 to show layout only when it is done */
+    int layout_deadline;
+    /** Timer of layout deadline */
+    QTimer *deadline_timer;
+    /** Whether deadline of running layout has passed */
+    bool deadline_passed;
+    /** Horizontal placement pass performed by background worker in anytime layout */
+    int arrange_pass;
+
     /** Array of node lists for ranks */
     QVector< Level*> levels;
 
+    /** Pseudo nodes of edges that span several ranks */
+    EdgeChains chains;
+
+    /** Weakly connected components, empty if graph is connected or has stable nodes */
+    QVector< LayoutComponent*> components;
+
     /** Order numeration */
     Numeration order;
     
@@ -93,6 +159,40 @@ private:
     /** Maximum used for ranking */
     GraphNum max_rank;
 
+    /** Minimal number of nodes for parallel ranking */
+    GraphNum parallel_ranking_min;
+
+    /** Algorithm that breaks cycles */
+    CycleBreaking cycle_breaking;
+    /** Number of edges inverted by last classification */
+    GraphNum inverted_num;
+
+    /** Layout algorithm */
+    LayoutEngine layout_engine;
+    /** Whether force-directed layout coarsens graph before placement */
+    bool force_multilevel;
+    /** Force-directed layout performed by background worker, NULL if there is none */
+    ForceLayout *force_layout;
+    /** Whether layout result should depend on graph only */
+    bool deterministic;
+
+    /** Timer of current layout phase */
+    QElapsedTimer phase_timer;
+    /** Time of each phase of last layout in milliseconds */
+    QVector< qint64> phase_time;
+
+    /** Start measuring time of layout phases */
+    inline void startPhases()
+    {
+        phase_time.fill( 0, LAYOUT_PHASE_NUM);
+        phase_timer.start();
+    }
+    /** Remember time of finished phase, the next one starts */
+    inline void endPhase( LayoutPhase phase)
+    {
+        phase_time[ phase] = phase_timer.restart();
+    }
+
     /**
      * Structure used for dfs traversal loop-wise implementation
      * Not part of interface used internally
@@ -137,11 +237,35 @@ private:
     void reduceCrossings();
     /** Find proper vertical position for each level */
     void adjustVerticalLevels();
+    /** Split graph into weakly connected components with their own levels */
+    void splitComponents();
+    /** Delete components */
+    void deleteComponents();
+    /** Replace chains of long edges with edge control nodes */
+    void createEdgeControls();
+    /** Arrange components concurrently and pack them */
+    void arrangeComponents( LayoutProgress *progress = NULL);
+    /** Horizontal placement performed by background worker */
+    void arrangeInBackground();
+    /** Put nodes of each level left to right in their order */
+    void placeByOrder();
+    /** One pass of horizontal placement performed by background worker */
+    void arrangePassInBackground();
+    /** Force-directed placement performed by background worker */
+    void forceInBackground();
 
     /** Assign ranks to nodes in respect to maximum length of path from top */
     Numeration rankNodes();
+    /** Rank nodes in one thread, pred_nums are numbers of predecessors indexed by own numeration */
+    void rankNodesSequential( Numeration own, QVector< int> &pred_nums);
+    /** Rank nodes frontier by frontier in thread pool */
+    void rankNodesParallel( Numeration own, QVector< int> &pred_nums);
     /** Assign edge types, mark edges that should be inverted */
     void classifyEdges();
+    /** Invert back edges of depth-first search */
+    void classifyEdgesDFS();
+    /** Invert edges using greedy feedback arc set heuristic */
+    void classifyEdgesGreedy();
 
     /** Get numeration that describes ranks in graph */
     inline Numeration ranks() const
@@ -166,6 +290,21 @@ protected:
                                          static_cast<AuxNode *>( _pred),
                                          static_cast<AuxNode *>( _succ) );
     }
+    /** Width of edge control nodes */
+    virtual qreal controlWidth() const
+    {
+        return 0;
+    }
+    /** Height of edge control nodes */
+    virtual qreal controlHeight() const
+    {
+        return 0;
+    }
+    /** Check if new edge control nodes take part in horizontal placement */
+    virtual bool isControlForPlacement() const
+    {
+        return true;
+    }
     /** Get node that is considered root one after the layout */
     AuxNode* rootNode();
     /** Arrange nodes horizontally */
@@ -174,9 +313,16 @@ protected:
     void arrangeHorizontallyWOStable();
     /** Arrange nodes horizontally with respect of stable nodes */
     void arrangeHorizontallyWithStable( Rank min, Rank max);
+private slots:
+    /** Finish layout when background worker is done */
+    void finishLayout();
+    /** Report progress of background worker */
+    void reportProgress();
+    /** Show unfinished layout when deadline has passed */
+    void deadlineTimeout();
 public slots:
-    /** Process next level while doing layout in parallel with main event loop */
-    void layoutNextStep();
+    /** Request cancellation of layout that runs in background */
+    void cancelLayout();
 signals:
     /** signal some progess in layout process */
     void progressChange( int value);
@@ -199,6 +345,89 @@ public:
         return static_cast< AuxNode *>( Graph::firstNode());
     }
 
+    /** Get algorithm that breaks cycles */
+    inline CycleBreaking cycleBreaking() const
+    {
+        return cycle_breaking;
+    }
+    /** Set algorithm that breaks cycles */
+    inline void setCycleBreaking( CycleBreaking algo)
+    {
+        cycle_breaking = algo;
+    }
+    /** Get layout algorithm */
+    inline LayoutEngine layoutEngine() const
+    {
+        return layout_engine;
+    }
+    /** Set layout algorithm */
+    inline void setLayoutEngine( LayoutEngine engine)
+    {
+        layout_engine = engine;
+    }
+    /** Check if force-directed layout coarsens graph before placement */
+    inline bool isForceMultilevel() const
+    {
+        return force_multilevel;
+    }
+    /** Set whether force-directed layout coarsens graph before placement */
+    inline void setForceMultilevel( bool multilevel = true)
+    {
+        force_multilevel = multilevel;
+    }
+    /** Check if deterministic layout mode is on */
+    inline bool isDeterministic() const
+    {
+        return deterministic;
+    }
+    /**
+     * Set deterministic layout mode. In this mode coordinates depend only on graph:
+     * placement doesn't start from coordinates of previous layout and anytime layout is off,
+     * so doLayout and doLayoutConcurrent give the same result on any number of threads
+     */
+    inline void setDeterministic( bool det = true)
+    {
+        deterministic = det;
+    }
+    /** Get time of layout phase in milliseconds, 0 for phases that last layout didn't perform */
+    inline qint64 phaseTime( LayoutPhase phase) const
+    {
+        return phase_time[ phase];
+    }
+    /** Get number of edges that were inverted to break cycles, self edges are not counted */
+    inline GraphNum invertedEdgesNum() const
+    {
+        return inverted_num;
+    }
+    /** Get layout deadline in milliseconds, 0 if anytime layout is off */
+    inline int layoutDeadline() const
+    {
+        return layout_deadline;
+    }
+    /**
+     * Set layout deadline in milliseconds. When it is not 0 doLayoutConcurrent places
+     * nodes cheaply first and refines placement pass by pass, see layoutRefined()
+     */
+    inline void setLayoutDeadline( int msec)
+    {
+        layout_deadline = msec;
+    }
+    /** Check if unfinished layout was shown because of deadline */
+    inline bool isDeadlinePassed() const
+    {
+        return deadline_passed;
+    }
+    /** Get minimal number of nodes for which ranking runs in parallel */
+    inline GraphNum parallelRankingMin() const
+    {
+        return parallel_ranking_min;
+    }
+    /** Set minimal number of nodes for which ranking runs in parallel */
+    inline void setParallelRankingMin( GraphNum num)
+    {
+        parallel_ranking_min = num;
+    }
+
     /** Check if ranking is is valid */
     inline bool rankingValid() const
     {
@@ -223,16 +452,39 @@ public:
         Graph::debugPrint();
     }
     
+    /** Remove edge control nodes inserted by previous layout */
+    void deleteEdgeControls();
+
     /** Perform layout */
     void doLayout();
     
     /** Perform layout using concurrent threads */
     void doLayoutConcurrent();
+
+    /** Perform layout of subgraph made of given nodes, the rest of graph is not processed */
+    void doLayoutSubgraph( const QVector< AuxNode *> &nodes,
+                           const QVector< AuxNodePair> &extra_edges = QVector< AuxNodePair>());
+
+    /** Check if last background layout was cancelled */
+    inline bool isLayoutCancelled() const
+    {
+        return progress.isCancelled();
+    }
     
     /**
      * Run some actions after main layout algorithm
      */
     virtual void layoutPostProcess();
+    /**
+     * Run some actions when anytime layout has intermediate placement.
+     * Called between passes of background worker so node coordinates can be read
+     */
+    virtual void layoutRefined();
+    /**
+     * Run some actions when anytime layout is not done by deadline.
+     * Background worker is running so node coordinates should not be read
+     */
+    virtual void layoutDeadlinePassed();
 };
 
 /**
@@ -247,13 +499,136 @@ class Level
     qreal y_pos;
     Rank level_rank;
     QList< AuxNode*> node_list;
+    /** Chain entries that lie on this level */
+    QVector< int> entry_list;
+    /** Chains that entries belong to */
+    EdgeChains *chain_p;
+
+    /**
+     * Placement arrays. Nodes that take part in horizontal placement are numbered
+     * in level's order and their attributes are kept in contiguous arrays so that
+     * passes read memory linearly instead of chasing node pointers
+     */
+    /** Nodes for placement, NULL for chain entries */
+    QVector< AuxNode*> placed_nodes;
+    /** Chain entries for placement, -1 for nodes */
+    QVector< int> placed_entries;
+    /** Horizontal coordinates of nodes' left borders */
+    QVector< qreal> x_vec;
+    /** Widths of nodes */
+    QVector< qreal> width_vec;
+    /** Distance from left border to the point where edges are attached */
+    QVector< qreal> offset_vec;
+    /** Coordinates of edges' attachment points, x + offset */
+    QVector< qreal> center_vec;
+    /** Orders of nodes */
+    QVector< int> order_vec;
+    /** Types of nodes */
+    QVector< AuxNodeType> type_vec;
+    /** Stability flags of nodes */
+    QVector< bool> stable_vec;
+    /** Barycenters computed for current pass */
+    QVector< qreal> bc_vec;
+    /** Number of peers that barycenters are computed from */
+    QVector< unsigned int> weight_vec;
+    /**
+     * Peers of nodes in each pass direction. Peers of node i are
+     * peer_vec[ dir][ peer_begin[ dir][ i] ... peer_begin[ dir][ i + 1] - 1].
+     * Peer is an index in adjacent level ( peer_level[ dir]) or, for self edges,
+     * a negative value -(index + 1) of the node in this level
+     */
+    QVector< int> peer_begin[ GRAPH_DIRS_NUM];
+    /** Peers' indexes */
+    QVector< int> peer_vec[ GRAPH_DIRS_NUM];
+    /** Adjacent level that peers belong to for each pass direction */
+    Level *peer_level[ GRAPH_DIRS_NUM];
+
+    /** Add peer connected with node for placement by given edge */
+    void addEdgePeer( GraphDir dir, int i, AuxEdge *e, GraphDir edge_dir);
+    /** Add peer of chain entry for placement */
+    void addEntryPeer( GraphDir dir, int i);
 public:
     /** Default constructor */
-    inline Level(): level_rank( 0), node_list(), _height( 0), y_pos( 0){};
+    inline Level(): level_rank( 0), node_list(), entry_list(), chain_p( NULL), _height( 0), y_pos( 0)
+    {
+        peer_level[ GRAPH_DIR_UP] = NULL;
+        peer_level[ GRAPH_DIR_DOWN] = NULL;
+    };
     /** Constructor with rank parameter */
-    inline Level( Rank r): level_rank( r), node_list(), _height( 0), y_pos( 0){};
-    /** Arrange nodes with respect to adjacent level*/
-    void arrangeNodes( GraphDir dir, bool commit_placement, bool first_pass);
+    inline Level( Rank r): level_rank( r), node_list(), entry_list(), chain_p( NULL), _height( 0), y_pos( 0)
+    {
+        peer_level[ GRAPH_DIR_UP] = NULL;
+        peer_level[ GRAPH_DIR_DOWN] = NULL;
+    };
+    /** Fill placement arrays from nodes' attributes */
+    void initPlacement();
+    /** Build peer indexes, should be called after placement arrays of adjacent levels are filled */
+    void initPeers( Level *prev, Level *next);
+    /** Compute barycenters of nodes with respect to peers of given pass direction */
+    void computeBarycenters( GraphDir dir, bool first_pass);
+    /** Recompute attachment points of nodes after their coordinates are changed */
+    void updateCenters();
+    /** Arrange nodes with respect to adjacent level using given group buffers */
+    void arrangeNodes( GraphDir dir, bool commit_placement, bool first_pass, NodeGroups &groups);
+    /** Put nodes and chain entries left to right in their order, centered at zero */
+    void placeByOrder();
+    /** Get number of nodes for placement */
+    inline int placedCount() const
+    {
+        return placed_nodes.size();
+    }
+    /** Get node for placement by index, NULL if it is a chain entry */
+    inline AuxNode *placedNode( int i) const
+    {
+        return placed_nodes[ i];
+    }
+    /** Get chain entry for placement by index, -1 if it is a node */
+    inline int placedEntry( int i) const
+    {
+        return placed_entries[ i];
+    }
+    /** Get horizontal coordinate of node for placement */
+    inline qreal x( int i) const
+    {
+        return x_vec[ i];
+    }
+    /** Set horizontal coordinate of node for placement, node or chain entry itself is updated too */
+    inline void setX( int i, qreal x)
+    {
+        x_vec[ i] = x;
+        if ( isNotNullP( placed_nodes[ i]))
+        {
+            placed_nodes[ i]->setX( x);
+        } else
+        {
+            chain_p->setX( placed_entries[ i], x);
+        }
+    }
+    /** Get width of node for placement */
+    inline qreal width( int i) const
+    {
+        return width_vec[ i];
+    }
+    /** Get order of node for placement */
+    inline int order( int i) const
+    {
+        return order_vec[ i];
+    }
+    /** Get type of node for placement */
+    inline AuxNodeType type( int i) const
+    {
+        return type_vec[ i];
+    }
+    /** Get barycenter of node for placement */
+    inline qreal bc( int i) const
+    {
+        return bc_vec[ i];
+    }
+    /** Get number of peers of node for placement */
+    inline unsigned int weight( int i) const
+    {
+        return weight_vec[ i];
+    }
     /** Sort nodes by their order */
     void sortNodesByOrder();
     /** Get level's rank */
@@ -280,6 +655,26 @@ public:
         node->setLevel( this);
         node->setRank( level_rank);
     }
+    /** Get chain entries */
+    inline const QVector< int> &entries() const
+    {
+        return entry_list;
+    }
+    /** Get chains that entries belong to */
+    inline EdgeChains *chains() const
+    {
+        return chain_p;
+    }
+    /** Add a chain entry */
+    inline void addEntry( EdgeChains *chains, int entry)
+    {
+        entry_list.push_back( entry);
+        chain_p = chains;
+        if ( _height < chains->height())
+            _height = chains->height();
+    }
+    /** Replace chain entries with given edge control nodes indexed by entry */
+    void materializeEntries( const QVector< AuxNode *> &controls);
     /** Set level height */
     inline void setHeight( qreal h)
     {
@@ -302,10 +697,22 @@ public:
     }
 };
 
+/** Find vertical position for each level in given vector */
+void adjustLevelsVertically( QVector< Level*> &levels);
+
+/** Assign X coordinates to the nodes of given levels, reporting to progress if it is given */
+void arrangeLevelsHorizontally( QVector< Level*> &levels, LayoutProgress *progress = NULL);
+
+/** Fill placement arrays of levels and link them with each other */
+void initLevelsPlacement( QVector< Level*> &levels);
+
+/** Perform one of LAYOUT_PASSES_NUM placement passes over given levels, false if it was cancelled */
+bool arrangeLevelsPass( QVector< Level*> &levels, int pass, NodeGroups &groups, LayoutProgress *progress = NULL);
+
 /** Constructors are made private, only nodes and graph can create edges */
 inline AuxEdge::AuxEdge( AuxGraph *graph_p, int _id, AuxNode *_pred, AuxNode* _succ):
     Edge( graph_p, _id, _pred, _succ),
-    priv_fixed( true), priv_type( UNKNOWN_TYPE_EDGE) 
+    priv_fixed( true), priv_type( UNKNOWN_TYPE_EDGE), priv_chain( -1) 
 {
     if ( _pred == _succ)
         priv_type = SELF_EDGE;
@@ -321,6 +728,7 @@ inline AuxNode::AuxNode( AuxGraph *graph_p, int _id):
     priv_priority(-1),
     priv_level( NULL),
     priv_order(-1),
+    priv_index(-1),
     node_type( AUX_NODE_SIMPLE),
     is_for_placement( true),
     stable( false)
@@ -39,6 +39,44 @@ enum AuxNodeType
     AUX_NODE_TYPES_NUM
 };
 
+/**
+ * Spacing between adjacent nodes of given types, previous node's type
+ * is AUX_NODE_TYPES_NUM for the first node
+ */
+inline qreal nodeSpacing( AuxNodeType prev_type, AuxNodeType node_type)
+{
+    switch ( prev_type)
+    {
+        case AUX_NODE_SIMPLE:
+            if ( node_type == AUX_NODE_SIMPLE)
+            {
+                return NODE_NODE_MARGIN;
+            } else
+            {
+                return NODE_CONTROL_MARGIN;
+            }
+        case AUX_EDGE_CONTROL:
+            if ( node_type == AUX_NODE_SIMPLE)
+            {
+                return NODE_CONTROL_MARGIN;
+            } else
+            {
+                return CONTROL_CONTROL_MARGIN;
+            }
+        case AUX_EDGE_LABEL:
+            if ( node_type == AUX_NODE_SIMPLE)
+            {
+                return NODE_NODE_MARGIN;
+            } else
+            {
+                return NODE_CONTROL_MARGIN;
+            }
+        case AUX_NODE_TYPES_NUM:
+            return 0;
+    }
+    return NODE_NODE_MARGIN;
+}
+
 /**
  * Represents nodes and edge controls in Layout
  * 
@@ -54,6 +92,7 @@ class AuxNode: public Node
     int priv_priority;
     Level * priv_level;
     int priv_order;
+    int priv_index;
     Rank priv_rank;
     AuxNodeType node_type;
     bool is_for_placement;
@@ -171,6 +210,16 @@ public:
     {
         return priv_level;
     }
+    /** Get index of node in level's placement arrays */
+    inline int placementIndex() const
+    {
+        return priv_index;
+    }
+    /** Set index of node in level's placement arrays */
+    inline void setPlacementIndex( int index)
+    {
+        priv_index = index;
+    }
     /** Set order */
     inline void setOrder( int order)
     {
@@ -262,36 +311,7 @@ public:
      */
     inline qreal spacing( AuxNodeType prev_type) const
     {
-        switch ( prev_type)
-        {
-            case AUX_NODE_SIMPLE:
-                if ( node_type == AUX_NODE_SIMPLE)
-                {
-                    return NODE_NODE_MARGIN;
-                } else
-                {
-                    return NODE_CONTROL_MARGIN;
-                }
-            case AUX_EDGE_CONTROL:
-                if ( node_type == AUX_NODE_SIMPLE)
-                {
-                    return NODE_CONTROL_MARGIN;
-                } else
-                {
-                    return CONTROL_CONTROL_MARGIN;
-                }
-            case AUX_EDGE_LABEL:
-                if ( node_type == AUX_NODE_SIMPLE)
-                {
-                    return NODE_NODE_MARGIN;
-                } else
-                {
-                    return NODE_CONTROL_MARGIN;
-                }
-            case AUX_NODE_TYPES_NUM:
-                return 0;
-        }
-        return NODE_NODE_MARGIN;
+        return nodeSpacing( prev_type, node_type);
     }
     
     /** Destructor */
@@ -0,0 +1,274 @@
+/**
+ * @file: component.cpp
+ * Implementation of layout graph components and their packing
+ * Layout library, 2d graph placement of graphs in ShowGraph tool.
+ * Copyright (c) 2009, Boris Shurygin
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "layout_iface.h"
+
+/**
+ * Default constructor
+ */
+LayoutComponent::LayoutComponent():
+    level_vector(),
+    node_num( 0),
+    min_id( 0),
+    bounding_rect()
+{
+
+}
+
+/**
+ * Destructor. Nodes are not owned by component, only levels are
+ */
+LayoutComponent::~LayoutComponent()
+{
+    for ( int i = 0; i < level_vector.size(); i++)
+    {
+        delete level_vector[ i];
+    }
+}
+
+/**
+ * Get level of given rank. Missing levels up to the given one are created
+ */
+Level *
+LayoutComponent::levelForRank( Rank rank)
+{
+    if ( level_vector.size() <= ( int)rank)
+    {
+        int old_size = level_vector.size();
+        level_vector.resize( rank + 1);
+        for ( int i = old_size; i <= ( int)rank; i++)
+        {
+            level_vector[ i] = new Level( i);
+        }
+    }
+    return level_vector[ rank];
+}
+
+/**
+ * Add node to the component's level of the same rank.
+ * Nodes should come in the order they have inside graph's levels
+ */
+void
+LayoutComponent::add( AuxNode *node)
+{
+    Rank rank = node->rank();
+
+    LAYOUT_ASSERTD( rank != RANK_UNDEF, "Node should be ranked before it's added to component");
+
+    if ( node_num == 0 || node->id() < min_id)
+    {
+        min_id = node->id();
+    }
+    node_num++;
+    levelForRank( rank)->add( node);
+}
+
+/**
+ * Add chain entry to the component's level of the same rank.
+ * Entries should come in the order they have inside graph's levels
+ */
+void
+LayoutComponent::addEntry( EdgeChains *chains, int entry)
+{
+    levelForRank( chains->rank( entry))->addEntry( chains, entry);
+}
+
+/**
+ * Perform vertical and horizontal placement of component's nodes.
+ * Touches only nodes of this component so it is safe to run for several components at once
+ */
+void
+LayoutComponent::arrange( LayoutProgress *progress)
+{
+    adjustLevelsVertically( level_vector);
+    arrangeLevelsHorizontally( level_vector, progress);
+    computeBoundingRect();
+}
+
+/**
+ * Cheap placement of component's nodes that anytime layout shows first
+ */
+void
+LayoutComponent::placeByOrder()
+{
+    adjustLevelsVertically( level_vector);
+    for ( int i = 0; i < level_vector.size(); i++)
+    {
+        level_vector[ i]->placeByOrder();
+    }
+    computeBoundingRect();
+}
+
+/**
+ * Perform one pass of horizontal placement starting from the placement that placeByOrder() gave.
+ * Like arrange() it touches only nodes of this component
+ */
+void
+LayoutComponent::arrangePass( int pass, LayoutProgress *progress)
+{
+    NodeGroups groups;
+
+    if ( pass == 0)
+        initLevelsPlacement( level_vector);
+    arrangeLevelsPass( level_vector, pass, groups, progress);
+    computeBoundingRect();
+}
+
+/**
+ * Compute bounding rectangle of nodes and chain entries that were placed
+ */
+void
+LayoutComponent::computeBoundingRect()
+{
+    bool first = true;
+    qreal left = 0;
+    qreal right = 0;
+    qreal top = 0;
+    qreal bottom = 0;
+
+    for ( int i = 0; i < level_vector.size(); i++)
+    {
+        Level *level = level_vector[ i];
+        EdgeChains *chains = level->chains();
+
+        if ( isNotNullP( chains) && chains->isForPlacement())
+        {
+            foreach ( int entry, level->entries())
+            {
+                qreal x = chains->x( entry);
+                qreal y = level->y() - chains->height() / 2;
+
+                if ( first || x < left)
+                    left = x;
+                if ( first || x + chains->width() > right)
+                    right = x + chains->width();
+                if ( first || y < top)
+                    top = y;
+                if ( first || y + chains->height() > bottom)
+                    bottom = y + chains->height();
+                first = false;
+            }
+        }
+        foreach ( AuxNode *node, level->nodes())
+        {
+            if ( !node->isForPlacement())
+                continue;
+
+            if ( first || node->modelX() < left)
+                left = node->modelX();
+            if ( first || node->modelX() + node->width() > right)
+                right = node->modelX() + node->width();
+            if ( first || node->modelY() < top)
+                top = node->modelY();
+            if ( first || node->modelY() + node->height() > bottom)
+                bottom = node->modelY() + node->height();
+            first = false;
+        }
+    }
+    bounding_rect = QRectF( left, top, right - left, bottom - top);
+}
+
+/**
+ * Move component's nodes and levels
+ */
+void
+LayoutComponent::translate( qreal dx, qreal dy)
+{
+    for ( int i = 0; i < level_vector.size(); i++)
+    {
+        Level *level = level_vector[ i];
+
+        level->setY( level->y() + dy);
+        foreach ( AuxNode *node, level->nodes())
+        {
+            if ( !node->isForPlacement())
+                continue;
+            node->setX( node->modelX() + dx);
+            node->setY( node->modelY() + dy);
+        }
+        /** Entries get vertical coordinates from their levels later */
+        EdgeChains *chains = level->chains();
+        if ( isNotNullP( chains) && chains->isForPlacement())
+        {
+            foreach ( int entry, level->entries())
+            {
+                chains->setX( entry, chains->x( entry) + dx);
+            }
+        }
+    }
+    bounding_rect.translate( dx, dy);
+}
+
+/**
+ * Compare components for packing: taller first, smaller id for equal heights
+ */
+static bool compareComponents( LayoutComponent *comp1,
+                               LayoutComponent *comp2)
+{
+    if ( comp1->boundingRect().height() == comp2->boundingRect().height())
+    {
+        return comp1->minId() < comp2->minId();
+    }
+    return comp1->boundingRect().height() > comp2->boundingRect().height();
+}
+
+/**
+ * Pack components using shelf algorithm.
+ * Components are sorted by height and placed left to right in rows ( shelves).
+ * Row width is chosen so that the resulting picture is close to a square.
+ * Takes O( N * log N) for N components
+ */
+void packComponents( QVector< LayoutComponent *> &components)
+{
+    if ( components.isEmpty())
+        return;
+
+    QVector< LayoutComponent *> sorted = components;
+    qStableSort( sorted.begin(), sorted.end(), compareComponents);
+
+    qreal area = 0;
+    qreal max_width = 0;
+
+    foreach ( LayoutComponent *comp, sorted)
+    {
+        QRectF rect = comp->boundingRect();
+        area += ( rect.width() + COMPONENT_SPACING) * ( rect.height() + COMPONENT_SPACING);
+        if ( max_width < rect.width())
+            max_width = rect.width();
+    }
+    qreal row_width = qMax( max_width, qSqrt( area));
+    qreal x = 0;
+    qreal y = 0;
+    qreal row_height = 0;
+
+    foreach ( LayoutComponent *comp, sorted)
+    {
+        QRectF rect = comp->boundingRect();
+
+        /** Start new row if current one is full */
+        if ( x > 0 && x + rect.width() > row_width)
+        {
+            y += row_height + COMPONENT_SPACING;
+            x = 0;
+            row_height = 0;
+        }
+        comp->translate( x - rect.left(), y - rect.top());
+        x += rect.width() + COMPONENT_SPACING;
+        if ( row_height < rect.height())
+            row_height = rect.height();
+    }
+}
@@ -0,0 +1,89 @@
+/**
+ * @file: component.h
+ * Connected component of layout graph
+ *
+ * Layout library, 2d graph placement of graphs in ShowGraph tool.
+ * Copyright (c) 2009, Boris Shurygin
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef COMPONENT_H
+#define COMPONENT_H
+
+/**
+ * Weakly connected component of layout graph
+ *
+ * @ingroup HLayout
+ * Component owns its own levels. Nodes of different components never
+ * affect each other's placement so components are arranged independently
+ * (and concurrently) and then packed on the plane by packComponents()
+ */
+class LayoutComponent
+{
+    /** Levels of the component indexed by rank */
+    QVector< Level*> level_vector;
+    /** Number of nodes in component */
+    GraphNum node_num;
+    /** Smallest node id in component, used as a stable sorting key */
+    GraphUid min_id;
+    /** Rectangle occupied by component's nodes */
+    QRectF bounding_rect;
+
+    /** Get level of given rank, levels are created if needed */
+    Level *levelForRank( Rank rank);
+public:
+    /** Default constructor */
+    LayoutComponent();
+    /** Destructor. Deletes component's levels */
+    ~LayoutComponent();
+
+    /** Add node to the level of component that corresponds to node's rank */
+    void add( AuxNode *node);
+    /** Add chain entry to the level of component that corresponds to entry's rank */
+    void addEntry( EdgeChains *chains, int entry);
+    /** Arrange levels vertically and nodes horizontally */
+    void arrange( LayoutProgress *progress = NULL);
+    /** Arrange levels vertically and put nodes in their order, placement passes are done by arrangePass */
+    void placeByOrder();
+    /** Perform one pass of horizontal placement */
+    void arrangePass( int pass, LayoutProgress *progress = NULL);
+    /** Compute rectangle occupied by the placed nodes */
+    void computeBoundingRect();
+    /** Move all nodes of the component by given offset */
+    void translate( qreal dx, qreal dy);
+
+    /** Get component's levels */
+    inline QVector< Level*> &levels()
+    {
+        return level_vector;
+    }
+    /** Get number of nodes */
+    inline GraphNum nodeCount() const
+    {
+        return node_num;
+    }
+    /** Get smallest node id */
+    inline GraphUid minId() const
+    {
+        return min_id;
+    }
+    /** Get bounding rectangle */
+    inline QRectF boundingRect() const
+    {
+        return bounding_rect;
+    }
+};
+
+/** Pack components' bounding rectangles on the plane and move components accordingly */
+void packComponents( QVector< LayoutComponent *> &components);
+
+#endif /** COMPONENT_H */
@@ -0,0 +1,275 @@
+/**
+ * @file: cycle_breaking.cpp
+ * Greedy cycle breaking heuristic for layout graph
+ * Layout library, 2d graph placement of graphs in ShowGraph tool.
+ * Copyright (c) 2009, Boris Shurygin
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "layout_iface.h"
+
+/**
+ * Get real successor of edge, edge labels are passed through
+ */
+static AuxNode *realSucc( AuxEdge *e)
+{
+    AuxNode *succ = e->succ();
+    while ( succ->isEdgeLabel())
+    {
+        LAYOUT_ASSERTD( isNotNullP( succ->firstSucc()), "Edge label should have a successor");
+        succ = succ->firstSucc()->succ();
+    }
+    return succ;
+}
+
+/**
+ * Invert edge together with edges that go through labels after it
+ */
+static void invertLabelChain( AuxEdge *e)
+{
+    e->setBack();
+    for ( AuxNode *succ = e->succ();
+          succ->isEdgeLabel();
+          succ = succ->firstSucc()->succ())
+    {
+        succ->firstSucc()->setBack();
+    }
+}
+
+/**
+ * Bins of vertices for greedy cycle breaking
+ *
+ * @ingroup Layout
+ * Every vertex that is not removed yet lies in one bin: sinks, sources or
+ * the bin of its outdegree minus indegree. Bins are doubly linked lists kept in arrays
+ * so that a vertex is moved between bins in constant time
+ */
+class VertexBins
+{
+    /** First vertex of each bin */
+    QVector< int> head;
+    /** Next vertex in bin */
+    QVector< int> next;
+    /** Previous vertex in bin */
+    QVector< int> prev;
+    /** Bin of each vertex, -1 for removed ones */
+    QVector< int> bin_of;
+    /** Maximal degree, defines the range of bins */
+    int max_deg;
+public:
+    /** Bin of sinks */
+    static const int SINKS = 0;
+    /** Bin of sources */
+    static const int SOURCES = 1;
+
+    /** Constructor */
+    VertexBins( int vertex_num, int max_degree):
+        head( 2 * max_degree + 3, -1),
+        next( vertex_num, -1),
+        prev( vertex_num, -1),
+        bin_of( vertex_num, -1),
+        max_deg( max_degree)
+    {
+
+    }
+    /** Get number of bins */
+    inline int count() const
+    {
+        return head.size();
+    }
+    /** Get bin for vertex with given degrees */
+    inline int bin( int outdeg, int indeg) const
+    {
+        if ( outdeg == 0)
+            return SINKS;
+        if ( indeg == 0)
+            return SOURCES;
+        return 2 + max_deg + outdeg - indeg;
+    }
+    /** Get first vertex of bin, -1 if bin is empty */
+    inline int first( int b) const
+    {
+        return head[ b];
+    }
+    /** Check if vertex is removed */
+    inline bool isRemoved( int v) const
+    {
+        return bin_of[ v] < 0;
+    }
+    /** Put vertex in front of bin */
+    inline void insert( int v, int b)
+    {
+        bin_of[ v] = b;
+        prev[ v] = -1;
+        next[ v] = head[ b];
+        if ( head[ b] >= 0)
+            prev[ head[ b]] = v;
+        head[ b] = v;
+    }
+    /** Take vertex out of its bin */
+    inline void remove( int v)
+    {
+        int b = bin_of[ v];
+
+        if ( prev[ v] >= 0)
+        {
+            next[ prev[ v]] = next[ v];
+        } else
+        {
+            head[ b] = next[ v];
+        }
+        if ( next[ v] >= 0)
+            prev[ next[ v]] = prev[ v];
+        bin_of[ v] = -1;
+    }
+};
+
+/**
+ * Choose edges to invert using heuristic of Eades, Lin and Smyth.
+ * Vertices are put in a sequence: sinks go to its end, sources to its beginning and
+ * when there are none the vertex with greatest outdegree minus indegree goes to the beginning.
+ * Edges that go backwards in the sequence are inverted. Edge labels are not vertices,
+ * edge that passes through labels is inverted as a whole. Takes O( V + E)
+ */
+void AuxGraph::classifyEdgesGreedy()
+{
+    Numeration num = newNum();
+    QVector< AuxNode *> vertices;
+    AuxNode *n;
+    AuxEdge *e;
+
+    foreachNode( n, this)
+    {
+        if ( n->isEdgeLabel())
+            continue;
+        n->setNumber( num, vertices.size());
+        vertices.push_back( n);
+    }
+
+    int vertex_num = vertices.size();
+    QVector< int> outdeg( vertex_num, 0);
+    QVector< int> indeg( vertex_num, 0);
+
+    /** Count degrees, self edges don't matter */
+    for ( int v = 0; v < vertex_num; v++)
+    {
+        foreachSucc( e, vertices[ v])
+        {
+            int succ = realSucc( e)->number( num);
+            if ( succ != v)
+            {
+                outdeg[ v]++;
+                indeg[ succ]++;
+            }
+        }
+    }
+
+    /** Adjacency lists in contiguous arrays */
+    QVector< int> succ_begin( vertex_num + 1);
+    QVector< int> pred_begin( vertex_num + 1);
+    int max_deg = 0;
+
+    succ_begin[ 0] = 0;
+    pred_begin[ 0] = 0;
+    for ( int v = 0; v < vertex_num; v++)
+    {
+        succ_begin[ v + 1] = succ_begin[ v] + outdeg[ v];
+        pred_begin[ v + 1] = pred_begin[ v] + indeg[ v];
+        max_deg = qMax( max_deg, qMax( outdeg[ v], indeg[ v]));
+    }
+
+    QVector< int> succ_vec( succ_begin[ vertex_num]);
+    QVector< int> pred_vec( pred_begin[ vertex_num]);
+    QVector< int> pred_pos = pred_begin;
+
+    for ( int v = 0; v < vertex_num; v++)
+    {
+        int succ_pos = succ_begin[ v];
+        foreachSucc( e, vertices[ v])
+        {
+            int succ = realSucc( e)->number( num);
+            if ( succ != v)
+            {
+                succ_vec[ succ_pos++] = succ;
+                pred_vec[ pred_pos[ succ]++] = v;
+            }
+        }
+    }
+
+    /** Fill bins in reverse order so that vertices are taken in graph's order */
+    VertexBins bins( vertex_num, max_deg);
+    for ( int v = vertex_num - 1; v >= 0; v--)
+    {
+        bins.insert( v, bins.bin( outdeg[ v], indeg[ v]));
+    }
+
+    /** Build the sequence */
+    QVector< int> pos( vertex_num);
+    int left = 0;
+    int right = vertex_num - 1;
+    int max_bin = bins.count() - 1;
+
+    for ( int i = 0; i < vertex_num; i++)
+    {
+        int v;
+
+        if ( bins.first( VertexBins::SINKS) >= 0)
+        {
+            v = bins.first( VertexBins::SINKS);
+            pos[ v] = right--;
+        } else if ( bins.first( VertexBins::SOURCES) >= 0)
+        {
+            v = bins.first( VertexBins::SOURCES);
+            pos[ v] = left++;
+        } else
+        {
+            while ( bins.first( max_bin) < 0)
+                max_bin--;
+            v = bins.first( max_bin);
+            pos[ v] = left++;
+        }
+        bins.remove( v);
+
+        /** Update degrees of neighbours that are still in bins */
+        for ( int k = succ_begin[ v]; k < succ_begin[ v + 1]; k++)
+        {
+            int succ = succ_vec[ k];
+            if ( bins.isRemoved( succ))
+                continue;
+            bins.remove( succ);
+            indeg[ succ]--;
+            bins.insert( succ, bins.bin( outdeg[ succ], indeg[ succ]));
+            max_bin = qMax( max_bin, bins.bin( outdeg[ succ], indeg[ succ]));
+        }
+        for ( int k = pred_begin[ v]; k < pred_begin[ v + 1]; k++)
+        {
+            int pred = pred_vec[ k];
+            if ( bins.isRemoved( pred))
+                continue;
+            bins.remove( pred);
+            outdeg[ pred]--;
+            bins.insert( pred, bins.bin( outdeg[ pred], indeg[ pred]));
+        }
+    }
+
+    /** Invert edges that go backwards, self edges are inverted like DFS does it */
+    for ( int v = 0; v < vertex_num; v++)
+    {
+        foreachSucc( e, vertices[ v])
+        {
+            int succ = realSucc( e)->number( num);
+            if ( pos[ succ] <= pos[ v])
+                invertLabelChain( e);
+        }
+    }
+    freeNum( num);
+}
@@ -0,0 +1,82 @@
+/**
+ * @file: edge_chain.cpp
+ * Implementation of compact representation of long edges
+ * Layout library, 2d graph placement of graphs in ShowGraph tool.
+ * Copyright (c) 2009, Boris Shurygin
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "layout_iface.h"
+
+/**
+ * Default constructor
+ */
+EdgeChains::EdgeChains():
+    entry_width( EDGE_CONTROL_WIDTH),
+    entry_height( EDGE_CONTROL_HEIGHT),
+    for_placement( true)
+{
+    first_vec.push_back( 0);
+}
+
+/**
+ * Remove all chains. Edges' references to chains are left as they are
+ */
+void
+EdgeChains::clear()
+{
+    edge_vec.clear();
+    first_vec.resize( 1);
+    chain_vec.clear();
+    x_vec.clear();
+    order_vec.clear();
+    index_vec.clear();
+}
+
+/**
+ * Set parameters of entries, they should be the same as edge controls created from them have
+ */
+void
+EdgeChains::setEntryParams( qreal width, qreal height, bool placed)
+{
+    entry_width = width;
+    entry_height = height;
+    for_placement = placed;
+}
+
+/**
+ * Add chain for long edge. Entries get zero coordinates and no order
+ */
+int
+EdgeChains::addChain( AuxEdge *edge, int length)
+{
+    LAYOUT_ASSERTD( length > 0, "Chain should have entries");
+
+    int chain = edge_vec.size();
+    int first = chain_vec.size();
+
+    edge_vec.push_back( edge);
+    first_vec.push_back( first + length);
+    chain_vec.resize( first + length);
+    x_vec.resize( first + length);
+    order_vec.resize( first + length);
+    index_vec.resize( first + length);
+    for ( int i = first; i < first + length; i++)
+    {
+        chain_vec[ i] = chain;
+        x_vec[ i] = 0;
+        order_vec[ i] = -1;
+        index_vec[ i] = -1;
+    }
+    edge->setChain( chain);
+    return chain;
+}
@@ -0,0 +1,162 @@
+/**
+ * @file: edge_chain.h
+ * Compact representation of long edges
+ *
+ * Layout library, 2d graph placement of graphs in ShowGraph tool.
+ * Copyright (c) 2009, Boris Shurygin
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef EDGE_CHAIN_H
+#define EDGE_CHAIN_H
+
+/**
+ * Chains of pseudo nodes of edges that span several ranks
+ *
+ * @ingroup Layout
+ * Ranking doesn't insert an edge control node on each rank a long edge crosses.
+ * Instead the edge gets a chain with one entry per crossed rank. Entries of all
+ * chains are kept in shared arrays, entries of one chain are consecutive and go
+ * from the upper end of the edge to the lower one. Entries are put to levels and
+ * take part in ordering and horizontal placement like pseudo nodes. Real edge
+ * controls are created from entries when layout is done, see AuxGraph::createEdgeControls()
+ */
+class EdgeChains
+{
+    /** Long edge of each chain */
+    QVector< AuxEdge *> edge_vec;
+    /** First entry of each chain, last element is the number of entries */
+    QVector< int> first_vec;
+    /** Chain of each entry */
+    QVector< int> chain_vec;
+    /** Horizontal coordinates of entries */
+    QVector< qreal> x_vec;
+    /** Orders of entries */
+    QVector< int> order_vec;
+    /** Indexes of entries in their levels' placement arrays */
+    QVector< int> index_vec;
+    /** Width of entry */
+    qreal entry_width;
+    /** Height of entry */
+    qreal entry_height;
+    /** Whether entries take part in horizontal placement */
+    bool for_placement;
+public:
+    /** Default constructor */
+    EdgeChains();
+    
+    /** Remove all chains */
+    void clear();
+    /** Set parameters that entries share with edge controls */
+    void setEntryParams( qreal width, qreal height, bool placed);
+    /** Add chain of given number of entries for edge, returns number of the chain */
+    int addChain( AuxEdge *edge, int length);
+    
+    /** Get number of chains */
+    inline int count() const
+    {
+        return edge_vec.size();
+    }
+    /** Get number of entries */
+    inline int entryCount() const
+    {
+        return chain_vec.size();
+    }
+    /** Get edge of chain */
+    inline AuxEdge *edge( int chain) const
+    {
+        return edge_vec[ chain];
+    }
+    /** Get first ( upper) entry of chain */
+    inline int firstEntry( int chain) const
+    {
+        return first_vec[ chain];
+    }
+    /** Get last ( lower) entry of chain */
+    inline int lastEntry( int chain) const
+    {
+        return first_vec[ chain + 1] - 1;
+    }
+    /** Get chain of entry */
+    inline int chain( int entry) const
+    {
+        return chain_vec[ entry];
+    }
+    /** Get upper end of chain's edge */
+    inline AuxNode *top( int chain) const
+    {
+        return edge_vec[ chain]->isInverted() ? edge_vec[ chain]->succ() : edge_vec[ chain]->pred();
+    }
+    /** Get lower end of chain's edge */
+    inline AuxNode *bottom( int chain) const
+    {
+        return edge_vec[ chain]->isInverted() ? edge_vec[ chain]->pred() : edge_vec[ chain]->succ();
+    }
+    /** Get entry of chain adjacent to given end of its edge */
+    inline int entryNear( int chain, AuxNode *node) const
+    {
+        return areEqP( node, top( chain)) ? firstEntry( chain) : lastEntry( chain);
+    }
+    /** Get rank of entry */
+    inline Rank rank( int entry) const
+    {
+        int chain = chain_vec[ entry];
+        return top( chain)->rank() + 1 + entry - first_vec[ chain];
+    }
+    /** Get horizontal coordinate of entry */
+    inline qreal x( int entry) const
+    {
+        return x_vec[ entry];
+    }
+    /** Set horizontal coordinate of entry */
+    inline void setX( int entry, qreal x)
+    {
+        x_vec[ entry] = x;
+    }
+    /** Get order of entry */
+    inline int order( int entry) const
+    {
+        return order_vec[ entry];
+    }
+    /** Set order of entry */
+    inline void setOrder( int entry, int order)
+    {
+        order_vec[ entry] = order;
+    }
+    /** Get index of entry in level's placement arrays */
+    inline int placementIndex( int entry) const
+    {
+        return index_vec[ entry];
+    }
+    /** Set index of entry in level's placement arrays */
+    inline void setPlacementIndex( int entry, int index)
+    {
+        index_vec[ entry] = index;
+    }
+    /** Get width of entries */
+    inline qreal width() const
+    {
+        return entry_width;
+    }
+    /** Get height of entries */
+    inline qreal height() const
+    {
+        return entry_height;
+    }
+    /** Check if entries take part in horizontal placement */
+    inline bool isForPlacement() const
+    {
+        return for_placement;
+    }
+};
+
+#endif /** EDGE_CHAIN_H */
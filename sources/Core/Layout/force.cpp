@@ -0,0 +1,742 @@
+/**
+ * @file: force.cpp
+ * Force-directed placement with Barnes-Hut approximation of repulsion
+ * Layout library, 2d graph placement of graphs in ShowGraph tool.
+ * Copyright (c) 2009, Boris Shurygin
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "layout_iface.h"
+
+/** Golden angle in radians, spreads consecutive points evenly around a circle */
+static const qreal GOLDEN_ANGLE = 2.39996322972865332;
+
+/**
+ * Level of coarsening in force-directed layout
+ *
+ * @ingroup Layout
+ * Node of a level is a group of nodes of the graph merged together. Neighbours of
+ * node i are adj[ adj_begin[ i]] ... adj[ adj_begin[ i + 1] - 1], every edge is seen from both ends
+ */
+struct ForceLevel
+{
+    /** Start of each node's neighbours in adjacency array, one extra element marks the end */
+    QVector< int> adj_begin;
+    /** Neighbours */
+    QVector< int> adj;
+    /** Weights of edges to neighbours, number of graph's edges they stand for */
+    QVector< qreal> weight;
+    /** Number of graph's nodes merged into node */
+    QVector< qreal> mass;
+    /** Whether node keeps its position */
+    QVector< bool> fixed;
+    /** Horizontal coordinates of nodes' centers */
+    QVector< qreal> x;
+    /** Vertical coordinates of nodes' centers */
+    QVector< qreal> y;
+    /** Node of the next coarser level that node is merged into */
+    QVector< int> parent;
+
+    /** Get number of nodes */
+    inline int count() const
+    {
+        return mass.size();
+    }
+};
+
+/**
+ * Cell of Barnes-Hut quadtree
+ */
+struct ForceCell
+{
+    /** Left border of cell's square */
+    qreal left;
+    /** Top border of cell's square */
+    qreal top;
+    /** Side of cell's square */
+    qreal size;
+    /** Horizontal coordinate of center of mass */
+    qreal mass_x;
+    /** Vertical coordinate of center of mass */
+    qreal mass_y;
+    /** Mass of nodes inside cell */
+    qreal mass;
+    /** Number of nodes inside cell */
+    int count;
+    /** Index of the first of four children, -1 for leaf */
+    int first_child;
+    /** Parent cell, -1 for root */
+    int parent;
+    /** First node that got into leaf, -1 if there is none */
+    int body;
+};
+
+/**
+ * Barnes-Hut quadtree
+ *
+ * @ingroup Layout
+ * Plane is recursively divided into square cells so that each leaf has one node. A group
+ * of nodes that is far enough is replaced by its center of mass when repulsion is computed.
+ * Cells are kept in array, children always follow their parents in it.
+ * Nodes that coincide share a leaf at the maximal depth
+ */
+class ForceTree
+{
+    /** Cells, the first one is root */
+    QVector< ForceCell> cells;
+
+    /** Append cell with given square */
+    inline void addCell( qreal left, qreal top, qreal size, int parent)
+    {
+        ForceCell cell;
+
+        cell.left = left;
+        cell.top = top;
+        cell.size = size;
+        cell.mass_x = 0;
+        cell.mass_y = 0;
+        cell.mass = 0;
+        cell.count = 0;
+        cell.first_child = -1;
+        cell.parent = parent;
+        cell.body = -1;
+        cells.push_back( cell);
+    }
+    /** Get child of cell that contains given point */
+    inline int child( int c, qreal x, qreal y) const
+    {
+        const ForceCell &cell = cells[ c];
+        qreal half = cell.size / 2;
+        int quadrant = ( x >= cell.left + half ? 1 : 0) + ( y >= cell.top + half ? 2 : 0);
+
+        return cell.first_child + quadrant;
+    }
+    /** Add node to leaf */
+    inline void addBody( int c, int body, qreal x, qreal y, qreal mass)
+    {
+        ForceCell &cell = cells[ c];
+
+        if ( cell.body < 0)
+            cell.body = body;
+        cell.mass += mass;
+        cell.mass_x += mass * x;
+        cell.mass_y += mass * y;
+        cell.count++;
+    }
+    /** Divide leaf into four children and move its node to one of them */
+    void split( int c, const ForceLevel *level);
+    /** Put node into tree */
+    void insert( int body, const ForceLevel *level);
+public:
+    /** Build tree for nodes of level */
+    void build( const ForceLevel *level);
+    /** Accumulate repulsion that node at given point gets from all other nodes */
+    void repulsion( int body, qreal x, qreal y, qreal mass,
+                    qreal c, qreal &fx, qreal &fy) const;
+};
+
+/**
+ * Divide leaf. Its node's mass goes to the child, sums of inner cells are computed by build()
+ */
+void
+ForceTree::split( int c, const ForceLevel *level)
+{
+    int body = cells[ c].body;
+    qreal half = cells[ c].size / 2;
+    qreal left = cells[ c].left;
+    qreal top = cells[ c].top;
+
+    cells[ c].first_child = cells.size();
+    cells[ c].body = -1;
+    cells[ c].mass = 0;
+    cells[ c].mass_x = 0;
+    cells[ c].mass_y = 0;
+    cells[ c].count = 0;
+    addCell( left, top, half, c);
+    addCell( left + half, top, half, c);
+    addCell( left, top + half, half, c);
+    addCell( left + half, top + half, half, c);
+    addBody( child( c, level->x[ body], level->y[ body]),
+             body, level->x[ body], level->y[ body], level->mass[ body]);
+}
+
+/**
+ * Go down from root to the leaf that contains node splitting occupied leaves on the way
+ */
+void
+ForceTree::insert( int body, const ForceLevel *level)
+{
+    qreal x = level->x[ body];
+    qreal y = level->y[ body];
+    int c = 0;
+
+    for ( int depth = 0;; depth++)
+    {
+        if ( cells[ c].first_child < 0)
+        {
+            if ( cells[ c].count == 0 || depth >= FORCE_TREE_MAX_DEPTH)
+            {
+                addBody( c, body, x, y, level->mass[ body]);
+                return;
+            }
+            split( c, level);
+        }
+        c = child( c, x, y);
+    }
+}
+
+/**
+ * Build tree. Takes O( N * log N) for nodes that are spread evenly
+ */
+void
+ForceTree::build( const ForceLevel *level)
+{
+    int n = level->count();
+
+    cells.clear();
+    if ( n == 0)
+        return;
+
+    qreal left = level->x[ 0];
+    qreal right = level->x[ 0];
+    qreal top = level->y[ 0];
+    qreal bottom = level->y[ 0];
+
+    for ( int i = 1; i < n; i++)
+    {
+        left = qMin( left, level->x[ i]);
+        right = qMax( right, level->x[ i]);
+        top = qMin( top, level->y[ i]);
+        bottom = qMax( bottom, level->y[ i]);
+    }
+    /** Root square is a bit larger so that points on its far borders get inside */
+    qreal size = qMax( right - left, bottom - top) * 1.01 + 1;
+
+    cells.reserve( 2 * n + 1);
+    addCell( left, top, size, -1);
+    for ( int i = 0; i < n; i++)
+    {
+        insert( i, level);
+    }
+
+    /** Children follow parents in the array, so reverse walk collects sums bottom-up */
+    for ( int c = cells.size() - 1; c > 0; c--)
+    {
+        ForceCell &parent = cells[ cells[ c].parent];
+
+        parent.mass += cells[ c].mass;
+        parent.mass_x += cells[ c].mass_x;
+        parent.mass_y += cells[ c].mass_y;
+        parent.count += cells[ c].count;
+    }
+    for ( int c = 0; c < cells.size(); c++)
+    {
+        if ( cells[ c].mass > 0)
+        {
+            cells[ c].mass_x /= cells[ c].mass;
+            cells[ c].mass_y /= cells[ c].mass;
+        }
+    }
+}
+
+/**
+ * Repulsion is c * m1 * m2 / d for given constant c. A cell is replaced
+ * by its center of mass when it's seen at an angle less than FORCE_THETA
+ */
+void
+ForceTree::repulsion( int body, qreal x, qreal y, qreal mass,
+                      qreal c, qreal &fx, qreal &fy) const
+{
+    if ( cells.isEmpty())
+        return;
+
+    QVarLengthArray< int, 4 * FORCE_TREE_MAX_DEPTH> stack;
+    qreal theta2 = FORCE_THETA * FORCE_THETA;
+
+    stack.append( 0);
+    while ( stack.size() > 0)
+    {
+        const ForceCell &cell = cells[ stack[ stack.size() - 1]];
+        stack.resize( stack.size() - 1);
+
+        if ( cell.count == 0
+             || ( cell.first_child < 0 && cell.body == body && cell.count == 1))
+        {
+            continue;
+        }
+        qreal dx = x - cell.mass_x;
+        qreal dy = y - cell.mass_y;
+        qreal d2 = dx * dx + dy * dy;
+
+        if ( cell.first_child >= 0 && cell.size * cell.size >= theta2 * d2)
+        {
+            for ( int i = 0; i < 4; i++)
+            {
+                stack.append( cell.first_child + i);
+            }
+            continue;
+        }
+        if ( d2 < FORCE_MIN_DISTANCE * FORCE_MIN_DISTANCE)
+        {
+            /** Coincident nodes are pushed apart in direction that depends on node only */
+            dx = FORCE_MIN_DISTANCE * qCos( body * GOLDEN_ANGLE);
+            dy = FORCE_MIN_DISTANCE * qSin( body * GOLDEN_ANGLE);
+            d2 = FORCE_MIN_DISTANCE * FORCE_MIN_DISTANCE;
+        }
+        qreal f = c * mass * cell.mass / d2;
+        fx += dx * f;
+        fy += dy * f;
+    }
+}
+
+/**
+ * Range of nodes processed by one task of force accumulation
+ */
+struct ForceChunk
+{
+    /** First node */
+    int begin;
+    /** Node after the last one */
+    int end;
+};
+
+/**
+ * Functor that computes displacements of nodes of chunk.
+ * Each node's force is summed by one task in fixed order, so the result doesn't depend on threads
+ */
+struct ForceAccumulator
+{
+    /** Result type of call operator, required by QtConcurrent */
+    typedef void result_type;
+    /** Level being placed */
+    const ForceLevel *level;
+    /** Quadtree of level's nodes */
+    const ForceTree *tree;
+    /** Natural length of edge */
+    qreal k;
+    /** Center of picture */
+    QPointF center;
+    /** Horizontal displacements indexed by node */
+    qreal *disp_x;
+    /** Vertical displacements indexed by node */
+    qreal *disp_y;
+
+    /** Constructor */
+    ForceAccumulator( const ForceLevel *l, const ForceTree *t, qreal len, QPointF c,
+                      qreal *dx, qreal *dy):
+        level( l), tree( t), k( len), center( c), disp_x( dx), disp_y( dy){};
+
+    /** Compute displacements of chunk's nodes */
+    void operator()( ForceChunk &chunk)
+    {
+        for ( int i = chunk.begin; i < chunk.end; i++)
+        {
+            qreal fx = 0;
+            qreal fy = 0;
+            qreal x = level->x[ i];
+            qreal y = level->y[ i];
+
+            if ( level->fixed[ i])
+            {
+                disp_x[ i] = 0;
+                disp_y[ i] = 0;
+                continue;
+            }
+            tree->repulsion( i, x, y, level->mass[ i], FORCE_REPULSION * k * k, fx, fy);
+
+            /** Springs pull with w * d^2 / k */
+            for ( int j = level->adj_begin[ i]; j < level->adj_begin[ i + 1]; j++)
+            {
+                int nb = level->adj[ j];
+                qreal dx = x - level->x[ nb];
+                qreal dy = y - level->y[ nb];
+                qreal f = level->weight[ j] * qSqrt( dx * dx + dy * dy) / k;
+
+                fx -= dx * f;
+                fy -= dy * f;
+            }
+            /** Gravity keeps disconnected parts together */
+            fx -= FORCE_GRAVITY * level->mass[ i] * ( x - center.x());
+            fy -= FORCE_GRAVITY * level->mass[ i] * ( y - center.y());
+
+            disp_x[ i] = fx;
+            disp_y[ i] = fy;
+        }
+    }
+};
+
+/**
+ * Constructor. Only nodes for placement take part in layout, stable ones keep their positions
+ */
+ForceLayout::ForceLayout( AuxGraph *graph, bool multilevel):
+    nodes(),
+    levels(),
+    spring_len( FORCE_EDGE_LENGTH),
+    center( 0, 0),
+    has_fixed( false)
+{
+    Numeration num = graph->newNum();
+    ForceLevel *level = new ForceLevel;
+    qreal size_sum = 0;
+    AuxNode *n;
+    AuxEdge *e;
+
+    levels.push_back( level);
+    foreachNode( n, graph)
+    {
+        if ( !n->isForPlacement())
+            continue;
+        n->setNumber( num, nodes.size());
+        nodes.push_back( n);
+        size_sum += qMax( n->width(), n->height());
+    }
+
+    int node_num = nodes.size();
+    if ( node_num > 0)
+        spring_len += size_sum / node_num;
+
+    level->adj_begin.resize( node_num + 1);
+    level->mass.fill( 1, node_num);
+    level->fixed.resize( node_num);
+    level->x.resize( node_num);
+    level->y.resize( node_num);
+
+    /** Count neighbours, edge is seen from both ends, self edges don't matter */
+    QVector< int> degree( node_num, 0);
+    for ( int i = 0; i < node_num; i++)
+    {
+        foreachSucc( e, nodes[ i])
+        {
+            if ( !e->succ()->isNumbered( num) || e->succ() == nodes[ i])
+                continue;
+            degree[ i]++;
+            degree[ e->succ()->number( num)]++;
+        }
+    }
+    level->adj_begin[ 0] = 0;
+    for ( int i = 0; i < node_num; i++)
+    {
+        level->adj_begin[ i + 1] = level->adj_begin[ i] + degree[ i];
+    }
+    level->adj.resize( level->adj_begin[ node_num]);
+    level->weight.fill( 1, level->adj_begin[ node_num]);
+
+    QVector< int> pos = level->adj_begin;
+    for ( int i = 0; i < node_num; i++)
+    {
+        foreachSucc( e, nodes[ i])
+        {
+            if ( !e->succ()->isNumbered( num) || e->succ() == nodes[ i])
+                continue;
+            int succ = e->succ()->number( num);
+            level->adj[ pos[ i]++] = succ;
+            level->adj[ pos[ succ]++] = i;
+        }
+    }
+    graph->freeNum( num);
+
+    /** Positions of stable nodes are kept, nodes are pulled to their center */
+    int fixed_num = 0;
+    for ( int i = 0; i < node_num; i++)
+    {
+        n = nodes[ i];
+        level->fixed[ i] = n->isStable();
+        level->x[ i] = n->modelX() + n->width() / 2;
+        level->y[ i] = n->modelY() + n->height() / 2;
+        if ( n->isStable())
+        {
+            center += QPointF( level->x[ i], level->y[ i]);
+            fixed_num++;
+        }
+    }
+    if ( fixed_num > 0)
+    {
+        has_fixed = true;
+        center /= fixed_num;
+    }
+    if ( multilevel)
+        coarsen();
+    initPositions();
+}
+
+/**
+ * Destructor
+ */
+ForceLayout::~ForceLayout()
+{
+    for ( int i = 0; i < levels.size(); i++)
+    {
+        delete levels[ i];
+    }
+}
+
+/**
+ * Coarsen graph by heavy edge matching: nodes are visited in order and each unmatched one
+ * is merged with its unmatched neighbour connected by the heaviest edge. Fixed nodes are not merged.
+ * Coarsening stops when level is small enough or matching doesn't reduce it noticeably
+ */
+void
+ForceLayout::coarsen()
+{
+    while ( levels.last()->count() > FORCE_COARSEN_MIN_NODES)
+    {
+        ForceLevel *fine = levels.last();
+        int n = fine->count();
+        int coarse_num = 0;
+
+        fine->parent.fill( -1, n);
+        for ( int i = 0; i < n; i++)
+        {
+            if ( fine->parent[ i] >= 0)
+                continue;
+            int mate = -1;
+            if ( !fine->fixed[ i])
+            {
+                for ( int j = fine->adj_begin[ i]; j < fine->adj_begin[ i + 1]; j++)
+                {
+                    int nb = fine->adj[ j];
+                    if ( fine->parent[ nb] < 0 && !fine->fixed[ nb]
+                         && ( mate < 0 || fine->weight[ j] > fine->weight[ mate]))
+                    {
+                        mate = j;
+                    }
+                }
+            }
+            fine->parent[ i] = coarse_num;
+            if ( mate >= 0)
+                fine->parent[ fine->adj[ mate]] = coarse_num;
+            coarse_num++;
+        }
+        if ( coarse_num > FORCE_COARSEN_RATIO * n)
+        {
+            fine->parent.clear();
+            break;
+        }
+
+        /** Members of each coarse node */
+        QVector< int> member_begin( coarse_num + 1, 0);
+        QVector< int> members( n);
+        for ( int i = 0; i < n; i++)
+        {
+            member_begin[ fine->parent[ i] + 1]++;
+        }
+        for ( int c = 0; c < coarse_num; c++)
+        {
+            member_begin[ c + 1] += member_begin[ c];
+        }
+        QVector< int> member_pos = member_begin;
+        for ( int i = 0; i < n; i++)
+        {
+            members[ member_pos[ fine->parent[ i]]++] = i;
+        }
+
+        /** Merge edges, last_pos tells where the edge to a coarse node is in current node's list */
+        ForceLevel *coarse = new ForceLevel;
+        QVector< int> last_pos( coarse_num, -1);
+
+        coarse->adj_begin.resize( coarse_num + 1);
+        coarse->mass.fill( 0, coarse_num);
+        coarse->fixed.fill( false, coarse_num);
+        coarse->x.fill( 0, coarse_num);
+        coarse->y.fill( 0, coarse_num);
+        for ( int c = 0; c < coarse_num; c++)
+        {
+            coarse->adj_begin[ c] = coarse->adj.size();
+            for ( int m = member_begin[ c]; m < member_begin[ c + 1]; m++)
+            {
+                int i = members[ m];
+
+                coarse->mass[ c] += fine->mass[ i];
+                coarse->fixed[ c] = coarse->fixed[ c] || fine->fixed[ i];
+                coarse->x[ c] = fine->x[ i];
+                coarse->y[ c] = fine->y[ i];
+                for ( int j = fine->adj_begin[ i]; j < fine->adj_begin[ i + 1]; j++)
+                {
+                    int nb = fine->parent[ fine->adj[ j]];
+                    if ( nb == c)
+                        continue;
+                    if ( last_pos[ nb] >= coarse->adj_begin[ c])
+                    {
+                        coarse->weight[ last_pos[ nb]] += fine->weight[ j];
+                    } else
+                    {
+                        last_pos[ nb] = coarse->adj.size();
+                        coarse->adj.push_back( nb);
+                        coarse->weight.push_back( fine->weight[ j]);
+                    }
+                }
+            }
+        }
+        coarse->adj_begin[ coarse_num] = coarse->adj.size();
+        levels.push_back( coarse);
+    }
+}
+
+/**
+ * Movable nodes of the coarsest level are put on a spiral around the center,
+ * this gives the same start for the same graph and doesn't put nodes on a line
+ */
+void
+ForceLayout::initPositions()
+{
+    ForceLevel *level = levels.last();
+
+    for ( int i = 0; i < level->count(); i++)
+    {
+        if ( level->fixed[ i])
+            continue;
+        qreal r = spring_len * qSqrt( i + 0.5) / 2;
+        level->x[ i] = center.x() + r * qCos( i * GOLDEN_ANGLE);
+        level->y[ i] = center.y() + r * qSin( i * GOLDEN_ANGLE);
+    }
+}
+
+/**
+ * Nodes merged together are put around the coarse node's position, on opposite sides of it
+ */
+void
+ForceLayout::prolong( int level_index)
+{
+    ForceLevel *fine = levels[ level_index];
+    ForceLevel *coarse = levels[ level_index + 1];
+    QVector< bool> first_placed( coarse->count(), false);
+    qreal offset = spring_len / 4;
+
+    for ( int i = 0; i < fine->count(); i++)
+    {
+        if ( fine->fixed[ i])
+            continue;
+        int c = fine->parent[ i];
+        qreal sign = first_placed[ c] ? -1 : 1;
+
+        first_placed[ c] = true;
+        fine->x[ i] = coarse->x[ c] + sign * offset * qCos( c * GOLDEN_ANGLE);
+        fine->y[ i] = coarse->y[ c] + sign * offset * qSin( c * GOLDEN_ANGLE);
+    }
+}
+
+/**
+ * Iterations of Fruchterman-Reingold algorithm. Forces are accumulated by thread pool for big levels,
+ * then every movable node moves along its force by at most the current temperature.
+ * Temperature falls linearly to zero
+ */
+void
+ForceLayout::iterate( ForceLevel *level, int iter_num, qreal start_temp, LayoutProgress *progress)
+{
+    int n = level->count();
+    QVector< qreal> disp_x( n);
+    QVector< qreal> disp_y( n);
+    QVector< ForceChunk> chunks;
+    ForceTree tree;
+
+    for ( int begin = 0; begin < n; begin += FORCE_CHUNK_SIZE)
+    {
+        ForceChunk chunk;
+        chunk.begin = begin;
+        chunk.end = qMin( n, begin + FORCE_CHUNK_SIZE);
+        chunks.push_back( chunk);
+    }
+    ForceAccumulator accumulator( level, &tree, spring_len, center, disp_x.data(), disp_y.data());
+
+    for ( int iter = 0; iter < iter_num; iter++)
+    {
+        if ( isNotNullP( progress))
+        {
+            if ( progress->isCancelled())
+                return;
+            progress->step();
+        }
+        qreal temp = start_temp * ( iter_num - iter) / iter_num;
+
+        tree.build( level);
+        if ( n < FORCE_PARALLEL_MIN_NODES)
+        {
+            for ( int i = 0; i < chunks.size(); i++)
+            {
+                accumulator( chunks[ i]);
+            }
+        } else
+        {
+            QtConcurrent::blockingMap( chunks, accumulator);
+        }
+        for ( int i = 0; i < n; i++)
+        {
+            qreal len = qSqrt( disp_x[ i] * disp_x[ i] + disp_y[ i] * disp_y[ i]);
+
+            if ( len > 0)
+            {
+                qreal step = qMin( len, temp) / len;
+                level->x[ i] += disp_x[ i] * step;
+                level->y[ i] += disp_y[ i] * step;
+            }
+        }
+    }
+}
+
+/**
+ * Get number of iterations. The coarsest level gets the full budget, finer ones are only refined
+ */
+int
+ForceLayout::stepsNum() const
+{
+    return FORCE_ITERATIONS_NUM + ( levels.size() - 1) * FORCE_REFINE_ITERATIONS_NUM;
+}
+
+/**
+ * Place the coarsest level and refine placement level by level down to the graph itself
+ */
+void
+ForceLayout::run( LayoutProgress *progress)
+{
+    int coarsest = levels.size() - 1;
+    qreal width = spring_len * qSqrt( ( qreal)levels[ coarsest]->count());
+
+    iterate( levels[ coarsest], FORCE_ITERATIONS_NUM, spring_len + width / 10, progress);
+    for ( int i = coarsest - 1; i >= 0; i--)
+    {
+        prolong( i);
+        iterate( levels[ i], FORCE_REFINE_ITERATIONS_NUM, spring_len, progress);
+    }
+}
+
+/**
+ * Write positions of nodes' top-left corners. Unless some nodes were fixed
+ * the picture is moved so that it starts at origin like layered layout does
+ */
+void
+ForceLayout::apply()
+{
+    ForceLevel *level = levels.first();
+    qreal left = 0;
+    qreal top = 0;
+
+    if ( !has_fixed)
+    {
+        for ( int i = 0; i < nodes.size(); i++)
+        {
+            qreal x = level->x[ i] - nodes[ i]->width() / 2;
+            qreal y = level->y[ i] - nodes[ i]->height() / 2;
+
+            if ( i == 0 || x < left)
+                left = x;
+            if ( i == 0 || y < top)
+                top = y;
+        }
+    }
+    for ( int i = 0; i < nodes.size(); i++)
+    {
+        if ( level->fixed[ i])
+            continue;
+        nodes[ i]->setX( level->x[ i] - nodes[ i]->width() / 2 - left);
+        nodes[ i]->setY( level->y[ i] - nodes[ i]->height() / 2 - top);
+    }
+}
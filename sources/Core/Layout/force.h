@@ -0,0 +1,72 @@
+/**
+ * @file: force.h
+ * Force-directed placement of layout graph
+ *
+ * Layout library, 2d graph placement of graphs in ShowGraph tool.
+ * Copyright (c) 2009, Boris Shurygin
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef FORCE_H
+#define FORCE_H
+
+struct ForceLevel;
+
+/**
+ * Force-directed placement of layout graph
+ *
+ * @ingroup Layout
+ * Nodes repel each other and edges pull their ends together like springs
+ * ( Fruchterman and Reingold). Repulsion is approximated with Barnes-Hut quadtree
+ * so an iteration takes O( N * log N) instead of O( N^2). Edge directions are not taken
+ * into account, this suits graphs that have no natural hierarchy.
+ * Graph is copied to contiguous arrays by constructor and coordinates are written
+ * back by apply(), so run() doesn't touch nodes and may be done by background worker.
+ * In multilevel mode graph is coarsened by merging matched neighbours, the coarsest
+ * graph is placed first and its placement is refined level by level
+ */
+class ForceLayout
+{
+    /** Nodes for placement in order of their indexes in the finest level */
+    QVector< AuxNode *> nodes;
+    /** Levels of coarsening, the first one is the graph itself */
+    QVector< ForceLevel *> levels;
+    /** Natural length of edge */
+    qreal spring_len;
+    /** Center of picture that nodes are pulled to */
+    QPointF center;
+    /** Whether some nodes keep their positions, picture is not moved to origin then */
+    bool has_fixed;
+
+    /** Build coarser levels by merging matched neighbours */
+    void coarsen();
+    /** Give initial positions to movable nodes of the coarsest level */
+    void initPositions();
+    /** Perform given number of iterations on the level */
+    void iterate( ForceLevel *level, int iter_num, qreal start_temp, LayoutProgress *progress);
+    /** Give nodes of level positions of coarse nodes they were merged into */
+    void prolong( int level_index);
+public:
+    /** Constructor. Copies graph to arrays and coarsens it if multilevel mode is on */
+    ForceLayout( AuxGraph *graph, bool multilevel);
+    /** Destructor */
+    ~ForceLayout();
+
+    /** Get number of iterations that run() performs, they are counted as progress steps */
+    int stepsNum() const;
+    /** Compute positions, nodes of graph are not touched */
+    void run( LayoutProgress *progress = NULL);
+    /** Write computed positions to nodes */
+    void apply();
+};
+
+#endif /** FORCE_H */
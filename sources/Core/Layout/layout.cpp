@@ -20,149 +20,527 @@
 
 
 /**
- * Arrange nodes in level
+ * Functor for arranging connected components in thread pool
  */
-void arrangeLevel( Level *level, GraphDir dir, bool commit_placement, bool first_pass)
+struct ComponentArranger
 {
-    level->arrangeNodes( dir, commit_placement, first_pass);
-}
+    /** Result type of call operator, required by QtConcurrent */
+    typedef void result_type;
+    /** Progress to report to */
+    LayoutProgress *progress;
+
+    /** Constructor */
+    ComponentArranger( LayoutProgress *p): progress( p){};
+    /** Arrange component */
+    void operator()( LayoutComponent *comp)
+    {
+        comp->arrange( progress);
+    }
+};
+
+/**
+ * Functor for performing one placement pass over connected components in thread pool
+ */
+struct ComponentPassArranger
+{
+    /** Result type of call operator, required by QtConcurrent */
+    typedef void result_type;
+    /** Number of pass */
+    int pass;
+    /** Progress to report to */
+    LayoutProgress *progress;
+
+    /** Constructor */
+    ComponentPassArranger( int ps, LayoutProgress *p): pass( ps), progress( p){};
+    /** Perform pass over component */
+    void operator()( LayoutComponent *comp)
+    {
+        comp->arrangePass( pass, progress);
+    }
+};
 
 /**
- * Compare orders of nodes
+ * Part of ranking frontier processed by one task
+ */
+struct RankingChunk
+{
+    /** First node of frontier */
+    int begin;
+    /** Node after the last one */
+    int end;
+    /** Nodes whose predecessors all got ranked while processing this part */
+    QVector< AuxNode *> ready;
+};
+
+/**
+ * Functor that ranks nodes of frontier chunk and releases their successors
+ */
+struct FrontierRanker
+{
+    /** Result type of call operator, required by QtConcurrent */
+    typedef void result_type;
+    /** Current frontier */
+    AuxNode * const *frontier;
+    /** Numbers of not yet ranked predecessors indexed by node */
+    QAtomicInt *counters;
+    /** Numeration that indexes counters */
+    Numeration own;
+    /** Ranking numeration */
+    Numeration ranking;
+    /** Rank of frontier nodes */
+    GraphNum rank;
+
+    /** Constructor */
+    FrontierRanker( QAtomicInt *c, Numeration o, Numeration r):
+        frontier( NULL), counters( c), own( o), ranking( r), rank( 0){};
+
+    /** Decrement predecessors counter of node, node is ready when it gets to zero */
+    inline void release( AuxNode *node, RankingChunk &chunk)
+    {
+        if ( counters[ node->number( own)].fetchAndAddOrdered( -1) == 1)
+            chunk.ready.push_back( node);
+    }
+    /** Rank nodes of chunk */
+    void operator()( RankingChunk &chunk)
+    {
+        for ( int i = chunk.begin; i < chunk.end; i++)
+        {
+            AuxNode *n = frontier[ i];
+            AuxEdge *e;
+
+            n->setNumber( ranking, rank);
+            foreachSucc( e, n)
+            {
+                if ( e->pred() != e->succ() && !e->isInverted())
+                    release( e->succ(), chunk);
+            }
+            foreachPred( e, n)
+            {
+                if ( e->pred() != e->succ() && e->isInverted())
+                    release( e->pred(), chunk);
+            }
+        }
+    }
+};
+
+/**
+ * Compare orders of nodes, ties are broken by id so that sorting doesn't depend on list order
  */
 bool compareOrders( AuxNode* node1,
                     AuxNode* node2)
 {
+    if ( node1->order() == node2->order())
+        return node1->id() < node2->id();
     return ( node1->order() < node2->order());
 }
 
 /**
- * compare center coordinates of group
+ * Compare orders of chain entries
  */
-bool compareGroups( NodeGroup* g1,
-                    NodeGroup* g2)
+struct EntryOrderLess
 {
-    /*
-     * center = g.left + width / 2 = g.left + ( g.right - g.left) / 2 = ( g.left + g.right)/2
-     *
-     *                g1.center < g2.center 
-     * (g1.left + g1.right) / 2 < (g2.left + g2.right) / 2
-     *       g1.left + g1.right < g2.left + g2.right
-     */
-    
-    if ( g1->nodes().count() == 1 && g1->nodes().count() == 1)
+    /** Chains that entries belong to */
+    const EdgeChains *chains;
+
+    /** Constructor */
+    EntryOrderLess( const EdgeChains *c): chains( c){};
+    /** Comparison */
+    inline bool operator()( int entry1, int entry2) const
     {
-        if ( g1->left() + g1->right() == g2->left() + g2->right()) 
-        {
-            return g1->nodes().first()->order() < g2->nodes().first()->order();
-        }
+        if ( chains->order( entry1) == chains->order( entry2))
+            return entry1 < entry2;
+        return chains->order( entry1) < chains->order( entry2);
     }
-    return ( g1->left() + g1->right() < g2->left() + g2->right());
-}
+};
 
 /**
- * Sort nodes in a level with respect to their order
+ * Sort nodes and chain entries in a level with respect to their order
  */
 void Level::sortNodesByOrder()
 {
     qSort( node_list.begin(), node_list.end(), compareOrders);
+    if ( isNotNullP( chain_p))
+    {
+        qSort( entry_list.begin(), entry_list.end(), EntryOrderLess( chain_p));
+    }
 }
 
 /**
- * Arranges nodes using group merge algorithm.
- * NodeGroup is a group of nodes which interleave if we apply barycentric heuristic directly.
- * These nodes are placed within group borders. If two groups interleave they are merged.
- * Arrangement is performed iteratively starting with groups that have one node each.
+ * Fill placement arrays. Nodes and chain entries are merged by order.
+ * Coordinates of nodes and entries are taken as starting positions
  */
-void Level::arrangeNodes( GraphDir dir, bool commit_placement, bool first_pass)
+void Level::initPlacement()
 {
-    QList< NodeGroup *> list;
-    foreach ( AuxNode* node, node_list)
+    bool place_entries = isNotNullP( chain_p) && chain_p->isForPlacement();
+    QList< AuxNode*>::const_iterator it = node_list.constBegin();
+    int k = 0;
+
+    placed_nodes.clear();
+    placed_entries.clear();
+    while ( it != node_list.constEnd() || k < entry_list.size())
     {
-        if ( node->isForPlacement())
+        if ( k == entry_list.size()
+             || ( it != node_list.constEnd()
+                  && ( *it)->order() <= chain_p->order( entry_list[ k])))
         {
-            NodeGroup* group = new NodeGroup( node, dir, first_pass);
-            list.push_back( group);
+            AuxNode *node = *it;
+            if ( node->isForPlacement())
+            {
+                node->setPlacementIndex( placed_nodes.size());
+                placed_nodes.push_back( node);
+                placed_entries.push_back( -1);
+            } else
+            {
+                node->setPlacementIndex( -1);
+            }
+            it++;
+        } else
+        {
+            int entry = entry_list[ k];
+            if ( place_entries)
+            {
+                chain_p->setPlacementIndex( entry, placed_nodes.size());
+                placed_nodes.push_back( NULL);
+                placed_entries.push_back( entry);
+            } else
+            {
+                chain_p->setPlacementIndex( entry, -1);
+            }
+            k++;
         }
     }
-    /** Sort groups with respect to their coordinates */
-    qSort( list.begin(), list.end(), compareGroups);
     
-    QLinkedList< NodeGroup *> groups;
-    
-    foreach( NodeGroup *group, list)
+    int num = placed_nodes.size();
+    x_vec.resize( num);
+    width_vec.resize( num);
+    offset_vec.resize( num);
+    center_vec.resize( num);
+    order_vec.resize( num);
+    type_vec.resize( num);
+    stable_vec.resize( num);
+    bc_vec.resize( num);
+    weight_vec.resize( num);
+
+    for ( int i = 0; i < num; i++)
     {
-        groups.push_back( group);
+        AuxNode *node = placed_nodes[ i];
+
+        if ( isNullP( node))
+        {
+            int entry = placed_entries[ i];
+            
+            x_vec[ i] = chain_p->x( entry);
+            width_vec[ i] = chain_p->width();
+            offset_vec[ i] = width_vec[ i] / 2;
+            order_vec[ i] = chain_p->order( entry);
+            type_vec[ i] = AUX_EDGE_CONTROL;
+            stable_vec[ i] = false;
+            continue;
+        }
+        x_vec[ i] = node->modelX();
+        width_vec[ i] = node->width();
+        /** Edges are attached to the left border of label and to the center of other nodes */
+        offset_vec[ i] = node->isEdgeLabel() ? 0 : width_vec[ i] / 2;
+        order_vec[ i] = node->order();
+        type_vec[ i] = node->type();
+        stable_vec[ i] = node->isStable();
     }
-    
-    QLinkedList< NodeGroup *>::iterator it = groups.begin();
+    updateCenters();
+}
 
-    /**
-     * For each group
-     */
-    while( groups.count())
+/**
+ * Compare edges so that long ones go first, the one with greater chain number ahead
+ */
+static bool compareLongFirst( AuxEdge *e1,
+                              AuxEdge *e2)
+{
+    if ( e1->chain() < 0)
+        return false;
+    return e2->chain() < 0 || e1->chain() > e2->chain();
+}
+
+/**
+ * Collect edges of node in given direction in the order edge lists will have after
+ * AuxGraph::createEdgeControls(). Creation of controls on a long edge puts a new edge
+ * in front of the lower node's predecessors so long predecessors go first, in reverse order of chains
+ */
+static void collectEdges( AuxNode *n, GraphDir dir, QVector< AuxEdge *> &edges)
+{
+    bool has_long = false;
+
+    edges.clear();
+    for ( AuxEdge* e = n->firstEdgeInDir( dir);
+          isNotNullP( e);
+          e = e->nextEdgeInDir( dir))
     {
-        /*
-         * 1. Look at the group to the right and left and see they interleave
-         *    if they do -> merge groups and repeat
-         */
-        NodeGroup* grp = *it;
-        QLinkedList< NodeGroup *>::iterator it_right = it;
-        it_right++;
-        bool no_merge = true; 
+        edges.push_back( e);
+        if ( e->chain() >= 0)
+            has_long = true;
+    }
+    if ( has_long && dir == GRAPH_DIR_UP)
+    {
+        qStableSort( edges.begin(), edges.end(), compareLongFirst);
+    }
+}
+
+/**
+ * Add peer connected with i-th node by given edge. For a long edge
+ * the peer is the nearest entry of edge's chain
+ */
+void Level::addEdgePeer( GraphDir dir, int i, AuxEdge *e, GraphDir edge_dir)
+{
+    AuxNode *n = placed_nodes[ i];
+    AuxNode *peer = e->node( edge_dir);
+
+    if ( e->chain() >= 0)
+    {
+        LAYOUT_ASSERTD( isNotNullP( peer_level[ dir]), "Chain entry should belong to adjacent level");
+        EdgeChains *chains = peer_level[ dir]->chain_p;
+        int index = chains->placementIndex( chains->entryNear( e->chain(), n));
+        
+        if ( index >= 0)
+            peer_vec[ dir].push_back( index);
+        return;
+    }
+    if ( !peer->isForPlacement())
+        return;
+    if ( areEqP( peer, n))
+    {
+        peer_vec[ dir].push_back( -i - 1);
+    } else
+    {
+        LAYOUT_ASSERTD( areEqP( peer->level(), peer_level[ dir]),
+                        "Peer should belong to adjacent level");
+        peer_vec[ dir].push_back( peer->placementIndex());
+    }
+}
+
+/**
+ * Add peer of i-th chain entry. It is the adjacent entry of the same chain
+ * or the end node of chain's edge
+ */
+void Level::addEntryPeer( GraphDir dir, int i)
+{
+    int entry = placed_entries[ i];
+    int chain = chain_p->chain( entry);
 
-        /** Group to the left */
-        if ( it != groups.begin())
+    if ( dir == GRAPH_DIR_DOWN && entry != chain_p->firstEntry( chain))
+    {
+        peer_vec[ dir].push_back( chain_p->placementIndex( entry - 1));
+    } else if ( dir == GRAPH_DIR_UP && entry != chain_p->lastEntry( chain))
+    {
+        peer_vec[ dir].push_back( chain_p->placementIndex( entry + 1));
+    } else
+    {
+        AuxNode *peer = ( dir == GRAPH_DIR_DOWN) ? chain_p->top( chain) : chain_p->bottom( chain);
+        
+        if ( peer->isForPlacement())
         {
-            QLinkedList< NodeGroup *>::iterator it_left = it;
-            it_left--;
-            NodeGroup* left_grp = *it_left;
-            if ( grp->interleaves( left_grp))
-            {
-                groups.erase( it_left);
-                grp->merge( left_grp);
-                no_merge = false;
-                delete ( left_grp);
-            }
+            LAYOUT_ASSERTD( areEqP( peer->level(), peer_level[ dir]),
+                            "Peer should belong to adjacent level");
+            peer_vec[ dir].push_back( peer->placementIndex());
         }
-        /** Group to the right */
-        if ( it_right != groups.end())
+    }
+}
+
+/**
+ * Build peers of nodes for both pass directions.
+ * On descending pass barycenter is computed with respect to predecessors,
+ * on ascending - to successors. Inverted edges are taken in reverse direction.
+ * Peers are listed in the order of edges that edge controls would have
+ * so that sums are computed in the same order
+ */
+void Level::initPeers( Level *prev, // Level above
+                       Level *next) // Level below
+{
+    QVector< AuxEdge *> edges;
+
+    peer_level[ GRAPH_DIR_DOWN] = prev;
+    peer_level[ GRAPH_DIR_UP] = next;
+
+    for ( int d = 0; d < GRAPH_DIRS_NUM; d++)
+    {
+        GraphDir dir = ( GraphDir)d;
+        GraphDir rdir = RevDir( dir);
+
+        peer_begin[ dir].resize( placed_nodes.size() + 1);
+        peer_vec[ dir].clear();
+
+        for ( int i = 0; i < placed_nodes.size(); i++)
         {
-            NodeGroup* right_grp = *it_right;
-            if ( grp->interleaves( right_grp))
+            AuxNode *n = placed_nodes[ i];
+
+            peer_begin[ dir][ i] = peer_vec[ dir].size();
+            if ( isNullP( n))
+            {
+                addEntryPeer( dir, i);
+                continue;
+            }
+            collectEdges( n, rdir, edges);
+            foreach ( AuxEdge *e, edges)
             {
-                groups.erase( it_right);
-                grp->merge( right_grp);
-                no_merge = false;
-                delete ( right_grp);
-            }    
+                if ( !e->isInverted())
+                    addEdgePeer( dir, i, e, rdir);
+            }
+            collectEdges( n, dir, edges);
+            foreach ( AuxEdge *e, edges)
+            {
+                if ( e->isInverted())
+                    addEdgePeer( dir, i, e, dir);
+            }
         }
-        /** Proceed to the next group */
-        if ( no_merge)
-            it++;
-        /** End loop if we have processed all groups and merged everything we could */
-        if ( it == groups.end())
-            break;
+        peer_begin[ dir][ placed_nodes.size()] = peer_vec[ dir].size();
     }
+}
 
-    if ( commit_placement)
+/**
+ * Replace chain entries with edge control nodes created for them.
+ * Controls already have orders of entries so node list is sorted again
+ */
+void Level::materializeEntries( const QVector< AuxNode *> &controls)
+{
+    if ( entry_list.isEmpty())
+        return;
+
+    foreach ( int entry, entry_list)
     {
-        /** Assign coordinates to nodes */
-        for ( it = groups.begin(); it != groups.end(); it++)
+        add( controls[ entry]);
+    }
+    qStableSort( node_list.begin(), node_list.end(), compareOrders);
+    entry_list.clear();
+}
+
+/**
+ * Recompute attachment points of nodes
+ */
+void Level::updateCenters()
+{
+    int num = placed_nodes.size();
+    qreal *centers = center_vec.data();
+    const qreal *xs = x_vec.constData();
+    const qreal *offsets = offset_vec.constData();
+
+    for ( int i = 0; i < num; i++)
+    {
+        centers[ i] = xs[ i] + offsets[ i];
+    }
+}
+
+/**
+ * Compute barycenters of nodes using barycenter heuristic.
+ * First loop gathers attachment points of peers from adjacent level and sums them,
+ * second one turns sums into barycenters. Peers of a self edge are taken from this level
+ */
+void Level::computeBarycenters( GraphDir dir, bool first_pass)
+{
+    int num = placed_nodes.size();
+    const int *begin = peer_begin[ dir].constData();
+    const int *peers = peer_vec[ dir].constData();
+    const qreal *own_centers = center_vec.constData();
+    const qreal *peer_centers = isNotNullP( peer_level[ dir])
+                                ? peer_level[ dir]->center_vec.constData()
+                                : NULL;
+    const qreal *xs = x_vec.constData();
+    const qreal *widths = width_vec.constData();
+    qreal *bcs = bc_vec.data();
+    unsigned int *weights = weight_vec.data();
+
+    /* Gather and reduce */
+    for ( int i = 0; i < num; i++)
+    {
+        double sum = 0;
+        for ( int k = begin[ i]; k < begin[ i + 1]; k++)
         {
-            NodeGroup *grp = *it;
-            grp->placeNodesFinal( dir);
-            delete grp;
+            int peer = peers[ k];
+            sum += ( peer >= 0) ? peer_centers[ peer] : own_centers[ -peer - 1];
         }
-    } else 
+        bcs[ i] = sum;
+        weights[ i] = begin[ i + 1] - begin[ i];
+    }
+
+    /* Barycenters */
+    for ( int i = 0; i < num; i++)
     {
-        /** Assign coordinates to nodes */
-        for ( it = groups.begin(); it != groups.end(); it++)
+        double center = 0;
+        if ( weights[ i] > 0)
+        {
+            center = bcs[ i] / weights[ i];
+        } else 
         {
-            NodeGroup *grp = *it;
-            grp->placeNodes();
-            delete grp;
+            weights[ i] = 1;
+            if ( !first_pass)
+                center = xs[ i] + widths[ i] / 2;
         }
+        if ( type_vec[ i] == AUX_EDGE_LABEL)
+            center += ( widths[ i] / 2);
+        if ( stable_vec[ i])
+            center = xs[ i] + widths[ i] / 2;
+        bcs[ i] = center;
+    }
+}
+
+/**
+ * Arranges nodes using group merge algorithm.
+ * Group is a set of nodes which interleave if we apply barycentric heuristic directly.
+ * These nodes are placed within group borders. If two groups interleave they are merged.
+ * Arrangement is performed iteratively starting with groups that have one node each.
+ * Groups are kept in given buffers that can be reused for other levels and passes
+ */
+void Level::arrangeNodes( GraphDir dir, bool commit_placement, bool first_pass, NodeGroups &groups)
+{
+    computeBarycenters( dir, first_pass);
+    groups.init( this);
+    groups.merge();
+    groups.placeNodes( commit_placement);
+    updateCenters();
+}
+
+/**
+ * Cheap placement: nodes and chain entries are put left to right in their order
+ * without looking at adjacent levels. Anytime layout shows it before placement passes are done
+ */
+void Level::placeByOrder()
+{
+    AuxNodeType prev_type = AUX_NODE_TYPES_NUM;
+    qreal level_width = 0;
+
+    initPlacement();
+    for ( int i = 0; i < placedCount(); i++)
+    {
+        level_width += nodeSpacing( prev_type, type( i)) + width( i);
+        prev_type = type( i);
+    }
+    
+    qreal curr_left = -level_width / 2;
+    prev_type = AUX_NODE_TYPES_NUM;
+    for ( int i = 0; i < placedCount(); i++)
+    {
+        curr_left += nodeSpacing( prev_type, type( i));
+        /** Stable nodes keep their coordinates */
+        if ( !stable_vec[ i])
+            setX( i, curr_left);
+        curr_left += width( i);
+        prev_type = type( i);
+
+        AuxNode *node = placedNode( i);
+        if ( isNotNullP( node))
+            node->setY( y() - node->height() / 2);
+    }
+}
+
+/**
+ * Fill placement arrays of levels and link them with each other
+ */
+void initLevelsPlacement( QVector< Level*> &levels)
+{
+    for ( int i = 0; i < levels.size(); i++)
+    {
+        levels[ i]->initPlacement();
+    }
+    for ( int i = 0; i < levels.size(); i++)
+    {
+        levels[ i]->initPeers( ( i > 0) ? levels[ i - 1] : NULL,
+                               ( i + 1 < levels.size()) ? levels[ i + 1] : NULL);
     }
 }
 
@@ -354,18 +732,42 @@ AuxGraph::findEnterNodes()
 }
 
 /**
- * Perform edge classification
+ * Perform edge classification. Edges that should be inverted
+ * are chosen by the current cycle breaking algorithm
  */
 void AuxGraph::classifyEdges()
 {
-    Marker m = newMarker(); // Marker for visiting nodes
-    Marker doneMarker = newMarker(); // Marker for nodes that are finished
     AuxEdge* e;
 
     foreachEdge ( e, this)
     {
         e->setUnknown();   
     }
+    if ( cycle_breaking == CYCLE_BREAKING_GREEDY)
+    {
+        classifyEdgesGreedy();
+    } else
+    {
+        classifyEdgesDFS();
+    }
+
+    /** Self edges are not taken into account by ranking */
+    inverted_num = 0;
+    foreachEdge ( e, this)
+    {
+        if ( e->isInverted() && e->pred() != e->succ())
+            inverted_num++;
+    }
+}
+
+/**
+ * Mark back edges of depth-first search as inverted.
+ * Edges that lead to edge labels are inverted along with the edge that leaves the label
+ */
+void AuxGraph::classifyEdgesDFS()
+{
+    Marker m = newMarker(); // Marker for visiting nodes
+    Marker doneMarker = newMarker(); // Marker for nodes that are finished
 
     /* Fill the traverse stack with enter nodes */
     QStack< SimpleDfsStepInfo *> stack = findEnterNodes();
@@ -414,48 +816,14 @@ void AuxGraph::classifyEdges()
 }
 
 /**
- * Ranking of nodes. Level distribution of nodes. Marks tree edges.
+ * Assign ranks walking the nodes with a stack. A node is ranked when all its
+ * predecessors are, so its rank is the length of the longest path from top
  */
-Numeration AuxGraph::rankNodes()
+void AuxGraph::rankNodesSequential( Numeration own, QVector< int> &pred_nums)
 {
-    QVector< int> pred_nums( nodeCount());
     QStack< AuxNode *> stack; // Node stack
-    
-    invalidateRanking();
-
-    Numeration own = newNum();
-    GraphNum i = 0;
-    max_rank = 0;
-    /**
-     *  Set numbers to nodes and count predecessors of each node.
-     *  predecessors include inverted edges 
-     */
     AuxNode *n;
-    foreachNode( n, this)
-    {
-        int pred_num = 0;
-        n->setNumber( own, i);
-        AuxEdge* e; 
-        foreachPred( e, n)
-        {
-            if ( e->pred() == e->succ())
-                continue;
 
-            if ( !e->isInverted())
-                pred_num++;
-        }
-        foreachSucc( e, n)
-        {
-            if ( e->pred() == e->succ())
-                continue;
-
-            if ( e->isInverted())
-                pred_num++;
-        }
-        pred_nums[ i] = pred_num;
-        i++;
-    }
-    /* Fill ranking and ordering numerations by walking the nodes */
     /* Add nodes with no preds to stack */
     foreachNode( n, this)
     {
@@ -541,6 +909,117 @@ Numeration AuxGraph::rankNodes()
             }
         }
     }
+}
+
+/**
+ * Assign ranks level by level. Every node of a frontier has the rank equal to
+ * the frontier's number: it gets there when the last of its predecessors,
+ * the one with the greatest rank, is processed. So ranks are the same as the
+ * sequential walk gives. Frontier is split into chunks processed by thread pool,
+ * each chunk collects nodes it released in its own buffer. Which chunk releases a node
+ * depends on scheduling, so does the order of the next frontier, but ranks don't
+ */
+void AuxGraph::rankNodesParallel( Numeration own, QVector< int> &pred_nums)
+{
+    QVector< QAtomicInt> counters( pred_nums.size());
+    QVector< AuxNode *> frontier;
+    QVector< RankingChunk> chunks;
+    int max_chunks = 4 * QThread::idealThreadCount();
+    AuxNode *n;
+
+    foreachNode( n, this)
+    {
+        GraphNum i = n->number( own);
+        counters[ i] = pred_nums[ i];
+        if ( pred_nums[ i] == 0)
+            frontier.push_back( n);
+    }
+    
+    FrontierRanker ranker( counters.data(), own, ranking);
+    GraphNum rank = 0;
+    while ( !frontier.isEmpty())
+    {
+        int chunk_num = qBound( 1, frontier.size() / RANKING_CHUNK_MIN_SIZE, qMax( 1, max_chunks));
+        int chunk_size = ( frontier.size() + chunk_num - 1) / chunk_num;
+
+        chunks.resize( chunk_num);
+        for ( int i = 0; i < chunk_num; i++)
+        {
+            chunks[ i].begin = i * chunk_size;
+            chunks[ i].end = qMin( frontier.size(), ( i + 1) * chunk_size);
+            chunks[ i].ready.clear();
+        }
+        ranker.frontier = frontier.constData();
+        ranker.rank = rank;
+        if ( chunk_num == 1)
+        {
+            ranker( chunks[ 0]);
+        } else
+        {
+            QtConcurrent::blockingMap( chunks, ranker);
+        }
+        max_rank = rank;
+
+        /** Next frontier in order of chunks */
+        frontier.clear();
+        for ( int i = 0; i < chunk_num; i++)
+        {
+            frontier += chunks[ i].ready;
+        }
+        rank++;
+    }
+}
+
+/**
+ * Ranking of nodes. Level distribution of nodes. Marks tree edges.
+ */
+Numeration AuxGraph::rankNodes()
+{
+    QVector< int> pred_nums( nodeCount());
+    
+    invalidateRanking();
+    deleteComponents();
+
+    Numeration own = newNum();
+    GraphNum i = 0;
+    max_rank = 0;
+    /**
+     *  Set numbers to nodes and count predecessors of each node.
+     *  predecessors include inverted edges 
+     */
+    AuxNode *n;
+    foreachNode( n, this)
+    {
+        int pred_num = 0;
+        n->setNumber( own, i);
+        AuxEdge* e; 
+        foreachPred( e, n)
+        {
+            if ( e->pred() == e->succ())
+                continue;
+
+            if ( !e->isInverted())
+                pred_num++;
+        }
+        foreachSucc( e, n)
+        {
+            if ( e->pred() == e->succ())
+                continue;
+
+            if ( e->isInverted())
+                pred_num++;
+        }
+        pred_nums[ i] = pred_num;
+        i++;
+    }
+    /* Fill ranking numeration by walking the nodes */
+    if ( nodeCount() >= parallel_ranking_min)
+    {
+        rankNodesParallel( own, pred_nums);
+    } else
+    {
+        rankNodesSequential( own, pred_nums);
+    }
     freeNum( own);
 
     /** Fill levels */
@@ -555,13 +1034,19 @@ Numeration AuxGraph::rankNodes()
         } 
         levels[ rank]->add( n);
     }
-    /** Create edge control nodes */
+    /**
+     * Create chains of pseudo nodes for edges that span several ranks.
+     * Edge controls are created from chains when layout is done
+     */
+    chains.clear();
+    chains.setEntryParams( controlWidth(), controlHeight(), isControlForPlacement());
     AuxEdge* e;
     foreachEdge( e, this)
     {
         AuxNode* pred;
         AuxNode* succ;
         
+        e->setChain( -1);
         if ( e->pred() == e->succ())
             continue;
 
@@ -585,11 +1070,68 @@ Numeration AuxGraph::rankNodes()
         {
             succ_rank = pred_rank + 1;
         } 
-        Rank curr_rank = pred_rank + 1;
+        if ( succ_rank > pred_rank + 1)
+        {
+            int chain = chains.addChain( e, succ_rank - pred_rank - 1);
+            for ( int entry = chains.firstEntry( chain);
+                  entry <= chains.lastEntry( chain);
+                  entry++)
+            {
+                levels[ chains.rank( entry)]->addEntry( &chains, entry);
+            }
+        }
+    }
+    validateRanking();
+#ifdef _DEBUG
+    //debugPrint();
+#endif
+    return ranking; 
+}
+
+/**
+ * Delete all edge control nodes, edges are restored by the nodes' destructors
+ */
+void AuxGraph::deleteEdgeControls()
+{
+    for ( AuxNode* n = firstNode();
+          isNotNullP( n);
+          )
+    {
+        AuxNode *next = n->nextNode();
+        if ( n->isEdgeControl())
+        {
+            deleteNode( n);
+        }
+        n = next;
+    }
+}
+
+/**
+ * Create edge control nodes from chains of long edges. Controls are inserted
+ * in the same order ranking used to insert them so that edge lists get the order
+ * that horizontal placement assumed, see collectEdges(). Controls replace entries
+ * in levels and take their orders and coordinates
+ */
+void AuxGraph::createEdgeControls()
+{
+    QVector< AuxNode *> controls( chains.entryCount());
+
+    for ( int chain = 0; chain < chains.count(); chain++)
+    {
+        AuxEdge *e = chains.edge( chain);
         AuxEdge *curr_edge = e;
-        while ( curr_rank != succ_rank)
+        /** Ends of edge change as controls are inserted so the upper one is taken beforehand */
+        AuxNode *top = chains.top( chain);
+        Rank rank = top->rank();
+
+        e->setChain( -1);
+        for ( int entry = chains.firstEntry( chain);
+              entry <= chains.lastEntry( chain);
+              entry++)
         {
             AuxNode *node = curr_edge->insertNode();
+            
+            rank++;
             if ( e->isInverted())
             {
                 curr_edge = node->firstPred();
@@ -599,18 +1141,36 @@ Numeration AuxGraph::rankNodes()
             }
             node->firstSucc()->setType( e->type());
             node->setType( AUX_EDGE_CONTROL);
-            node->setY( pred->modelY() + RANK_SPACING);
-            levels[ curr_rank]->add( node);
-            node->setNumber( ranking, curr_rank);
-            pred = node;
-            curr_rank++;
+            node->setForPlacement( chains.isForPlacement());
+            node->setOrder( chains.order( entry));
+            node->setX( chains.x( entry));
+            node->setNumber( ranking, rank);
+            if ( !node->isForPlacement())
+                node->setY( top->modelY() + ( rank - top->rank()) * RANK_SPACING);
+            controls[ entry] = node;
         }
     }
+    for ( int i = 0; i < levels.size(); i++)
+    {
+        levels[ i]->materializeEntries( controls);
+    }
+    /** Component's levels go last so that controls refer to them like other nodes do */
+    foreach ( LayoutComponent *comp, components)
+    {
+        for ( int i = 0; i < comp->levels().size(); i++)
+        {
+            comp->levels()[ i]->materializeEntries( controls);
+        }
+    }
+    foreach ( AuxNode *node, controls)
+    {
+        if ( node->isForPlacement())
+            node->setY( node->level()->y() - node->height() / 2);
+    }
+    chains.clear();
+    
+    /** Creation of nodes resets ranking, it is still valid though */
     validateRanking();
-#ifdef _DEBUG
-    //debugPrint();
-#endif
-    return ranking; 
 }
 
 /**
@@ -620,39 +1180,63 @@ void AuxGraph::doLayout()
 {
     if ( layout_in_process)
         return;
+    startPhases();
     /**
      * 0. Remove all edge controls
      * FIXME: This is a stub. we should not delete controls,
      *        instead we should reuse them and create new ones only if necessary
      */
-    for ( AuxNode* n = firstNode();
-          isNotNullP( n);
-          )
+    deleteEdgeControls();
+    endPhase( LAYOUT_PHASE_CLEANUP);
+
+    if ( layout_engine == LAYOUT_ENGINE_FORCE)
     {
-        AuxNode *next = n->nextNode();
-        if ( n->isEdgeControl())
-        {
-            deleteNode( n);
-        }
-        n = next;
+        /** Force-directed engine neither ranks nodes nor creates edge controls */
+        ForceLayout force( this, force_multilevel);
+
+        deleteComponents();
+        deleteLevels();
+        inverted_num = 0;
+        progress.reset();
+        force.run();
+        force.apply();
+        endPhase( LAYOUT_PHASE_FORCE);
+        return;
     }
 
     /** 1. Perfrom edge classification */
     classifyEdges();
+    endPhase( LAYOUT_PHASE_CLASSIFY);
     
     /** 2. Rank nodes */
     rankNodes();
+    endPhase( LAYOUT_PHASE_RANK);
 
     /** 3. Adjust levels vertically */
     adjustVerticalLevels();
+    endPhase( LAYOUT_PHASE_LEVELS);
 
     /** 4. Perform edge crossings minimization */
     reduceCrossings();
+    endPhase( LAYOUT_PHASE_CROSSINGS);
 
-    /** 5. Perform horizontal arrangement of nodes */
+    /** 5. Find connected components that can be arranged independently */
+    splitComponents();
+    endPhase( LAYOUT_PHASE_COMPONENTS);
+
+    /** 6. Perform horizontal arrangement of nodes */
+    progress.reset();
+    if ( deterministic)
+    {
+        /** Placement doesn't start from coordinates left by previous layout */
+        placeByOrder();
+    }
     arrangeHorizontally();
+    endPhase( LAYOUT_PHASE_ARRANGE);
+    createEdgeControls();
+    endPhase( LAYOUT_PHASE_CONTROLS);
 
-    /** 6. Move edge controls to enchance the picture readability */
+    /** 7. Move edge controls to enchance the picture readability */
 }
 
 /**
@@ -662,43 +1246,88 @@ void AuxGraph::doLayoutConcurrent()
 {
     if ( layout_in_process)
         return;
+    startPhases();
     
     /**
      * 0. Remove all edge controls
      * FIXME: This is a stub. we should not delete controls,
      *        instead we should reuse them and create new ones only if necessary
      */
-    for ( AuxNode* n = firstNode();
-          isNotNullP( n);
-          )
+    deleteEdgeControls();
+    endPhase( LAYOUT_PHASE_CLEANUP);
+
+    if ( layout_engine == LAYOUT_ENGINE_FORCE)
     {
-        AuxNode *next = n->nextNode();
-        if ( n->isEdgeControl())
-        {
-            deleteNode( n);
-        }
-        n = next;
+        /** Graph is copied to arrays here, background worker touches only them */
+        force_layout = new ForceLayout( this, force_multilevel);
+        deleteComponents();
+        deleteLevels();
+        inverted_num = 0;
+        layout_in_process = true;
+        deadline_passed = false;
+        progress.reset();
+        progress_total = force_layout->stepsNum();
+        watcher->setFuture( QtConcurrent::run( this, &AuxGraph::forceInBackground));
+        progress_timer->start();
+        return;
     }
 
     /** 1. Perfrom edge classification */
     classifyEdges();
+    endPhase( LAYOUT_PHASE_CLASSIFY);
     
     /** 2. Rank nodes */
     rankNodes();
+    endPhase( LAYOUT_PHASE_RANK);
 
     /** 3. Adjust levels vertically */
     adjustVerticalLevels();
+    endPhase( LAYOUT_PHASE_LEVELS);
 
     /** 4. Perform edge crossings minimization */
     reduceCrossings();
+    endPhase( LAYOUT_PHASE_CROSSINGS);
 
-    /** 5. Perform horizontal arrangement of nodes */
+    /** 5. Find connected components that can be arranged independently */
+    splitComponents();
+    endPhase( LAYOUT_PHASE_COMPONENTS);
+
+    /** 6. Perform horizontal arrangement of nodes in background */
     layout_in_process = true;
-    cur_pass = 0;
-    cur_level = 0;
-    layoutNextStep();
+    deadline_passed = false;
+    progress.reset();
+    if ( components.size() > 1)
+    {
+        progress_total = 0;
+        foreach ( LayoutComponent *comp, components)
+        {
+            progress_total += LAYOUT_PASSES_NUM * comp->levels().size();
+        }
+    } else
+    {
+        progress_total = LAYOUT_PASSES_NUM * levels.size();
+    }
+    if ( layout_deadline > 0 && !deterministic)
+    {
+        /**
+         * Anytime layout: cheap placement is ready at once and shown if
+         * the deadline passes, each placement pass is a separate task that refines it
+         */
+        placeByOrder();
+        arrange_pass = 0;
+        layoutRefined();
+        deadline_timer->start( layout_deadline);
+        watcher->setFuture( QtConcurrent::run( this, &AuxGraph::arrangePassInBackground));
+    } else
+    {
+        /** Whole arrangement is done by one task, it starts from the same placement as doLayout does */
+        if ( deterministic)
+            placeByOrder();
+        watcher->setFuture( QtConcurrent::run( this, &AuxGraph::arrangeInBackground));
+    }
+    progress_timer->start();
 
-    /** 6. Move edge controls to enchance the picture readability */
+    /** 7. Move edge controls to enchance the picture readability */
 }
 
 #define SIMPLE_DFS
@@ -759,7 +1388,16 @@ struct DfsStepInfo
     AuxNode *node; /** Node in consideration */
     AuxEdge *edge; /** Next edge */
     bool inverted; /** If we have already processed preds and */
+    int chain; /** Chain of long edge, -1 for node step */
 
+    /** Constructor for chain of long edge that leads to given node */
+    DfsStepInfo( int c, AuxNode *n)
+    {
+        node = n;
+        edge = NULL;
+        inverted = false;
+        chain = c;
+    }
 #ifdef SIMPLE_DFS
     /* Constructor */
     DfsStepInfo( AuxNode *n)
@@ -768,6 +1406,7 @@ struct DfsStepInfo
         node = n;
         edge = n->firstPred();
         inverted = false;
+        chain = -1;
     }
     /** Next edge of this node */
     void shiftEdge()
@@ -789,6 +1428,7 @@ struct DfsStepInfo
         node = n;
         edge = n->firstPred();
         inverted = false;
+        chain = -1;
         if ( isNullP( edge))
         {
             inverted = true;
@@ -873,7 +1513,9 @@ struct DfsStepInfo
 };
 
 /**
- * Assign order to nodes by numbering in a reverse DFS traversal
+ * Assign order to nodes by numbering in a reverse DFS traversal.
+ * Entries of a long edge's chain are numbered right after the node the edge leads to,
+ * starting from the entry next to that node
  */
 void AuxGraph::orderNodesByDFS()
 {
@@ -882,7 +1524,7 @@ void AuxGraph::orderNodesByDFS()
 
     Marker m = newMarker(); // Marker for visiting nodes
     QStack< ::DfsStepInfo *> stack;
-    GraphNum num = nodeCount();
+    GraphNum num = nodeCount() + chains.entryCount();
     
     /* Fill stack with nodes that have no predecessors */
     for ( AuxNode *n = firstNode();
@@ -901,14 +1543,35 @@ void AuxGraph::orderNodesByDFS()
                 
                 if ( isNotNullP( info->edge)) // Add successor to stack
                 {
+                    AuxEdge* edge = info->edge;
                     AuxNode* pred_node = info->nodeInDepth();
                     info->shiftEdge();
                     
+                    if ( edge->chain() >= 0)
+                    {
+                        stack.push( new DfsStepInfo( edge->chain(), pred_node));
+                    }
                     if ( pred_node->mark( m))
                     {
                         stack.push( new DfsStepInfo( pred_node));
                         //pred_node->setOrder( num++);
                     }
+                } else if ( info->chain >= 0) // We're done with the node chain leads to
+                {
+                    int first = chains.firstEntry( info->chain);
+                    int last = chains.lastEntry( info->chain);
+                    
+                    if ( areEqP( info->node, chains.top( info->chain)))
+                    {
+                        for ( int entry = first; entry <= last; entry++)
+                            chains.setOrder( entry, num--);
+                    } else
+                    {
+                        for ( int entry = last; entry >= first; entry--)
+                            chains.setOrder( entry, num--);
+                    }
+                    delete info;
+                    stack.pop();
                 } else // We're done with this node
                 {
                     info->node->setOrder( num--);
@@ -922,12 +1585,10 @@ void AuxGraph::orderNodesByDFS()
 }
 
 /**
- * Arrange ranks vertically
+ * Arrange given levels vertically
  */
-void AuxGraph::adjustVerticalLevels()
+void adjustLevelsVertically( QVector< Level*> &levels)
 {
-    if ( layout_in_process)
-        return;
     qreal y = 0;
     qreal prev_height = 0;
     for ( int i = 0; i < levels.size(); i++)
@@ -939,6 +1600,16 @@ void AuxGraph::adjustVerticalLevels()
     }
 }
 
+/**
+ * Arrange ranks vertically
+ */
+void AuxGraph::adjustVerticalLevels()
+{
+    if ( layout_in_process)
+        return;
+    adjustLevelsVertically( levels);
+}
+
 /**
  * Try to reduce number of edge crossings between levels
  */
@@ -957,46 +1628,204 @@ void AuxGraph::reduceCrossings()
 }
 
 /**
- * Assign X coordinates to the nodes
+ * Split graph into weakly connected components.
+ * Each component gets its own levels filled in the order nodes have in graph's levels.
+ * Nothing is created for a connected graph. Nothing is created either when graph has
+ * stable nodes: packing moves components as a whole, so stable nodes are kept only by
+ * placement of graph's own levels
  */
-void AuxGraph::arrangeHorizontallyWOStable()
+void AuxGraph::splitComponents()
 {
-    if ( layout_in_process)
-        return;
-    /* Descending pass */
-    for ( int i = 0; i < levels.size(); i++)
+    deleteComponents();
+
+    AuxNode *n;
+
+    foreachNode( n, this)
     {
-        levels[ i]->arrangeNodes( GRAPH_DIR_DOWN, false, true);
+        if ( n->isStable())
+            return;
     }
-    
-    /* Ascending pass */
-    for ( int i = levels.size() - 1; i >= 0; i--)
+
+    Numeration comp_num = newNum();
+    QStack< AuxNode *> stack;
+    GraphNum comp_count = 0;
+
+    foreachNode( n, this)
+    {
+        if ( n->isNumbered( comp_num))
+            continue;
+
+        n->setNumber( comp_num, comp_count);
+        stack.push( n);
+        while ( !stack.isEmpty())
+        {
+            AuxNode *curr = stack.pop();
+            AuxEdge *e;
+
+            foreachSucc( e, curr)
+            {
+                AuxNode *succ = e->succ();
+                if ( !succ->isNumbered( comp_num))
+                {
+                    succ->setNumber( comp_num, comp_count);
+                    stack.push( succ);
+                }
+            }
+            foreachPred( e, curr)
+            {
+                AuxNode *pred = e->pred();
+                if ( !pred->isNumbered( comp_num))
+                {
+                    pred->setNumber( comp_num, comp_count);
+                    stack.push( pred);
+                }
+            }
+        }
+        comp_count++;
+    }
+    if ( comp_count > 1)
     {
-        levels[ i]->arrangeNodes( GRAPH_DIR_UP, false, false);
+        components.resize( comp_count);
+        for ( GraphNum i = 0; i < comp_count; i++)
+        {
+            components[ i] = new LayoutComponent();
+        }
+        for ( int i = 0; i < levels.size(); i++)
+        {
+            foreach ( AuxNode *node, levels[ i]->nodes())
+            {
+                components[ node->number( comp_num)]->add( node);
+            }
+            foreach ( int entry, levels[ i]->entries())
+            {
+                AuxNode *pred = chains.edge( chains.chain( entry))->pred();
+                components[ pred->number( comp_num)]->addEntry( &chains, entry);
+            }
+        }
     }
-    /* Final pass */
+    freeNum( comp_num);
+}
+
+/**
+ * Arrange components in thread pool and pack them on the plane
+ */
+void AuxGraph::arrangeComponents( LayoutProgress *progress)
+{
+    QtConcurrent::blockingMap( components, ComponentArranger( progress));
+    packComponents( components);
+}
+
+/**
+ * Put nodes of each level in their order, components are packed afterwards
+ */
+void AuxGraph::placeByOrder()
+{
+    if ( components.size() > 1)
+    {
+        foreach ( LayoutComponent *comp, components)
+        {
+            comp->placeByOrder();
+        }
+        packComponents( components);
+    } else
+    {
+        for ( int i = 0; i < levels.size(); i++)
+        {
+            levels[ i]->placeByOrder();
+        }
+    }
+}
+
+/**
+ * Check if arrangement should stop. Nodes of cancelled arrangement
+ * still get vertical coordinates so that the picture remains readable
+ */
+static bool isArrangementCancelled( QVector< Level*> &levels, LayoutProgress *progress)
+{
+    if ( isNullP( progress) || !progress->isCancelled())
+        return false;
+
     for ( int i = 0; i < levels.size(); i++)
     {
-        levels[ i]->arrangeNodes( GRAPH_DIR_DOWN, true, false);
+        foreach ( AuxNode *node, levels[ i]->nodes())
+        {
+            if ( node->isForPlacement())
+                node->setY( levels[ i]->y() - node->height() / 2);
+        }
+    }
+    return true;
+}
+
+/**
+ * Perform placement pass over given levels. Pass 0 is the descending one,
+ * pass 1 is the ascending one and the final descending pass commits placement
+ */
+bool arrangeLevelsPass( QVector< Level*> &levels, int pass, NodeGroups &groups, LayoutProgress *progress)
+{
+    GraphDir dir = ( pass == 1) ? GRAPH_DIR_UP : GRAPH_DIR_DOWN;
+    bool commit_placement = ( pass == LAYOUT_PASSES_NUM - 1);
+    bool first_pass = ( pass == 0);
+    int num = levels.size();
+
+    for ( int k = 0; k < num; k++)
+    {
+        int i = ( dir == GRAPH_DIR_UP) ? num - 1 - k : k;
+
+        if ( isArrangementCancelled( levels, progress))
+            return false;
+        levels[ i]->arrangeNodes( dir, commit_placement, first_pass, groups);
+        if ( isNotNullP( progress))
+            progress->step();
+    }
+    return true;
+}
+
+/**
+ * Assign X coordinates to the nodes of given levels
+ */
+void arrangeLevelsHorizontally( QVector< Level*> &levels, LayoutProgress *progress)
+{
+    NodeGroups groups;
+
+    initLevelsPlacement( levels);
+
+    for ( int pass = 0; pass < LAYOUT_PASSES_NUM; pass++)
+    {
+        if ( !arrangeLevelsPass( levels, pass, groups, progress))
+            return;
     }
 }
 
+/**
+ * Assign X coordinates to the nodes
+ */
+void AuxGraph::arrangeHorizontallyWOStable()
+{
+    if ( layout_in_process)
+        return;
+    arrangeLevelsHorizontally( levels);
+}
+
 /**
  * Arrange with respect to stable nodes
  */
 void
 AuxGraph::arrangeHorizontallyWithStable( Rank min, Rank max)
 {
+    NodeGroups groups;
+
+    initLevelsPlacement( levels);
+
     /* Descending pass */
     for ( int i = min; i < levels.size(); i++)
     {
-        levels[ i]->arrangeNodes( GRAPH_DIR_DOWN, true, true);
+        levels[ i]->arrangeNodes( GRAPH_DIR_DOWN, true, true, groups);
     }
     
     /* Ascending pass */
     for ( int i = max; i >= 0; i--)
     {
-        levels[ i]->arrangeNodes( GRAPH_DIR_UP, true, true);
+        levels[ i]->arrangeNodes( GRAPH_DIR_UP, true, true, groups);
     }
     /* Final pass */
     for ( int i = min; i < levels.size(); i++)
@@ -1016,6 +1845,12 @@ AuxGraph::arrangeHorizontally()
     Rank min_stable_rank = this->nodeCount();
     Rank max_stable_rank = 0;
     
+    /** Components are independent, arrange them in parallel. Graph with stable nodes is not split */
+    if ( components.size() > 1)
+    {
+        arrangeComponents();
+        return;
+    }
     foreachNode( n, this)
     {
         if ( n->isStable())
@@ -1042,58 +1877,130 @@ void AuxGraph::layoutPostProcess()
 {
 
 }
+
+/** Empty implementation */
+void AuxGraph::layoutRefined()
+{
+
+}
+
+/** Empty implementation */
+void AuxGraph::layoutDeadlinePassed()
+{
+
+}
+
+/**
+ * Horizontal placement in background thread.
+ * Whole phase is done by one task, GUI learns about progress by polling the counter
+ */
+void AuxGraph::arrangeInBackground()
+{
+    if ( components.size() > 1)
+    {
+        arrangeComponents( &progress);
+    } else
+    {
+        arrangeLevelsHorizontally( levels, &progress);
+    }
+}
+
+/**
+ * One pass of horizontal placement in background thread.
+ * Placement of the previous pass is the starting one
+ */
+void AuxGraph::arrangePassInBackground()
+{
+    if ( components.size() > 1)
+    {
+        QtConcurrent::blockingMap( components, ComponentPassArranger( arrange_pass, &progress));
+        packComponents( components);
+    } else
+    {
+        NodeGroups groups;
+
+        if ( arrange_pass == 0)
+            initLevelsPlacement( levels);
+        arrangeLevelsPass( levels, arrange_pass, groups, &progress);
+    }
+}
+
+/**
+ * Force-directed placement in background thread, results are applied by finishLayout()
+ */
+void AuxGraph::forceInBackground()
+{
+    force_layout->run( &progress);
+}
+
 /**
- * Next step in concurrent processing of layout
+ * Finish layout started by doLayoutConcurrent. In anytime layout
+ * the intermediate placement is published and the next pass is started instead
  */
-void AuxGraph::layoutNextStep()
+void AuxGraph::finishLayout()
 {
-    if ( cur_pass)
+    if ( isNullP( force_layout)
+         && layout_deadline > 0
+         && !deterministic
+         && arrange_pass + 1 < LAYOUT_PASSES_NUM
+         && !progress.isCancelled())
     {
-        int progress = 100 * ( (cur_pass - 1) * levels.size() + cur_level) / ( 3 * levels.size());
-        emit progressChange( progress);
+        arrange_pass++;
+        layoutRefined();
+        watcher->setFuture( QtConcurrent::run( this, &AuxGraph::arrangePassInBackground));
+        return;
     }
-    switch ( cur_pass)
+    deadline_timer->stop();
+    progress_timer->stop();
+    emit progressChange( 100);
+    if ( isNotNullP( force_layout))
     {
-        case 0:/* prepare data */
-            cur_level = 0;
-            cur_pass++;
-        case 1:/* Descending pass */
-            if ( cur_level < levels.size())
-            {
-                watcher->setFuture( QtConcurrent::run( arrangeLevel, levels[ cur_level], GRAPH_DIR_DOWN, false, true));
-                cur_level++;
-                break;
-            } else
-            {
-                cur_pass++;
-                cur_level = 0;
-            }
-        case 2:/* Ascending pass */
-            if ( cur_level < levels.size())
-            {
-                watcher->setFuture( QtConcurrent::run( arrangeLevel, levels[ cur_level], GRAPH_DIR_UP, false, false));
-                cur_level++;
-                break;
-            } else
-            {
-                cur_level = 0;
-                cur_pass++;
-            }
-        case 3:
-            if ( cur_level < levels.size())
-            {
-                watcher->setFuture( QtConcurrent::run( arrangeLevel, levels[ cur_level], GRAPH_DIR_DOWN, true, false));
-                cur_level++;
-                break;
-            } else
-            {
-                cur_level = 0;
-                cur_pass++;
-            }
-        default:
-            layoutPostProcess();
-            emit layoutDone();
-            layout_in_process = false;
-            break;
+        force_layout->apply();
+        delete force_layout;
+        force_layout = NULL;
+        endPhase( LAYOUT_PHASE_FORCE);
+    } else
+    {
+        /** Arrangement time includes waiting for the event loop to learn that worker is done */
+        endPhase( LAYOUT_PHASE_ARRANGE);
+        createEdgeControls();
+        endPhase( LAYOUT_PHASE_CONTROLS);
+    }
+    layoutPostProcess();
+    emit layoutDone();
+    layout_in_process = false;
+}
+
+/**
+ * Report progress of background layout
+ */
+void AuxGraph::reportProgress()
+{
+    if ( progress_total > 0)
+    {
+        emit progressChange( 100 * progress.stepsDone() / progress_total);
+    }
+}
+
+/**
+ * Show unfinished layout, worker goes on refining it
+ */
+void AuxGraph::deadlineTimeout()
+{
+    if ( layout_in_process)
+    {
+        deadline_passed = true;
+        layoutDeadlinePassed();
+    }
+}
+
+/**
+ * Request cancellation of background layout. Worker stops before next level
+ */
+void AuxGraph::cancelLayout()
+{
+    if ( layout_in_process)
+    {
+        progress.cancel();
     }
 }
\ No newline at end of file
@@ -21,10 +21,24 @@
  * @page layout Graph layout
  * Drawing graph on a 2D plane is done via Sugiyama-like algorithm. 
  * Drawing is done in two steps:
- * - Ranking, wich defines vertical position of every node and inserts
- *   pseudo nodes on edges that span across multiple levels.
+ * - Ranking, wich defines vertical position of every node and gives
+ *   edges that span across multiple levels a chain of pseudo nodes ( see EdgeChains).
  * - Horizontal placement, wich uses barycenter heuristic to position a node close
  *   to the nodes connected with it on other levels
+ * Chains are turned into edge control nodes when placement is done.
+ * Layout running in background can show nodes placed just in their order when it is not
+ * done by a deadline and then refine the picture pass by pass, see AuxGraph::setLayoutDeadline().
+ *
+ * Graphs without natural hierarchy can be drawn by force-directed engine instead,
+ * see ForceLayout and AuxGraph::setLayoutEngine().
+ *
+ * Parallel parts of layout give the same coordinates on any number of threads: tasks write
+ * disjoint data, sums are taken in fixed order and sorting ties are broken by order or id.
+ * Regression runs should also turn on AuxGraph::setDeterministic() so that coordinates
+ * don't depend on previous layout and on timing.
+ *
+ * Quality of layout ( crossings, edge lengths, area) and time of its phases are measured
+ * by LayoutMetrics.
  */
 #ifndef LAYOUT_IFACE_H
 #define LAYOUT_IFACE_H
@@ -33,6 +47,11 @@ class AuxNode;
 class AuxEdge;
 class AuxGraph;
 class Level;
+class NodeGroups;
+class EdgeChains;
+class LayoutComponent;
+class ForceLayout;
+struct LayoutMetrics;
 
 #include <QtGui>
 #include <QList>
@@ -49,7 +68,100 @@ const qreal EDGE_CONTROL_WIDTH = 5;
 const qreal EDGE_CONTROL_HEIGHT = 5;
 /** Vertical spacing between ranks */
 const qreal RANK_SPACING = 40;
+/** Spacing between packed connected components */
+const qreal COMPONENT_SPACING = 60;
+
+/** Number of horizontal placement passes */
+const int LAYOUT_PASSES_NUM = 3;
+
+/** Interval of layout progress polling in milliseconds */
+const int LAYOUT_PROGRESS_INTERVAL = 100;
+/** Default time in milliseconds after which GUI shows unfinished layout */
+const int LAYOUT_DEADLINE = 300;
+
+/** Default minimal number of nodes for which ranking runs in parallel */
+const int PARALLEL_RANKING_MIN_NODES = 20000;
+/** Minimal number of frontier nodes for one task of parallel ranking */
+const int RANKING_CHUNK_MIN_SIZE = 256;
+
+/** Number of iterations of force-directed layout */
+const int FORCE_ITERATIONS_NUM = 300;
+/** Number of iterations that refine each finer level in multilevel force-directed layout */
+const int FORCE_REFINE_ITERATIONS_NUM = 50;
+/** Natural length of edge in force-directed layout, average node size is added to it */
+const qreal FORCE_EDGE_LENGTH = 40;
+/** Strength of repulsion relative to springs, nodes repel with FORCE_REPULSION * k^2 / d for edge length k */
+const qreal FORCE_REPULSION = 0.2;
+/** Barnes-Hut opening criterion, cell is approximated when its size is less than theta times distance */
+const qreal FORCE_THETA = 0.7;
+/** Pull of nodes to the center of picture that keeps disconnected parts together */
+const qreal FORCE_GRAVITY = 0.1;
+/** Distance under which nodes are considered coincident */
+const qreal FORCE_MIN_DISTANCE = 0.01;
+/** Maximal depth of Barnes-Hut quadtree, coincident nodes share a leaf at this depth */
+const int FORCE_TREE_MAX_DEPTH = 24;
+/** Multilevel force-directed layout doesn't coarsen levels with fewer nodes */
+const int FORCE_COARSEN_MIN_NODES = 100;
+/** Coarsening stops when a level keeps more than this part of nodes of the finer one */
+const qreal FORCE_COARSEN_RATIO = 0.8;
+/** Minimal number of nodes for which forces are accumulated in parallel */
+const int FORCE_PARALLEL_MIN_NODES = 2000;
+/** Number of nodes in one task of parallel force accumulation */
+const int FORCE_CHUNK_SIZE = 256;
+
+/**
+ * Layout algorithms
+ */
+enum LayoutEngine
+{
+    /** Layered placement of Sugiyama type */
+    LAYOUT_ENGINE_LAYERED,
+    /** Force-directed placement */
+    LAYOUT_ENGINE_FORCE,
+    /** Number of engines */
+    LAYOUT_ENGINE_NUM
+};
+
+
+/**
+ * Algorithms that choose edges to invert so that graph becomes acyclic
+ */
+enum CycleBreaking
+{
+    /** Back edges of depth-first search */
+    CYCLE_BREAKING_DFS,
+    /** Greedy heuristic of Eades, Lin and Smyth */
+    CYCLE_BREAKING_GREEDY,
+    /** Number of algorithms */
+    CYCLE_BREAKING_NUM
+};
 
+/**
+ * Phases of layout, their time is measured for LayoutMetrics
+ */
+enum LayoutPhase
+{
+    /** Removal of edge controls left by previous layout */
+    LAYOUT_PHASE_CLEANUP,
+    /** Cycle breaking and edge classification */
+    LAYOUT_PHASE_CLASSIFY,
+    /** Ranking */
+    LAYOUT_PHASE_RANK,
+    /** Vertical placement of levels */
+    LAYOUT_PHASE_LEVELS,
+    /** Edge crossings reduction */
+    LAYOUT_PHASE_CROSSINGS,
+    /** Splitting graph into connected components */
+    LAYOUT_PHASE_COMPONENTS,
+    /** Horizontal placement */
+    LAYOUT_PHASE_ARRANGE,
+    /** Creation of edge controls */
+    LAYOUT_PHASE_CONTROLS,
+    /** Force-directed placement */
+    LAYOUT_PHASE_FORCE,
+    /** Number of phases */
+    LAYOUT_PHASE_NUM
+};
 
 /** Rank type and its undefined constant */
 typedef unsigned int Rank;
@@ -66,7 +178,11 @@ const Rank RANK_UNDEF = (Rank) (-1);
 #include "../Graph/graph_iface.h"
 #include "aux_node.h"
 #include "aux_edge.h"
+#include "edge_chain.h"
 #include "aux_graph.h"
 #include "node_group.h"
+#include "component.h"
+#include "force.h"
+#include "metrics.h"
 
 #endif /** LAYOUT_IFACE_H */
\ No newline at end of file
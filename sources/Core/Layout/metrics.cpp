@@ -0,0 +1,277 @@
+/**
+ * @file: metrics.cpp
+ * Quality and cost of layout
+ *
+ * Layout library, 2d graph placement of graphs in ShowGraph tool.
+ * Copyright (c) 2009, Boris Shurygin
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+ */
+#include "layout_iface.h"
+
+/** Names of layout phases in JSON output */
+static const char *phase_names[ LAYOUT_PHASE_NUM] =
+{
+    "cleanup",
+    "classify",
+    "rank",
+    "levels",
+    "crossings",
+    "components",
+    "arrange",
+    "controls",
+    "force"
+};
+
+/** Names of layout engines in JSON output */
+static const char *engine_names[ LAYOUT_ENGINE_NUM] =
+{
+    "layered",
+    "force"
+};
+
+/**
+ * Edge between adjacent levels as seen by crossings counting
+ */
+struct CrossingSegment
+{
+    /** Rank of upper level */
+    Rank rank;
+    /** Horizontal coordinate of upper end */
+    qreal upper_x;
+    /** Horizontal coordinate of lower end */
+    qreal lower_x;
+
+    /** Segments of the same level pair go together ordered by upper and then lower end */
+    inline bool operator < ( const CrossingSegment &seg) const
+    {
+        if ( rank != seg.rank)
+            return rank < seg.rank;
+        if ( upper_x != seg.upper_x)
+            return upper_x < seg.upper_x;
+        return lower_x < seg.lower_x;
+    }
+};
+
+/**
+ * Count pairs i < j with x[ j] < x[ i], array gets sorted. Bottom-up merge sort, O( N * log N)
+ */
+static quint64 countInversions( QVector< qreal> &x)
+{
+    int num = x.size();
+    QVector< qreal> buf( num);
+    quint64 inversions = 0;
+    qreal *from = x.data();
+    qreal *to = buf.data();
+
+    for ( int width = 1; width < num; width *= 2)
+    {
+        for ( int left = 0; left < num; left += 2 * width)
+        {
+            int mid = qMin( left + width, num);
+            int right = qMin( left + 2 * width, num);
+            int i = left;
+            int j = mid;
+            int k = left;
+
+            while ( i < mid && j < right)
+            {
+                if ( from[ j] < from[ i])
+                {
+                    /** Element of right half goes before all remaining ones of left half */
+                    inversions += mid - i;
+                    to[ k++] = from[ j++];
+                } else
+                {
+                    to[ k++] = from[ i++];
+                }
+            }
+            while ( i < mid)
+                to[ k++] = from[ i++];
+            while ( j < right)
+                to[ k++] = from[ j++];
+        }
+        qSwap( from, to);
+    }
+    if ( from != x.data())
+    {
+        for ( int i = 0; i < num; i++)
+            x[ i] = from[ i];
+    }
+    return inversions;
+}
+
+/** Get center of node */
+static inline QPointF nodeCenter( AuxNode *n)
+{
+    return QPointF( n->modelX() + n->width() / 2, n->modelY() + n->height() / 2);
+}
+
+/**
+ * Constructor
+ */
+LayoutMetrics::LayoutMetrics():
+    engine( LAYOUT_ENGINE_LAYERED),
+    node_num( 0),
+    edge_num( 0),
+    dummy_num( 0),
+    inverted_num( 0),
+    level_crossings(),
+    crossings( 0),
+    total_edge_len( 0),
+    max_edge_len( 0),
+    bounding_rect(),
+    area( 0)
+{
+    for ( int i = 0; i < LAYOUT_PHASE_NUM; i++)
+    {
+        phase_time[ i] = 0;
+    }
+}
+
+/**
+ * Compute metrics of graph's current layout. Graph is expected to be laid out by
+ * doLayout or doLayoutConcurrent, phase times are those of the last layout
+ */
+void LayoutMetrics::compute( AuxGraph *graph)
+{
+    AuxNode *n;
+    QVector< CrossingSegment> segments;
+    Rank max_rank = 0;
+
+    engine = graph->layoutEngine();
+    inverted_num = graph->invertedEdgesNum();
+    node_num = 0;
+    edge_num = 0;
+    dummy_num = 0;
+    total_edge_len = 0;
+    max_edge_len = 0;
+    bounding_rect = QRectF();
+    for ( int i = 0; i < LAYOUT_PHASE_NUM; i++)
+    {
+        phase_time[ i] = graph->phaseTime( ( LayoutPhase) i);
+    }
+
+    foreachNode( n, graph)
+    {
+        QRectF rect( n->modelX(), n->modelY(), n->width(), n->height());
+
+        bounding_rect = bounding_rect.isNull() ? rect : bounding_rect.united( rect);
+        if ( n->isEdgeControl())
+        {
+            dummy_num++;
+        } else
+        {
+            node_num++;
+        }
+        AuxEdge *e;
+        foreachSucc( e, n)
+        {
+            AuxNode *succ = e->succ();
+
+            if ( engine == LAYOUT_ENGINE_LAYERED && !e->isSelf()
+                 && qAbs( succ->rank() - n->rank()) == 1)
+            {
+                AuxNode *upper = n->rank() < succ->rank() ? n : succ;
+                AuxNode *lower = upper == n ? succ : n;
+                CrossingSegment seg;
+
+                seg.rank = upper->rank();
+                seg.upper_x = upper->modelX() + upper->width() / 2;
+                seg.lower_x = lower->modelX() + lower->width() / 2;
+                segments.push_back( seg);
+                max_rank = qMax( max_rank, seg.rank + 1);
+            }
+            if ( n->isEdgeControl() || e->isSelf())
+                continue;
+
+            /** Length of edge is summed along its chain of controls */
+            qreal len = 0;
+            AuxEdge *curr = e;
+
+            edge_num++;
+            while ( true)
+            {
+                len += QLineF( nodeCenter( curr->pred()), nodeCenter( curr->succ())).length();
+                if ( !curr->succ()->isEdgeControl())
+                    break;
+                LAYOUT_ASSERTD( isNotNullP( curr->succ()->firstSucc()),
+                                "Edge control should have a successor");
+                curr = curr->succ()->firstSucc();
+            }
+            total_edge_len += len;
+            max_edge_len = qMax( max_edge_len, len);
+        }
+    }
+    area = bounding_rect.width() * bounding_rect.height();
+
+    /**
+     * Two edges between the same levels cross when the order of their upper ends is opposite
+     * to the order of their lower ends. With segments sorted by upper end the crossings are
+     * inversions of lower ends, edges that share an end are not counted
+     */
+    qSort( segments.begin(), segments.end());
+    level_crossings.fill( 0, max_rank);
+    crossings = 0;
+    for ( int begin = 0; begin < segments.size();)
+    {
+        Rank rank = segments[ begin].rank;
+        QVector< qreal> lower;
+
+        for ( ; begin < segments.size() && segments[ begin].rank == rank; begin++)
+        {
+            lower.push_back( segments[ begin].lower_x);
+        }
+        level_crossings[ rank] = countInversions( lower);
+        crossings += level_crossings[ rank];
+    }
+}
+
+/**
+ * Get metrics as JSON object
+ */
+QString LayoutMetrics::toJSON() const
+{
+    QString str;
+    QTextStream out( &str);
+
+    out << "{\n";
+    out << "    \"engine\": \"" << engine_names[ engine] << "\",\n";
+    out << "    \"nodes\": " << node_num << ",\n";
+    out << "    \"edges\": " << edge_num << ",\n";
+    out << "    \"dummy_nodes\": " << dummy_num << ",\n";
+    out << "    \"inverted_edges\": " << inverted_num << ",\n";
+    out << "    \"crossings\": " << crossings << ",\n";
+    out << "    \"level_crossings\": [";
+    for ( int i = 0; i < level_crossings.size(); i++)
+    {
+        out << ( i == 0 ? "" : ", ") << level_crossings[ i];
+    }
+    out << "],\n";
+    out << "    \"total_edge_length\": " << total_edge_len << ",\n";
+    out << "    \"max_edge_length\": " << max_edge_len << ",\n";
+    out << "    \"bounding_rect\": { \"x\": " << bounding_rect.x()
+        << ", \"y\": " << bounding_rect.y()
+        << ", \"width\": " << bounding_rect.width()
+        << ", \"height\": " << bounding_rect.height() << " },\n";
+    out << "    \"area\": " << area << ",\n";
+    out << "    \"phase_time_ms\": {";
+    for ( int i = 0; i < LAYOUT_PHASE_NUM; i++)
+    {
+        out << ( i == 0 ? " " : ", ") << "\"" << phase_names[ i] << "\": " << phase_time[ i];
+    }
+    out << " }\n";
+    out << "}\n";
+    out.flush();
+    return str;
+}
@@ -0,0 +1,67 @@
+/**
+ * @file: metrics.h
+ * Quality and cost of layout
+ *
+ * Layout library, 2d graph placement of graphs in ShowGraph tool.
+ * Copyright (c) 2009, Boris Shurygin
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+ */
+#ifndef METRICS_H
+#define METRICS_H
+
+/**
+ * Measures of layout quality and cost, read from graph after layout
+ *
+ * @ingroup Layout
+ * Everything is computed in O( ( N + E) * log E) so metrics can be taken for big graphs
+ * in regression runs. Crossings are counted for edges between adjacent levels, so they
+ * are meaningful for layered engine only and are left 0 for force-directed one.
+ * Lengths are measured between centers of nodes along chains of edge controls
+ */
+struct LayoutMetrics
+{
+    /** Layout algorithm that placed the graph */
+    LayoutEngine engine;
+    /** Number of nodes, edge controls are not counted */
+    GraphNum node_num;
+    /** Number of edges, chains of edge controls are counted as one edge */
+    GraphNum edge_num;
+    /** Number of dummy nodes, i.e. edge controls */
+    GraphNum dummy_num;
+    /** Number of edges inverted to break cycles */
+    GraphNum inverted_num;
+    /** Crossings between each level and the next one, indexed by rank of upper level */
+    QVector< quint64> level_crossings;
+    /** Total number of crossings */
+    quint64 crossings;
+    /** Total length of edges */
+    qreal total_edge_len;
+    /** Length of the longest edge */
+    qreal max_edge_len;
+    /** Rectangle occupied by nodes and edge controls */
+    QRectF bounding_rect;
+    /** Area of bounding rectangle */
+    qreal area;
+    /** Time of layout phases in milliseconds */
+    qint64 phase_time[ LAYOUT_PHASE_NUM];
+
+    /** Constructor */
+    LayoutMetrics();
+    /** Compute metrics of graph's current layout */
+    void compute( AuxGraph *graph);
+    /** Get metrics as JSON object */
+    QString toJSON() const;
+};
+
+#endif /** METRICS_H */
@@ -19,180 +19,277 @@
 #include "layout_iface.h"
 
 /**
- * Compare orders of nodes
+ * Make sure buffer can hold given number of elements. Buffers never shrink
  */
-bool compareBc( AuxNode* node1,
-                AuxNode* node2)
+template < class T> static inline void growBuffer( QVector< T> &buf, int size)
 {
-    if ( qFuzzyCompare( node1->bc(), node2->bc()))
-    {
-        return node1->order() < node2->order();
-    }
-    return ( node1->bc() < node2->bc());
+    if ( buf.size() < size)
+        buf.resize( size);
 }
 
 /**
- * Constructor of group from a node.
- * Coordinates are computed with respect to pass direction
+ * Compare center coordinates of initial groups
  */
-NodeGroup::NodeGroup( AuxNode *n,   // Parent node
-                      GraphDir dir, // Pass direction
-                      bool first_pass) // If this is the first run
-                      : node_list()
+struct GroupCenterLess
 {
-    init();
-    addNode( n);
-    /** Compute coordinates */
-    double sum = 0;
-    unsigned int num_peers = 0;
-    /**
-     * On descending pass we compute center coordinate with respect to coordinates of predecessors,
-     * on ascending - we look at successors
-     */
-    GraphDir rdir = RevDir( dir);
-    for ( AuxEdge* e = n->firstEdgeInDir( rdir);
-          isNotNullP( e);
-          e = e->nextEdgeInDir( rdir))
+    /** Level of groups' nodes */
+    const Level *level;
+    /** Left borders */
+    const qreal *left;
+    /** Right borders */
+    const qreal *right;
+
+    /** Constructor */
+    GroupCenterLess( const Level *lvl, const qreal *l, const qreal *r):
+        level( lvl), left( l), right( r){};
+
+    /** Compare groups with given indexes */
+    bool operator()( int g1, int g2) const
     {
-        if ( !e->isInverted())
+        /*
+         * center = g.left + width / 2 = g.left + ( g.right - g.left) / 2 = ( g.left + g.right)/2
+         *
+         *                g1.center < g2.center 
+         * (g1.left + g1.right) / 2 < (g2.left + g2.right) / 2
+         *       g1.left + g1.right < g2.left + g2.right
+         */
+        if ( left[ g1] + right[ g1] == left[ g2] + right[ g2]) 
         {
-            if ( !e->node( rdir)->isForPlacement())
-                continue;
-            num_peers++;
-            if ( e->node( rdir)->isEdgeLabel())
-            {
-                sum+= ( e->node( rdir)->modelX());
-            } else
-            {
-                sum+= ( e->node( rdir)->modelX() + ( e->node( rdir)->width() / 2));
-            }
+            if ( level->order( g1) == level->order( g2))
+                return g1 < g2;
+            return level->order( g1) < level->order( g2);
         }
+        return ( left[ g1] + right[ g1] < left[ g2] + right[ g2]);
     }
-    for ( AuxEdge* e = n->firstEdgeInDir( dir);
-          isNotNullP( e);
-          e = e->nextEdgeInDir( dir))
+};
+
+/**
+ * Compare barycenters of nodes, orders are compared for close barycenters
+ */
+struct BcLess
+{
+    /** Level of nodes */
+    const Level *level;
+
+    /** Constructor */
+    BcLess( const Level *lvl): level( lvl){};
+
+    /** Compare nodes with given indexes */
+    bool operator()( int n1, int n2) const
     {
-        if ( e->isInverted())
+        if ( qFuzzyCompare( level->bc( n1), level->bc( n2)))
         {
-            if ( !e->node( dir)->isForPlacement())
-                continue;
-            
-            num_peers++;
-
-            if ( e->node( dir)->isEdgeLabel())
-            {
-                sum+= ( e->node( dir)->modelX());
-            } else
-            {
-                sum+= ( e->node( dir)->modelX() + ( e->node( dir)->width() / 2));
-            }
+            if ( level->order( n1) == level->order( n2))
+                return n1 < n2;
+            return level->order( n1) < level->order( n2);
         }
+        return ( level->bc( n1) < level->bc( n2));
     }
+};
 
-    /** Barycenter heuristic */
-    double center = 0;
-    edge_num = 1;
-    if ( num_peers > 0)
-    {
-        edge_num = num_peers;
-        center = sum / num_peers;
-    } else if ( !first_pass)
-    {
-        edge_num = 1;
-        center = n->modelX() + n->width() / 2;
-    }
-    if ( n->isEdgeLabel())
-        center += ( n->width() / 2);
-    if ( n->isStable())
+/**
+ * Default constructor
+ */
+NodeGroups::NodeGroups():
+    level( NULL),
+    init_num( 0),
+    group_num( 0),
+    node_num( 0)
+{
+
+}
+
+/**
+ * Create group for each placement node and sort groups by their centers.
+ * Barycenters of level's nodes should be computed beforehand
+ */
+void
+NodeGroups::init( Level *lvl)
+{
+    level = lvl;
+    init_num = level->placedCount();
+    group_num = 0;
+    node_num = 0;
+
+    growBuffer( init_left, init_num);
+    growBuffer( init_right, init_num);
+    growBuffer( init_order, init_num);
+    growBuffer( node_buf, init_num);
+    growBuffer( merge_buf, init_num);
+    growBuffer( group_begin, init_num + 1);
+    growBuffer( group_left, init_num);
+    growBuffer( group_right, init_num);
+    growBuffer( group_bc, init_num);
+    growBuffer( group_weight, init_num);
+
+    for ( int i = 0; i < init_num; i++)
     {
-        center = n->modelX() + n->width() / 2;
+        init_left[ i] = level->bc( i) - level->width( i) / 2;
+        init_right[ i] = level->bc( i) + level->width( i) / 2;
+        init_order[ i] = i;
     }
-    n->setBc( center);
-    barycenter = center;
-    
-    border_left = center - n->width() / 2;
-    border_right = center + n->width() / 2;
+    /** Sort groups with respect to their coordinates */
+    qSort( init_order.data(), init_order.data() + init_num,
+           GroupCenterLess( level, init_left.constData(), init_right.constData()));
 }
 
 /**
- * Merge two groups correcting borders and nodes list of resulting group
+ * Make the group with given number from an initial one-node group
  */
-void NodeGroup::merge( NodeGroup *grp)
+void
+NodeGroups::pushNode( int g, int init_index)
+{
+    group_begin[ g] = node_num;
+    node_buf[ node_num++] = init_index;
+    group_left[ g] = init_left[ init_index];
+    group_right[ g] = init_right[ init_index];
+    group_bc[ g] = level->bc( init_index);
+    group_weight[ g] = level->weight( init_index);
+}
+
+/**
+ * Recalculate borders of group. Group's nodes are the ones from its start
+ * to the end of the node buffer, they form two ranges sorted by barycenters that are split
+ * at mid. Ranges are merged in one pass, the first one is copied to merge buffer for that.
+ * Barycenters and weights of both merged groups are given
+ */
+void
+NodeGroups::mergeGroup( int g, int mid, qreal bc1, unsigned int e1, qreal bc2, unsigned int e2)
 {
-    /** Add nodes from group on the left */
-    node_list += grp->nodes();
     AuxNodeType prev_type = AUX_NODE_TYPES_NUM;
 
-    /** Recalculate border coordinates */
     /* 1. calculate center coordinate */
-    qreal bc1 = bc();
-    qreal bc2 = grp->bc();
-    unsigned int e1 = adjEdgesNum();
-    unsigned int e2 = grp->adjEdgesNum();
-    qreal center = ( right() + left()) / 2; 
-    center = ( bc1 * e1 + bc2 * e2) / (e1 + e2);
+    qreal center = ( bc1 * e1 + bc2 * e2) / (e1 + e2);
     
-    /* 2. calculate width */
+    /* 2. merge sorted ranges of nodes */
+    int *first = node_buf.data() + group_begin[ g];
+    int *last = node_buf.data() + node_num;
+    int *left = merge_buf.data();
+    int *left_end = qCopy( first, node_buf.data() + mid, left);
+    int *right = node_buf.data() + mid;
+    int *out = first;
+    BcLess less( level);
+
+    /** Output never overtakes the second range, it is behind by the rest of the first one */
+    while ( left != left_end && right != last)
+    {
+        if ( less( *right, *left))
+            *out++ = *right++;
+        else
+            *out++ = *left++;
+    }
+    qCopy( left, left_end, out);
+
+    /* 3. calculate width */
     qreal width = 0;
     int num = 0;
     qreal nodes_barycenter = 0;
-    
-    qSort( node_list.begin(), node_list.end(), compareBc);
-    
-    foreach ( AuxNode* node, node_list)
+
+    for ( int *n = first; n != last; n++)
     {
-        width += node->spacing( prev_type);
-        nodes_barycenter += width + node->width() / 2; 
-        width += node->width();
-        prev_type = node->type();
+        width += nodeSpacing( prev_type, level->type( *n));
+        nodes_barycenter += width + level->width( *n) / 2; 
+        width += level->width( *n);
+        prev_type = level->type( *n);
         num++;
     }
     nodes_barycenter = nodes_barycenter / num;
 
-    /* 3. set borders */
-    setLeft( center - nodes_barycenter);
-    setRight( left() + width);
-    barycenter = center;
-    edge_num = e1 + e2;
-    
-    //out("Width %e, center %e, barycenter %e", width, center, barycenter);
-
+    /* 4. set borders */
+    group_left[ g] = center - nodes_barycenter;
+    group_right[ g] = group_left[ g] + width;
+    group_bc[ g] = center;
+    group_weight[ g] = e1 + e2;
 }
 
 /**
- * Place nodes withing the group
+ * Merge groups that interleave.
+ * Groups are taken in the order of their centers. Merged groups form a stack, the current
+ * group is the one after the top. The current group absorbs the top of the stack and
+ * the next initial group while they interleave with it, otherwise it is pushed on stack.
+ * Nodes of groups are kept sorted by barycenters, so merged groups' nodes are merged in one
+ * linear pass. Every group is pushed and popped at most once so merging takes linear number of steps
  */
-void NodeGroup::placeNodes()
+void
+NodeGroups::merge()
 {
-    AuxNodeType prev_type = AUX_NODE_TYPES_NUM;
+    if ( init_num == 0)
+        return;
+
+    int next = 0;
     
-    qreal curr_left = left();
-    foreach ( AuxNode* node, node_list)
+    pushNode( group_num, init_order[ next++]);
+
+    while ( true)
     {
-        curr_left += node->spacing( prev_type);
-        node->setX( curr_left);
-        curr_left += node->width();
-        prev_type = node->type();
+        /* Current group */
+        int g = group_num;
+        bool no_merge = true; 
+
+        /** Group to the left */
+        if ( group_num > 0
+             && interleaves( group_left[ g], group_right[ g],
+                             group_left[ g - 1], group_right[ g - 1]))
+        {
+            mergeGroup( g - 1, group_begin[ g],
+                        group_bc[ g], group_weight[ g], group_bc[ g - 1], group_weight[ g - 1]);
+            group_num--;
+            g--;
+            no_merge = false;
+        }
+        /** Group to the right */
+        if ( next < init_num)
+        {
+            int right_grp = init_order[ next];
+
+            if ( interleaves( group_left[ g], group_right[ g],
+                              init_left[ right_grp], init_right[ right_grp]))
+            {
+                node_buf[ node_num++] = right_grp;
+                next++;
+                mergeGroup( g, node_num - 1, group_bc[ g], group_weight[ g], level->bc( right_grp), level->weight( right_grp));
+                no_merge = false;
+            }
+        }
+        /** Proceed to the next group */
+        if ( no_merge)
+        {
+            group_num++;
+
+            /** End loop if we have processed all groups and merged everything we could */
+            if ( next == init_num)
+                break;
+            pushNode( group_num, init_order[ next++]);
+        }
     }
+    group_begin[ group_num] = node_num;
 }
 
 /**
- * Place nodes withing the group
+ * Place nodes within groups
  */
-void NodeGroup::placeNodesFinal( GraphDir dir)
+void
+NodeGroups::placeNodes( bool commit_placement)
 {
-    AuxNodeType prev_type = AUX_NODE_TYPES_NUM;
-    
-    qreal curr_left = left();
-    //out("Node placement: from %e to %e", left(), right());
-
-    foreach ( AuxNode* node, node_list)
+    for ( int g = 0; g < group_num; g++)
     {
-        //out("Node %d", node->id()); 
-        curr_left += node->spacing( prev_type);
-        node->setX( curr_left);
-        curr_left += node->width();
-        prev_type = node->type();
-        node->setY( node->level()->y() - node->height() / 2 );
+        AuxNodeType prev_type = AUX_NODE_TYPES_NUM;
+        qreal curr_left = group_left[ g];
+
+        for ( int k = group_begin[ g]; k < group_begin[ g + 1]; k++)
+        {
+            int i = node_buf[ k];
+
+            curr_left += nodeSpacing( prev_type, level->type( i));
+            level->setX( i, curr_left);
+            curr_left += level->width( i);
+            prev_type = level->type( i);
+            /** Chain entries get vertical coordinates when edge controls are created */
+            AuxNode *node = level->placedNode( i);
+            if ( commit_placement && isNotNullP( node))
+            {
+                node->setY( level->y() - node->height() / 2 );
+            }
+        }
     }
 }
\ No newline at end of file
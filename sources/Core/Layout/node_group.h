@@ -22,104 +22,87 @@
 #define NODE_GROUP_H
 
 /**
- * Group of nodes
+ * Groups of nodes of one level
  *
  * Abstraction that aids multiple nodes manipulation inside a level.
  *
  * @ingroup HLayout
+ * Groups are kept as structure of arrays: borders, barycenters and weights
+ * ( number of adjacent edges) of groups are stored in separate vectors and
+ * indexes of nodes in level's placement arrays occupy a contiguous range of one buffer.
+ * Buffers only grow, so one object reused for all levels and passes
+ * doesn't allocate memory after the first few levels.
  */
-class NodeGroup
+class NodeGroups
 {
-    /** Number of edges in adjacent layer */
-    unsigned int edge_num;
-    /** Barycenter */
-    qreal barycenter;
-    /** List of group's nodes */
-    QList< AuxNode *> node_list;
-    /** Horizontal coordinate of left border */
-    qreal border_left;
-    /** Horizontal coordinate of right border */
-    qreal border_right;
-    /** The heuristic weight of the group */
-    float group_weight;
-public:
-    /** Initialize attributes of the group */
-    inline void init()
-    {
-        border_left = 0;
-        border_right = 0;
-        group_weight = 0;        
-    }
-    /** Get adjacent number of adjacent edges */
-    inline unsigned int adjEdgesNum() const
-    {
-        return edge_num;
-    }
-    /** Get barycenter of adjacent edges */
-    inline qreal bc() const
-    {
-        return barycenter;
-    }
-    /** Get weight */
-    inline float weight() const
-    {
-        return group_weight;
-    }
-    /** Get left border coordinate */
-    inline qreal left() const
-    {
-        return border_left;
-    }
-    /** Get right border coordinate */
-    inline qreal right() const
-    {
-        return border_right;
-    }
-    /** Set left border coordinate */
-    inline void setLeft( qreal pos)
-    {
-        border_left = pos;
-    }
-    /** Set right border coordinate */
-    inline void setRight( qreal pos)
-    {
-        border_right = pos;
-    }
-    /** Get node list */
-    QList<AuxNode *> nodes() const
+    /** Level which nodes are arranged */
+    Level *level;
+    /** Number of initial one-node groups */
+    int init_num;
+    /** Left borders of initial groups */
+    QVector< qreal> init_left;
+    /** Right borders of initial groups */
+    QVector< qreal> init_right;
+    /** Indexes of initial groups sorted by center coordinate */
+    QVector< int> init_order;
+
+    /** Number of merged groups */
+    int group_num;
+    /** Indexes of nodes of merged groups */
+    QVector< int> node_buf;
+    /** Number of nodes in node buffer */
+    int node_num;
+    /** Copy of the first of two merged ranges of node buffer */
+    QVector< int> merge_buf;
+    /** Start of group's range in node buffer */
+    QVector< int> group_begin;
+    /** Left borders of merged groups */
+    QVector< qreal> group_left;
+    /** Right borders of merged groups */
+    QVector< qreal> group_right;
+    /** Barycenters of merged groups */
+    QVector< qreal> group_bc;
+    /** Weights of merged groups */
+    QVector< unsigned int> group_weight;
+
+    /** Check if two groups interleave */
+    inline bool interleaves( qreal left1, qreal right1, qreal left2, qreal right2) const
     {
-        return node_list;
+        return !( left1 > right2 
+                  || right1 < left2);
     }
+    /** Make group from initial group with given index */
+    void pushNode( int g, int init_index);
+    /**
+     * Merge group with nodes that follow it up to the end of node buffer
+     * and recompute its borders, both ranges are sorted by barycenters
+     */
+    void mergeGroup( int g, int mid, qreal bc1, unsigned int e1, qreal bc2, unsigned int e2);
+public:
+    /** Default constructor */
+    NodeGroups();
+
+    /** Create one-node groups for placement nodes of level using their barycenters */
+    void init( Level *lvl);
+    /** Merge interleaving groups */
+    void merge();
+    /** Place nodes inside groups, on final placement vertical coordinate is adjusted too */
+    void placeNodes( bool commit_placement);
 
-    /** Add node to list */
-    inline void addNode( AuxNode *node)
+    /** Get number of groups */
+    inline int count() const
     {
-        node_list.push_back( node);
-        group_weight += 1;
+        return group_num;
     }
-
-    /** Default constructor */
-    NodeGroup() : node_list()
+    /** Get left border of group */
+    inline qreal left( int g) const
     {
-        init();
+        return group_left[ g];
     }
-
-    /** Constructor of group from a node */
-    NodeGroup( AuxNode *n, GraphDir dir, bool first_pass);
-
-    /** Check if this groups interleaves with the given one */
-    inline bool interleaves( NodeGroup *grp) const
+    /** Get right border of group */
+    inline qreal right( int g) const
     {
-        return !( left() > grp->right() 
-                  || right() < grp->left());
+        return group_right[ g];
     }
-    
-    /** Merge two groups correcting borders and nodes list of resulting group */
-    void merge( NodeGroup *grp);
-
-    /** Place nodes inside group */
-    void placeNodes();
-    /** Place nodes and adjust the view */
-    void placeNodesFinal( GraphDir dir);
 };
 #endif
\ No newline at end of file
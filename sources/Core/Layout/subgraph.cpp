@@ -0,0 +1,206 @@
+/**
+ * @file: subgraph.cpp
+ * Layout of a part of graph
+ * Layout library, 2d graph placement of graphs in ShowGraph tool.
+ * Copyright (c) 2009, Boris Shurygin
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "layout_iface.h"
+
+/**
+ * Graph built from a part of other graph to lay that part out separately
+ *
+ * @ingroup Layout
+ * Edge controls get the size of the original graph's edge controls
+ */
+class LayoutSubgraph: public AuxGraph
+{
+    /** Width of edge controls */
+    qreal control_width;
+    /** Height of edge controls */
+    qreal control_height;
+protected:
+    /** Width of edge control nodes */
+    virtual qreal controlWidth() const
+    {
+        return control_width;
+    }
+    /** Height of edge control nodes */
+    virtual qreal controlHeight() const
+    {
+        return control_height;
+    }
+public:
+    /** Constructor */
+    LayoutSubgraph( qreal width, qreal height):
+        AuxGraph( true),
+        control_width( width),
+        control_height( height)
+    {
+
+    }
+};
+
+/**
+ * Get node at the end of chain of edge controls that starts with given edge
+ */
+static AuxNode *chainSucc( AuxEdge *e)
+{
+    AuxNode *succ = e->succ();
+    while ( succ->isEdgeControl())
+    {
+        LAYOUT_ASSERTD( isNotNullP( succ->firstSucc()), "Edge control should have a successor");
+        succ = succ->firstSucc()->succ();
+    }
+    return succ;
+}
+
+/**
+ * Lay out the subgraph made of given nodes and edges between them, other nodes are not touched.
+ * Nodes and edges are copied to a separate graph so that the work depends on the size of subgraph
+ * only. Edge controls of the original graph are passed through: chains of controls on edges
+ * between given nodes get positions of the controls created by subgraph's layout, missing
+ * controls are inserted and extra ones are put on the line to the successor.
+ * Extra edges between given nodes take part in placement only, they stand for paths
+ * through nodes that are not shown. The first node keeps its position
+ */
+void AuxGraph::doLayoutSubgraph( const QVector< AuxNode *> &nodes,
+                                 const QVector< AuxNodePair> &extra_edges)
+{
+    if ( layout_in_process)
+        return;
+
+    LayoutSubgraph sub( controlWidth(), controlHeight());
+    Numeration num = newNum();
+    QVector< AuxNode *> originals;
+    QVector< AuxNode *> copies;
+
+    foreach ( AuxNode *n, nodes)
+    {
+        if ( n->isEdgeControl() || n->isNumbered( num))
+            continue;
+
+        AuxNode *copy = static_cast< AuxNode *>( sub.newNode());
+        copy->setWidth( n->width());
+        copy->setHeight( n->height());
+        copy->setType( n->type());
+        copy->setStable( n->isStable());
+        copy->setX( n->modelX());
+        copy->setY( n->modelY());
+        n->setNumber( num, originals.size());
+        originals.push_back( n);
+        copies.push_back( copy);
+    }
+    if ( originals.isEmpty())
+    {
+        freeNum( num);
+        return;
+    }
+
+    /** Edges between given nodes, original edges are the first ones of control chains */
+    QVector< AuxEdge *> edges;
+    QVector< AuxEdge *> sub_edges;
+    for ( int i = 0; i < originals.size(); i++)
+    {
+        AuxEdge *e;
+        foreachSucc( e, originals[ i])
+        {
+            AuxNode *succ = chainSucc( e);
+
+            if ( !succ->isNumbered( num))
+                continue;
+            edges.push_back( e);
+            sub_edges.push_back( static_cast< AuxEdge *>(
+                sub.newEdge( copies[ i], copies[ succ->number( num)])));
+        }
+    }
+    foreach ( AuxNodePair pair, extra_edges)
+    {
+        if ( !pair.first->isNumbered( num) || !pair.second->isNumbered( num))
+            continue;
+        sub.newEdge( copies[ pair.first->number( num)], copies[ pair.second->number( num)]);
+    }
+    /** Labels whose edge is cut off are laid out as simple nodes */
+    foreach ( AuxNode *copy, copies)
+    {
+        if ( copy->isEdgeLabel()
+             && ( isNullP( copy->firstPred()) || isNullP( copy->firstSucc())))
+        {
+            copy->setTypeSimple();
+        }
+    }
+
+    sub.setLayoutEngine( layout_engine);
+    sub.setForceMultilevel( force_multilevel);
+    sub.setDeterministic( deterministic);
+    sub.doLayout();
+
+    qreal dx = originals.first()->modelX() - copies.first()->modelX();
+    qreal dy = originals.first()->modelY() - copies.first()->modelY();
+
+    for ( int i = 0; i < originals.size(); i++)
+    {
+        originals[ i]->setX( copies[ i]->modelX() + dx);
+        originals[ i]->setY( copies[ i]->modelY() + dy);
+    }
+
+    for ( int k = 0; k < edges.size(); k++)
+    {
+        AuxEdge *edge = edges[ k];
+        AuxEdge *sub_edge = sub_edges[ k];
+        AuxNode *succ = chainSucc( edge);
+
+        /** Controls created by subgraph's layout */
+        while ( sub_edge->succ()->isEdgeControl())
+        {
+            AuxNode *control = edge->succ();
+            AuxNode *sub_control = sub_edge->succ();
+
+            if ( !control->isEdgeControl())
+            {
+                control = edge->insertNode();
+                control->setType( AUX_EDGE_CONTROL);
+            }
+            control->setX( sub_control->modelX() + dx);
+            control->setY( sub_control->modelY() + dy);
+            edge->setType( sub_edge->type());
+            edge = control->firstSucc();
+            sub_edge = sub_control->firstSucc();
+        }
+        edge->setType( sub_edge->type());
+
+        /** Controls that are left from previous layout */
+        QVector< AuxNode *> extra;
+        for ( AuxNode *control = edge->succ();
+              control->isEdgeControl();
+              control = control->firstSucc()->succ())
+        {
+            extra.push_back( control);
+            control->firstSucc()->setType( sub_edge->type());
+        }
+        if ( extra.isEmpty())
+            continue;
+
+        AuxNode *pred = edge->pred();
+        QPointF from( pred->modelX() + pred->width() / 2, pred->modelY() + pred->height() / 2);
+        QPointF to( succ->modelX() + succ->width() / 2, succ->modelY() + succ->height() / 2);
+        for ( int i = 0; i < extra.size(); i++)
+        {
+            QPointF center = from + ( to - from) * ( i + 1) / ( extra.size() + 1);
+
+            extra[ i]->setX( center.x() - extra[ i]->width() / 2);
+            extra[ i]->setY( center.y() - extra[ i]->height() / 2);
+        }
+    }
+    freeNum( num);
+}
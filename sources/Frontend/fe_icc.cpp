@@ -129,7 +129,7 @@ TestParser::parseLineIL0( QString line)
         {
             SymNode* node = new SymNode( name);
             curr_node = static_cast<CFNode *>( graph->graph()->newNode());
-            curr_node->setDoc( new QTextDocument());
+            curr_node->setText( "");
             node->setNode( curr_node);
             node->node()->item()->setPlainText( text);
 		    if ( good_id)
@@ -53,7 +53,7 @@ TestParser::parseLineLLVM( QString line)
         {
             SymNode* node = new SymNode( name);
             curr_node = static_cast<CFNode *>( graph->graph()->newNode());
-            curr_node->setDoc( new QTextDocument());
+            curr_node->setText( "");
             node->setNode( curr_node);
             node->node()->item()->setPlainText( name);
 	        symtab[ name] = node;
@@ -85,7 +85,7 @@ TestParser::parseLineLLVM( QString line)
             {
                 SymNode* node = new SymNode( pred_name);
                 CFNode * pred_node = static_cast<CFNode *>( graph->graph()->newNode());
-                pred_node->setDoc( new QTextDocument());
+                pred_node->setText( "");
                 node->setNode( pred_node);
                 node->node()->item()->setPlainText( pred_name);
 	            symtab[ pred_name] = node;
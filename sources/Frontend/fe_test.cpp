@@ -55,7 +55,7 @@ void
 TestParser::endNode()
 {
     ASSERTD( isNotNullP( curr_node));
-    curr_node->doc()->setPlainText( node_text);
+    curr_node->setText( node_text);
 }
 
 bool TestParser::nextLine( QString line)
@@ -131,7 +131,7 @@ TestParser::parseLine( QString line)
         {
             SymNode* node = new SymNode( name);
             curr_node = static_cast<CFNode *>( graph->graph()->newNode());
-            curr_node->setDoc( new QTextDocument());
+            curr_node->setText( "");
             node->setNode( curr_node);
             node->node()->item()->setPlainText( text);
 		    if ( good_id)
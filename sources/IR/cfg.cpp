@@ -21,7 +21,7 @@
 #include "ir_impl.h"
 
 /** Constructor */
-CFG::CFG( GraphView *v, bool create_pools): GGraph( v, false)
+CFG::CFG( GraphView *v, bool create_pools): GGraph( v, false), regions()
 {
     /** Pools' creation routine */
     if ( create_pools)
@@ -35,6 +35,7 @@ CFG::CFG( GraphView *v, bool create_pools): GGraph( v, false)
 /** Destructor */
 CFG::~CFG()
 {
+    deleteRegions();
     for ( CFNode *node = firstNode();
           isNotNullP( node);
           )
@@ -29,6 +29,8 @@ class CFG: public GGraph
 {
     IR * priv_ir;
     TestParser *_parser;
+    /** Single-entry regions, parents go before children */
+    QVector< CFRegion *> regions;
 protected:
     /** Node creation reimplementaiton */
     virtual Node * createNode( int _id)
@@ -43,6 +45,12 @@ protected:
                                          static_cast<CFNode *>( _pred), 
                                          static_cast<CFNode *>( _succ));
     }
+    /** Find single-entry regions */
+    void findRegions();
+    /** Delete regions */
+    void deleteRegions();
+    /** Get edges that stand for edges of nodes in folded regions */
+    virtual void foldedEdges( QVector< AuxNodePair> &edges);
 public:
     /** Constructor */
     CFG( GraphView *v, bool create_pools);
@@ -99,6 +107,17 @@ public:
     {
         _parser = p;
     }
+    /** Get single-entry regions */
+    inline const QVector< CFRegion *> &regionList() const
+    {
+        return regions;
+    }
+    /** Fold regions so that only outermost ones are shown as single nodes */
+    void foldRegions();
+    /** Show nodes of all regions */
+    void unfoldRegions();
+    /** Expand folded region headed by given node */
+    virtual bool expandNode( GNode *node);
 };
 
 /**
@@ -21,14 +21,16 @@
 
 /** We can't create nodes separately, do it through newNode method of graph */
 CFNode::CFNode( CFG *graph_p, int _id):
-    GNode( ( GGraph *)graph_p, _id)
+    GNode( ( GGraph *)graph_p, _id),
+    region_p( NULL)
 {
 
 }
 
 /** Contructor of node with specified position */
 CFNode::CFNode( CFG *graph_p, int _id, QPointF _pos):
-    GNode( ( GGraph *)graph_p, _id)
+    GNode( ( GGraph *)graph_p, _id),
+    region_p( NULL)
 {
 
 }
@@ -38,7 +40,9 @@ CFNode::CFNode( CFG *graph_p, int _id, QPointF _pos):
  */
 CFNode::~CFNode()
 {
-
+    /** Regions are not valid without the node */
+    if ( isNotNullP( region_p))
+        graph()->unfoldRegions();
 }
 
 CFG* CFNode::graph() const
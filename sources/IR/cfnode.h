@@ -29,6 +29,8 @@ class CFNode: public GNode
 {
     Expr *first;
     Expr *last;
+    /** Region that node belongs to, nodes of nested regions don't belong to outer ones */
+    CFRegion *region_p;
 protected:    
     /** We can't create nodes separately, do it through newNode method of graph */
     CFNode( CFG *graph_p, int _id);
@@ -62,6 +64,16 @@ public:
     {
         last = expr;
     }
+    /** Get region that node belongs to */
+    inline CFRegion *region() const
+    {
+        return region_p;
+    }
+    /** Set region that node belongs to */
+    inline void setRegion( CFRegion *region)
+    {
+        region_p = region;
+    }
     /** Get next graph's node */
     inline CFNode* nextNode()
     {
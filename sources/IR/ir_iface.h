@@ -33,11 +33,13 @@ class IR;
 class IRView;
 class CFEdge;
 class CFNode;
+class CFRegion;
 class Dep;
 class Expr;
 
 #include "../QtGUI/gui_iface.h"
 #include "cfedge.h"
+#include "region.h"
 #include "cfnode.h"
 #include "cfg.h"
 #include "dep.h"
@@ -0,0 +1,383 @@
+/**
+ * @file: region.cpp
+ * Finding and folding of single-entry regions of CFG
+ */
+/*
+ * IR implementation
+ * Copyright (c) 2009, Boris Shurygin
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "ir_impl.h"
+
+/**
+ * Get node at the end of chain of edge controls and labels that starts with given edge
+ */
+static CFNode *chainSucc( CFEdge *e)
+{
+    CFNode *succ = e->succ();
+    while ( succ->isPseudo())
+    {
+        assert( isNotNullP( succ->firstSucc()));
+        succ = succ->firstSucc()->succ();
+    }
+    return succ;
+}
+
+/**
+ * Find nearest common dominator of two nodes given by their postorder numbers
+ */
+static int intersect( int v1, int v2, const QVector< int> &idom)
+{
+    while ( v1 != v2)
+    {
+        while ( v1 < v2)
+            v1 = idom[ v1];
+        while ( v2 < v1)
+            v2 = idom[ v2];
+    }
+    return v1;
+}
+
+/**
+ * Find single-entry regions. Dominators are computed by the iterative algorithm
+ * of Cooper, Harvey and Kennedy. Nodes without predecessors and nodes of cycles
+ * that can't be reached from them are dominated by a virtual root. Then the dominator
+ * tree is cut bottom-up: node becomes a region head as soon as it dominates
+ * at least REGION_MIN_NODES nodes that are not in regions yet. Edge controls and labels
+ * are passed through. Takes O( V + E) besides the dominators iterations, which are
+ * few for CFGs of structured code
+ */
+void CFG::findRegions()
+{
+    Numeration num = newNum();
+    QVector< CFNode *> nodes;
+    CFNode *n;
+    CFEdge *e;
+
+    foreachNode( n, this)
+    {
+        if ( n->isPseudo())
+            continue;
+        n->setNumber( num, nodes.size());
+        nodes.push_back( n);
+    }
+
+    int node_num = nodes.size();
+    QVector< int> succ_begin( node_num + 1, 0);
+    QVector< int> pred_begin( node_num + 1, 0);
+
+    /** Adjacency lists in contiguous arrays */
+    for ( int v = 0; v < node_num; v++)
+    {
+        foreachSucc( e, nodes[ v])
+        {
+            succ_begin[ v + 1]++;
+            pred_begin[ chainSucc( e)->number( num) + 1]++;
+        }
+    }
+    for ( int v = 0; v < node_num; v++)
+    {
+        succ_begin[ v + 1] += succ_begin[ v];
+        pred_begin[ v + 1] += pred_begin[ v];
+    }
+
+    QVector< int> succ_vec( succ_begin[ node_num]);
+    QVector< int> pred_vec( pred_begin[ node_num]);
+    QVector< int> pred_pos = pred_begin;
+
+    for ( int v = 0; v < node_num; v++)
+    {
+        int succ_pos = succ_begin[ v];
+        foreachSucc( e, nodes[ v])
+        {
+            int succ = chainSucc( e)->number( num);
+            succ_vec[ succ_pos++] = succ;
+            pred_vec[ pred_pos[ succ]++] = v;
+        }
+    }
+    freeNum( num);
+
+    /**
+     * Depth-first search from nodes without predecessors, then from the rest of unvisited ones.
+     * Nodes are renumbered in postorder, virtual root gets the largest number
+     */
+    QVector< int> post;
+    QVector< int> post_num( node_num, -1);
+    QVector< bool> is_root( node_num, false);
+    QVector< int> stack;
+    QVector< int> stack_pos;
+
+    post.reserve( node_num);
+    for ( int pass = 0; pass < 2; pass++)
+    {
+        for ( int r = 0; r < node_num; r++)
+        {
+            if ( post_num[ r] != -1
+                 || ( pass == 0 && pred_begin[ r] != pred_begin[ r + 1]))
+            {
+                continue;
+            }
+            is_root[ r] = true;
+            post_num[ r] = 0;
+            stack.push_back( r);
+            stack_pos.push_back( succ_begin[ r]);
+            while ( !stack.isEmpty())
+            {
+                int v = stack.last();
+                int &k = stack_pos.last();
+
+                if ( k < succ_begin[ v + 1])
+                {
+                    int succ = succ_vec[ k++];
+                    if ( post_num[ succ] == -1)
+                    {
+                        post_num[ succ] = 0;
+                        stack.push_back( succ);
+                        stack_pos.push_back( succ_begin[ succ]);
+                    }
+                } else
+                {
+                    post_num[ v] = post.size();
+                    post.push_back( v);
+                    stack.pop_back();
+                    stack_pos.pop_back();
+                }
+            }
+        }
+    }
+
+    /** Immediate dominators in terms of postorder numbers */
+    int root = node_num;
+    QVector< int> idom( node_num + 1, -1);
+    bool changed = true;
+
+    idom[ root] = root;
+    while ( changed)
+    {
+        changed = false;
+        for ( int i = node_num - 1; i >= 0; i--)
+        {
+            int v = post[ i];
+            int new_idom = is_root[ v] ? root : -1;
+
+            for ( int k = pred_begin[ v]; k < pred_begin[ v + 1]; k++)
+            {
+                int p = post_num[ pred_vec[ k]];
+                if ( idom[ p] == -1)
+                    continue;
+                new_idom = ( new_idom == -1) ? p : intersect( p, new_idom, idom);
+            }
+            if ( idom[ i] != new_idom)
+            {
+                idom[ i] = new_idom;
+                changed = true;
+            }
+        }
+    }
+
+    /** Cut dominator tree into regions, children go before parents in postorder */
+    QVector< int> rest( node_num + 1, 1);
+    QVector< int> size( node_num + 1, 1);
+    QVector< bool> is_head( node_num, false);
+
+    for ( int i = 0; i < node_num; i++)
+    {
+        size[ idom[ i]] += size[ i];
+        if ( rest[ i] >= ( int)REGION_MIN_NODES)
+        {
+            is_head[ i] = true;
+        } else
+        {
+            rest[ idom[ i]] += rest[ i];
+        }
+    }
+
+    /** Create regions, parents go before children in reverse postorder */
+    QVector< CFRegion *> region_of( node_num + 1, NULL);
+
+    for ( int i = node_num - 1; i >= 0; i--)
+    {
+        CFRegion *region = region_of[ idom[ i]];
+        CFNode *node = nodes[ post[ i]];
+
+        if ( is_head[ i])
+        {
+            CFRegion *parent = region;
+
+            region = new CFRegion( node, parent, size[ i]);
+            if ( isNotNullP( parent))
+                parent->addChild( region);
+            regions.push_back( region);
+        }
+        region_of[ i] = region;
+        if ( isNotNullP( region))
+            region->addNode( node);
+        node->setRegion( region);
+    }
+}
+
+/**
+ * Delete regions, nodes that are hidden in folded regions stay hidden
+ */
+void CFG::deleteRegions()
+{
+    foreach ( CFRegion *region, regions)
+    {
+        foreach ( CFNode *node, region->nodes())
+        {
+            node->setRegion( NULL);
+        }
+        delete region;
+    }
+    regions.clear();
+}
+
+/**
+ * Fold regions of graph. Only nodes that are not in regions and heads of outermost
+ * regions are shown and laid out, the rest is shown when user expands the regions.
+ * Layout is not run
+ */
+void CFG::foldRegions()
+{
+    if ( view()->isContext())
+        return;
+
+    deleteRegions();
+    findRegions();
+    if ( regions.isEmpty())
+        return;
+
+    CFNode *n;
+
+    emptySelection();
+    context_nodes.clear();
+    folded = true;
+    foreachNode( n, this)
+    {
+        CFRegion *region = n->region();
+        bool shown = !n->isPseudo()
+                     && ( isNullP( region)
+                          || ( region->head() == n && isNullP( region->parent())));
+
+        n->item()->setVisible( shown);
+        n->item()->setFolded( shown && isNotNullP( region));
+        n->setForPlacement( shown);
+        n->setStable( false);
+        if ( shown)
+            context_nodes.push_back( n);
+    }
+}
+
+/**
+ * Show all nodes and forget regions, layout is not run
+ */
+void CFG::unfoldRegions()
+{
+    if ( folded)
+    {
+        CFNode *n;
+
+        folded = false;
+        context_nodes.clear();
+        foreachNode( n, this)
+        {
+            n->item()->setVisible( true);
+            n->item()->setFolded( false);
+            n->setForPlacement( true);
+        }
+    }
+    deleteRegions();
+}
+
+/**
+ * Expand folded region headed by given node. Region's own nodes and heads of its nested
+ * regions appear where the head is and take part in the next layout
+ */
+bool CFG::expandNode( GNode *node)
+{
+    CFNode *head = static_cast< CFNode *>( node);
+    CFRegion *region = head->region();
+
+    if ( !folded
+         || isNullP( region)
+         || region->head() != head
+         || region->isExpanded()
+         || ( isNotNullP( region->parent()) && !region->parent()->isExpanded()))
+    {
+        return false;
+    }
+
+    QVector< CFNode *> shown = region->nodes();
+    QPointF pos = head->item()->pos();
+
+    foreach ( CFRegion *child, region->children())
+    {
+        shown.push_back( child->head());
+    }
+    region->setExpanded();
+    head->item()->setFolded( false);
+    foreach ( CFNode *n, shown)
+    {
+        if ( n == head)
+            continue;
+        n->item()->setPos( pos);
+        n->item()->setVisible( true);
+        n->item()->setFolded( n->region() != region);
+        n->setForPlacement( true);
+        context_nodes.push_back( n);
+    }
+    return true;
+}
+
+/**
+ * Edges of folded regions are given to layout as edges between the nodes that stand for their ends
+ */
+void CFG::foldedEdges( QVector< AuxNodePair> &edges)
+{
+    QSet< AuxNodePair> edge_set;
+    CFNode *n;
+    CFEdge *e;
+
+    /** Parents go before children */
+    foreach ( CFRegion *region, regions)
+    {
+        region->updateCover();
+    }
+    foreachNode( n, this)
+    {
+        if ( n->isPseudo())
+            continue;
+
+        CFNode *pred = isNotNullP( n->region()) && isNotNullP( n->region()->cover())
+                       ? n->region()->cover()->head()
+                       : n;
+        foreachSucc( e, n)
+        {
+            CFNode *succ = chainSucc( e);
+            CFNode *succ_shown = isNotNullP( succ->region()) && isNotNullP( succ->region()->cover())
+                                 ? succ->region()->cover()->head()
+                                 : succ;
+
+            /** Edges between shown nodes are laid out as they are */
+            if ( ( pred == n && succ_shown == succ) || pred == succ_shown)
+                continue;
+
+            AuxNodePair pair( pred, succ_shown);
+            if ( !edge_set.contains( pair))
+            {
+                edge_set.insert( pair);
+                edges.push_back( pair);
+            }
+        }
+    }
+}
@@ -0,0 +1,129 @@
+/**
+ * @file: region.h
+ * Single-entry regions of control flow graph
+ */
+/*
+ * IR interface
+ * Copyright (c) 2009, Boris Shurygin
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+#ifndef REGION_H
+#define REGION_H
+
+/** Minimal number of nodes that region has besides nested regions */
+const GraphNum REGION_MIN_NODES = 32;
+/** Minimal number of CFG nodes for which regions are folded when graph is opened */
+const GraphNum FOLD_MIN_NODES = 2000;
+
+/**
+ * Single-entry region of control flow graph
+ *
+ * Region is made of its head and nodes that the head dominates, so the region
+ * is entered only through the head. Loops lie in the region of their header.
+ * Dominated parts that are big enough form nested regions, nodes of nested regions
+ * are not among region's own nodes. Folded region is shown as its head only
+ */
+class CFRegion
+{
+    /** Entry node */
+    CFNode *head_p;
+    /** Region that contains this one */
+    CFRegion *parent_p;
+    /** Nested regions */
+    QVector< CFRegion *> child_regions;
+    /** Nodes that don't belong to nested regions, head goes first */
+    QVector< CFNode *> region_nodes;
+    /** Number of nodes including the ones of nested regions */
+    GraphNum node_num;
+    /** Whether region is shown with its nodes */
+    bool expanded;
+    /** Folded region that hides this one, NULL if region is shown */
+    CFRegion *cover_p;
+public:
+    /** Constructor */
+    CFRegion( CFNode *head, CFRegion *parent, GraphNum num):
+        head_p( head),
+        parent_p( parent),
+        child_regions(),
+        region_nodes(),
+        node_num( num),
+        expanded( false),
+        cover_p( NULL)
+    {
+
+    }
+    /** Get entry node */
+    inline CFNode *head() const
+    {
+        return head_p;
+    }
+    /** Get region that contains this one */
+    inline CFRegion *parent() const
+    {
+        return parent_p;
+    }
+    /** Get nested regions */
+    inline const QVector< CFRegion *> &children() const
+    {
+        return child_regions;
+    }
+    /** Get nodes that don't belong to nested regions */
+    inline const QVector< CFNode *> &nodes() const
+    {
+        return region_nodes;
+    }
+    /** Get number of nodes including the ones of nested regions */
+    inline GraphNum nodeCount() const
+    {
+        return node_num;
+    }
+    /** Add nested region */
+    inline void addChild( CFRegion *region)
+    {
+        child_regions.push_back( region);
+    }
+    /** Add node */
+    inline void addNode( CFNode *node)
+    {
+        region_nodes.push_back( node);
+    }
+    /** Check if region is shown with its nodes */
+    inline bool isExpanded() const
+    {
+        return expanded;
+    }
+    /** Show or hide region's nodes */
+    inline void setExpanded( bool e = true)
+    {
+        expanded = e;
+    }
+    /** Get folded region that hides this one */
+    inline CFRegion *cover() const
+    {
+        return cover_p;
+    }
+    /** Find folded region that hides this one, cover of parent should be up to date */
+    inline void updateCover()
+    {
+        if ( isNotNullP( parent_p) && isNotNullP( parent_p->cover()))
+        {
+            cover_p = parent_p->cover();
+        } else
+        {
+            cover_p = expanded ? NULL : this;
+        }
+    }
+};
+
+#endif /* REGION_H */
@@ -110,40 +110,73 @@ void MainWindow::printContents()
     graph_view->render(&painter);
 }
 
+/**
+ * Export visible part of graph to image file. Image too big to be kept in memory
+ * is offered only in formats that are written row by row
+ */
 void MainWindow::exportImage()
 {
+    QSize size = ImageExport::imageSize( graph_view, IMAGE_EXPORT_SCALE_FACTOR, IMAGE_RECT_ADJUST);
+    QString filter;
+
+    if ( ImageExport::fitsInMemory( size))
+    {
+        filter = tr("Windows Bitmap ( *.bmp);;").
+                 append( tr("Joint Photographic Experts Group (*.jpg);;")).
+                 append( tr("Joint Photographic Experts Group (*.jpeg);;")).
+                 append( tr("Portable Network Graphics( *.png);;")).
+                 append( tr("Tagged Image File Format( *.tiff)"));
+    } else
+    {
+        filter = tr("Portable Network Graphics( *.png);;").
+                 append( tr("Windows Bitmap ( *.bmp)"));
+    }
+
     QString fileName =
         QFileDialog::getSaveFileName( this, tr("Export Image"),
                                       QDir::currentPath(),
-                                      tr("Windows Bitmap ( *.bmp);;").
-                                      append( tr("Joint Photographic Experts Group (*.jpg);;")).
-                                      append( tr("Joint Photographic Experts Group (*.jpeg);;")).
-                                      append( tr("Portable Network Graphics( *.png);;")).
-                                      append( tr("Tagged Image File Format( *.tiff)")));
+                                      filter);
     if (fileName.isEmpty())
         return;
+    if ( !ImageExport::canExport( fileName, size))
+    {
+        QMessageBox::warning( this, tr("Export Image"),
+                              tr("Image of %1x%2 pixels is too big for this format, export it to PNG or BMP")
+                              .arg( size.width())
+                              .arg( size.height()));
+        return;
+    }
     
-    QRectF scene_rect( graph_view->scene()->itemsBoundingRect()
-                       .adjusted( -IMAGE_RECT_ADJUST, -IMAGE_RECT_ADJUST,
-                                   IMAGE_RECT_ADJUST, IMAGE_RECT_ADJUST));
-	/** We render */
-	QImage image( scene_rect.width() * IMAGE_EXPORT_SCALE_FACTOR,
-		          scene_rect.height() * IMAGE_EXPORT_SCALE_FACTOR,
-				  QImage::Format_RGB32);
-	image.fill( graph_view->palette().base().color().rgb());
-    QPainter pp( &image);
-	pp.setRenderHints( graph_view->renderHints());
-    graph_view->scene()->render( &pp, image.rect(), scene_rect);
-    QImageWriter writer( fileName);
-    if ( writer.canWrite() && writer.write( image))
+    /** Image is rendered by tiles in background, window stays responsive meanwhile */
+    export_file_name = fileName;
+    exportImageAct->setEnabled( false);
+    statusBar()->showMessage( tr("Exporting image..."));
+    graph_view->startImageExport( fileName, IMAGE_EXPORT_SCALE_FACTOR, IMAGE_RECT_ADJUST);
+}
+
+/**
+ * Show progress of image export
+ */
+void MainWindow::imageExportProgress( int done, int total)
+{
+    statusBar()->showMessage( tr("Exporting image... %1%").arg( done * 100 / total));
+}
+
+/**
+ * Report result of image export
+ */
+void MainWindow::imageExported( bool ok, const QString &error)
+{
+    exportImageAct->setEnabled( true);
+    if ( ok)
     {
         statusBar()->showMessage(tr("Image exported"), 2000);
     } else
     {
         QMessageBox::warning( this, tr("Export Image"),
                               tr("Cannot write file %1:\n%2")
-                              .arg( fileName)
-                              .arg( writer.errorString()));
+                              .arg( export_file_name)
+                              .arg( error));
         statusBar()->showMessage(tr("Image write failed"), 2000);
     }
 }
@@ -164,7 +197,7 @@ void MainWindow::textClicked( const QUrl & link)
 void MainWindow::showNodeText( GNode *node)
 {
 	CFNode *cf_node = static_cast< CFNode *>( node);
-    if ( isNotNullP( node->doc()))
+    if ( node->hasText())
 	{
 		if ( !node->isTextShown())
 		{
@@ -172,7 +205,7 @@ void MainWindow::showNodeText( GNode *node)
 			TextView* text_view = new TextView( cf_node);
 			dock->setWidget( text_view);
 			addDockWidget(Qt::RightDockWidgetArea, dock);
-			text_view->setPlainText( node->doc()->toPlainText());
+			text_view->setPlainText( node->text());
 			cf_node->setTextShown();
 			cf_node->item()->setTextDock( dock);
 			textDocks.push_back( dock);
@@ -195,8 +228,9 @@ void MainWindow::removeGraphView()
 		delete tdock;
 	}
 	textDocks.clear();
-	/** Delete old graph and text views */
+	/** Delete old graph and text views, image export of the old view is dropped with it */
     delete graph_view;
+    exportImageAct->setEnabled( true);
 }
 
 void MainWindow::connectToGraphView( GraphView *gview)
@@ -213,13 +247,30 @@ void MainWindow::connectToGraphView( GraphView *gview)
              gview, SLOT( toggleSmoothFocus( bool)));
     connect( contextViewAct, SIGNAL( toggled( bool)),
              gview, SLOT( toggleViewMode( bool)));
+    connect( virtualSceneAct, SIGNAL( toggled( bool)),
+             gview, SLOT( toggleVirtualScene( bool)));
+    connect( tileCacheAct, SIGNAL( toggled( bool)),
+             gview, SLOT( toggleTileCache( bool)));
+    connect( overviewAct, SIGNAL( toggled( bool)),
+             gview, SLOT( toggleOverview( bool)));
+    connect( edgeChainsAct, SIGNAL( toggled( bool)),
+             gview, SLOT( toggleEdgeChains( bool)));
     gview->toggleSmoothFocus( trackFocusAct->isChecked());
     gview->toggleViewMode( contextViewAct->isChecked());
+    gview->toggleVirtualScene( virtualSceneAct->isChecked());
+    gview->toggleTileCache( tileCacheAct->isChecked());
+    gview->toggleOverview( overviewAct->isChecked());
+    gview->toggleEdgeChains( edgeChainsAct->isChecked());
+    gview->buildTextIndex();
+    gview->graph()->setLayoutEngine( forceLayoutAct->isChecked() ? LAYOUT_ENGINE_FORCE
+                                                                 : LAYOUT_ENGINE_LAYERED);
     /** Place graph view in window */
     setCentralWidget( graph_view);
     connect( gview->graph(), SIGNAL(progressChange(int)), progress_bar, SLOT(setValue(int)));
     connect( gview->graph(), SIGNAL(layoutDone()), this, SLOT(layoutDone()));
-    graph_view->scene()->setItemIndexMethod( QGraphicsScene::BspTreeIndex);
+    connect( gview, SIGNAL( imageExportProgress( int, int)), this, SLOT( imageExportProgress( int, int)));
+    connect( gview, SIGNAL( imageExported( bool, const QString &)),
+             this, SLOT( imageExported( bool, const QString &)));
 }
 
 void MainWindow::open()
@@ -315,9 +366,18 @@ void MainWindow::openFile( QString fileName)
         }
     }
     
-    /** Run layout automatically */
+    /** Run layout automatically, big CFGs are shown with regions folded */
     if ( do_layout)
+    {
+        bool fold = graph_view->graph()->nodeCount() >= FOLD_MIN_NODES;
+
+        foldRegionsAct->blockSignals( true);
+        foldRegionsAct->setChecked( fold);
+        foldRegionsAct->blockSignals( false);
+        if ( fold)
+            static_cast< CFG *>( graph_view->graph())->foldRegions();
         runLayout();
+    }
     //statusBar()->showMessage(tr("File %1 loaded").arg( fileName), 2000);
 }
 
@@ -523,10 +583,43 @@ void MainWindow::runLayout()
     graph_view->graph()->doLayout();
 }
 
+void MainWindow::stopLayout()
+{
+    graph_view->graph()->cancelLayout();
+}
+
+void MainWindow::toggleFolding( bool fold)
+{
+    CFG *cfg = static_cast< CFG *>( graph_view->graph());
+
+    if ( graph_view->isContext())
+        return;
+    if ( fold)
+    {
+        cfg->foldRegions();
+    } else
+    {
+        cfg->unfoldRegions();
+    }
+    runLayout();
+}
+
+void MainWindow::toggleForceLayout( bool force)
+{
+    graph_view->graph()->setLayoutEngine( force ? LAYOUT_ENGINE_FORCE : LAYOUT_ENGINE_LAYERED);
+    runLayout();
+}
+
 void MainWindow::layoutDone()
 {
     progress_bar->hide();
-    statusBar()->showMessage(tr("Layout done"), 2000);
+    if ( graph_view->graph()->isLayoutCancelled())
+    {
+        statusBar()->showMessage(tr("Layout cancelled"), 2000);
+    } else
+    {
+        statusBar()->showMessage(tr("Layout done"), 2000);
+    }
 }
 
 void MainWindow::saveAs()
@@ -595,6 +688,10 @@ void MainWindow::createActions()
     layoutRunAct->setShortcut(tr("F5"));
     connect( layoutRunAct, SIGNAL(triggered()), this, SLOT( runLayout()));
 
+    layoutStopAct = new QAction( tr("&Stop Layout"), this);
+    layoutStopAct->setShortcut(tr("Shift+F5"));
+    connect( layoutStopAct, SIGNAL(triggered()), this, SLOT( stopLayout()));
+
     zoomInAct = new QAction( QIcon(QString::fromUtf8(":/images/win/Zoom In/Zoom In.ico")),
                              tr("&Zoom In"), this);
     //zoomInAct->setShortcut(Qt::Key_Plus);
@@ -631,6 +728,32 @@ void MainWindow::createActions()
     contextViewAct = new QAction( tr("Context View"), this);
     contextViewAct->setCheckable( true);
     contextViewAct->setChecked( false);
+
+    foldRegionsAct = new QAction( tr("Fold Regions"), this);
+    foldRegionsAct->setCheckable( true);
+    foldRegionsAct->setChecked( false);
+    connect( foldRegionsAct, SIGNAL( toggled( bool)), this, SLOT( toggleFolding( bool)));
+
+    forceLayoutAct = new QAction( tr("Force-Directed Layout"), this);
+    forceLayoutAct->setCheckable( true);
+    forceLayoutAct->setChecked( false);
+    connect( forceLayoutAct, SIGNAL( toggled( bool)), this, SLOT( toggleForceLayout( bool)));
+
+    virtualSceneAct = new QAction( tr("Virtual Scene"), this);
+    virtualSceneAct->setCheckable( true);
+    virtualSceneAct->setChecked( false);
+
+    tileCacheAct = new QAction( tr("Tile Cache"), this);
+    tileCacheAct->setCheckable( true);
+    tileCacheAct->setChecked( false);
+
+    overviewAct = new QAction( tr("Overview When Zoomed Out"), this);
+    overviewAct->setCheckable( true);
+    overviewAct->setChecked( true);
+
+    edgeChainsAct = new QAction( tr("Draw Edge Chains As One Item"), this);
+    edgeChainsAct->setCheckable( true);
+    edgeChainsAct->setChecked( false);
 }
 
 void MainWindow::createMenus()
@@ -649,7 +772,14 @@ void MainWindow::createMenus()
 
     viewMenu = menuBar()->addMenu( tr( "&View"));
     viewMenu->addAction( layoutRunAct);
+    viewMenu->addAction( layoutStopAct);
     viewMenu->addAction( contextViewAct);
+    viewMenu->addAction( foldRegionsAct);
+    viewMenu->addAction( forceLayoutAct);
+    viewMenu->addAction( virtualSceneAct);
+    viewMenu->addAction( tileCacheAct);
+    viewMenu->addAction( overviewAct);
+    viewMenu->addAction( edgeChainsAct);
     viewMenu->addSeparator();
 	viewMenu->addAction( zoomInAct);
     viewMenu->addAction( zoomOutAct);
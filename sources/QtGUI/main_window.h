@@ -102,6 +102,8 @@ private:
     QProgressBar* progress_bar;
     QList< QDockWidget *> textDocks;
 	Conf* conf;
+    /** Name of file that image is being exported to */
+    QString export_file_name;
 public:
     /** Constructor */
     MainWindow();
@@ -113,6 +115,12 @@ public slots:
     void newGraph();
     /** Run layout procedure on the current graph view */   
     void runLayout();
+    /** Stop layout running in background */
+    void stopLayout();
+    /** Fold or unfold regions of CFG and run layout */
+    void toggleFolding( bool fold);
+    /** Switch between layered and force-directed layout and run layout */
+    void toggleForceLayout( bool force);
     /** Perform actions after layout */
     void layoutDone();
     /** Save graph representation */   
@@ -131,8 +139,12 @@ public slots:
     void zoomOrig();
     /** Show text window for selected node */
     void showNodeText( GNode *node);
-    /** Show text window for selected node */
+    /** Export picture of graph to image file */
     void exportImage();
+    /** Show progress of image export */
+    void imageExportProgress( int done, int total);
+    /** Report result of image export */
+    void imageExported( bool ok, const QString &error);
     /** Print picture */
     void printContents();
     /** React to anchor click in text view */
@@ -175,7 +187,14 @@ private:
     QAction *exitAct;
     QAction *aboutAct;
     QAction *layoutRunAct;
+    QAction *layoutStopAct;
     QAction *contextViewAct;
+    QAction *foldRegionsAct;
+    QAction *forceLayoutAct;
+    QAction *virtualSceneAct;
+    QAction *tileCacheAct;
+    QAction *overviewAct;
+    QAction *edgeChainsAct;
 	QAction *findAct;
     QAction *navPrevAct;
     QAction *navNextAct;
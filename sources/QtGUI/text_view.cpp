@@ -195,7 +195,7 @@ void TextView::mouseReleaseEvent( QMouseEvent * ev)
                     new_node->item()->setTextDock( dock);
                     new_node->setTextShown();
                     document()->clear();
-                    setPlainText( new_node->doc()->toPlainText());
+                    setPlainText( new_node->text());
                     new_node->graph()->parser()->highlightText( document());
                     node = new_node;
                     dock->setWindowTitle( QString("Node %1").arg( node->irId()));
@@ -0,0 +1,879 @@
+/**
+ * @file: layout_utest.cpp 
+ * Implementation of testing of Layout library
+ */
+/*
+ * Copyright (c) 2009, Boris Shurygin
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "utest_impl.h"
+
+/**
+ * Compare nodes by barycenter, same as in layout library
+ */
+static bool refCompareBc( AuxNode* node1,
+                          AuxNode* node2)
+{
+    if ( qFuzzyCompare( node1->bc(), node2->bc()))
+    {
+        return node1->order() < node2->order();
+    }
+    return ( node1->bc() < node2->bc());
+}
+
+/**
+ * Reference group of nodes, one heap object per group as the original
+ * list-based group merge algorithm had it
+ */
+class RefGroup
+{
+public:
+    unsigned int edge_num;
+    qreal barycenter;
+    QList< AuxNode *> node_list;
+    qreal left;
+    qreal right;
+
+    /** Create group of one node */
+    RefGroup( AuxNode *n, GraphDir dir, bool first_pass): node_list()
+    {
+        node_list << n;
+        double sum = 0;
+        unsigned int num_peers = 0;
+        GraphDir rdir = RevDir( dir);
+        for ( AuxEdge* e = n->firstEdgeInDir( rdir); isNotNullP( e); e = e->nextEdgeInDir( rdir))
+        {
+            if ( !e->isInverted() && e->node( rdir)->isForPlacement())
+            {
+                num_peers++;
+                if ( e->node( rdir)->isEdgeLabel())
+                {
+                    sum+= ( e->node( rdir)->modelX());
+                } else
+                {
+                    sum+= ( e->node( rdir)->modelX() + ( e->node( rdir)->width() / 2));
+                }
+            }
+        }
+        for ( AuxEdge* e = n->firstEdgeInDir( dir); isNotNullP( e); e = e->nextEdgeInDir( dir))
+        {
+            if ( e->isInverted() && e->node( dir)->isForPlacement())
+            {
+                num_peers++;
+                if ( e->node( dir)->isEdgeLabel())
+                {
+                    sum+= ( e->node( dir)->modelX());
+                } else
+                {
+                    sum+= ( e->node( dir)->modelX() + ( e->node( dir)->width() / 2));
+                }
+            }
+        }
+        double center = 0;
+        edge_num = 1;
+        if ( num_peers > 0)
+        {
+            edge_num = num_peers;
+            center = sum / num_peers;
+        } else if ( !first_pass)
+        {
+            center = n->modelX() + n->width() / 2;
+        }
+        if ( n->isEdgeLabel())
+            center += ( n->width() / 2);
+        if ( n->isStable())
+            center = n->modelX() + n->width() / 2;
+        n->setBc( center);
+        barycenter = center;
+        left = center - n->width() / 2;
+        right = center + n->width() / 2;
+    }
+    
+    /** Check if groups interleave */
+    bool interleaves( RefGroup *grp) const
+    {
+        return !( left > grp->right || right < grp->left);
+    }
+
+    /** Merge given group into this one */
+    void merge( RefGroup *grp)
+    {
+        node_list += grp->node_list;
+        AuxNodeType prev_type = AUX_NODE_TYPES_NUM;
+        qreal center = ( barycenter * edge_num + grp->barycenter * grp->edge_num)
+                       / ( edge_num + grp->edge_num);
+        qreal width = 0;
+        int num = 0;
+        qreal nodes_barycenter = 0;
+        
+        qSort( node_list.begin(), node_list.end(), refCompareBc);
+        foreach ( AuxNode* node, node_list)
+        {
+            width += node->spacing( prev_type);
+            nodes_barycenter += width + node->width() / 2; 
+            width += node->width();
+            prev_type = node->type();
+            num++;
+        }
+        nodes_barycenter = nodes_barycenter / num;
+        left = center - nodes_barycenter;
+        right = left + width;
+        barycenter = center;
+        edge_num += grp->edge_num;
+    }
+};
+
+/**
+ * Compare centers of reference groups
+ */
+static bool refCompareGroups( RefGroup* g1,
+                              RefGroup* g2)
+{
+    if ( g1->left + g1->right == g2->left + g2->right) 
+    {
+        return g1->node_list.first()->order() < g2->node_list.first()->order();
+    }
+    return ( g1->left + g1->right < g2->left + g2->right);
+}
+
+/**
+ * Reference implementation of level arrangement based on linked list of groups
+ */
+static void refArrangeNodes( Level *level, GraphDir dir, bool commit_placement, bool first_pass)
+{
+    QList< RefGroup *> list;
+    foreach ( AuxNode* node, level->nodes())
+    {
+        if ( node->isForPlacement())
+            list << new RefGroup( node, dir, first_pass);
+    }
+    qSort( list.begin(), list.end(), refCompareGroups);
+    
+    QLinkedList< RefGroup *> groups;
+    foreach( RefGroup *group, list)
+    {
+        groups.push_back( group);
+    }
+    QLinkedList< RefGroup *>::iterator it = groups.begin();
+
+    while( groups.count())
+    {
+        RefGroup* grp = *it;
+        QLinkedList< RefGroup *>::iterator it_right = it;
+        it_right++;
+        bool no_merge = true; 
+
+        if ( it != groups.begin())
+        {
+            QLinkedList< RefGroup *>::iterator it_left = it;
+            it_left--;
+            RefGroup* left_grp = *it_left;
+            if ( grp->interleaves( left_grp))
+            {
+                groups.erase( it_left);
+                grp->merge( left_grp);
+                no_merge = false;
+                delete left_grp;
+            }
+        }
+        if ( it_right != groups.end())
+        {
+            RefGroup* right_grp = *it_right;
+            if ( grp->interleaves( right_grp))
+            {
+                groups.erase( it_right);
+                grp->merge( right_grp);
+                no_merge = false;
+                delete right_grp;
+            }    
+        }
+        if ( no_merge)
+            it++;
+        if ( it == groups.end())
+            break;
+    }
+    foreach ( RefGroup *grp, groups)
+    {
+        AuxNodeType prev_type = AUX_NODE_TYPES_NUM;
+        qreal curr_left = grp->left;
+        foreach ( AuxNode* node, grp->node_list)
+        {
+            curr_left += node->spacing( prev_type);
+            node->setX( curr_left);
+            curr_left += node->width();
+            prev_type = node->type();
+            if ( commit_placement)
+                node->setY( node->level()->y() - node->height() / 2 );
+        }
+        delete grp;
+    }
+}
+
+/**
+ * Lay out graph and check that horizontal placement gives exactly the same
+ * coordinates as the reference group merge algorithm
+ */
+static bool uTestPlacementEqual( AuxGraph *graph)
+{
+    AuxNode *n;
+    QHash< AuxNode *, QPointF> positions;
+    QVector< Level *> levels;
+
+    graph->doLayout();
+    
+    foreachNode( n, graph)
+    {
+        positions[ n] = QPointF( n->modelX(), n->modelY());
+        if ( levels.size() <= ( int)n->rank())
+            levels.resize( n->rank() + 1);
+        levels[ n->rank()] = n->level();
+        n->setX( 0);
+        n->setY( 0);
+    }
+
+    /** Same passes as in layout library */
+    for ( int i = 0; i < levels.size(); i++)
+    {
+        refArrangeNodes( levels[ i], GRAPH_DIR_DOWN, false, true);
+    }
+    for ( int i = levels.size() - 1; i >= 0; i--)
+    {
+        refArrangeNodes( levels[ i], GRAPH_DIR_UP, false, false);
+    }
+    for ( int i = 0; i < levels.size(); i++)
+    {
+        refArrangeNodes( levels[ i], GRAPH_DIR_DOWN, true, false);
+    }
+
+    foreachNode( n, graph)
+    {
+        if ( !n->isForPlacement())
+            continue;
+        assert( positions[ n].x() == n->modelX());
+        assert( positions[ n].y() == n->modelY());
+    }
+    return true;
+}
+
+/**
+ * Check horizontal placement on a small graph with fan-out, loops and long edges
+ */
+static bool uTestPlacementSmall()
+{
+    AuxGraph graph( true);
+    QVector< AuxNode *> nodes;
+
+    for ( int i = 0; i < 12; i++)
+    {
+        AuxNode *node = static_cast< AuxNode *>( graph.newNode());
+        node->setWidth( 20 + 15 * ( i % 4));
+        node->setHeight( 20 + 5 * ( i % 3));
+        nodes << node;
+    }
+    /** Fan-out that makes nodes interleave */
+    for ( int i = 1; i < 6; i++)
+    {
+        graph.newEdge( nodes[ 0], nodes[ i]);
+        graph.newEdge( nodes[ i], nodes[ 6]);
+    }
+    /** Diamond */
+    graph.newEdge( nodes[ 6], nodes[ 7]);
+    graph.newEdge( nodes[ 6], nodes[ 8]);
+    graph.newEdge( nodes[ 7], nodes[ 9]);
+    graph.newEdge( nodes[ 8], nodes[ 9]);
+    /** Loop */
+    graph.newEdge( nodes[ 9], nodes[ 6]);
+    /** Self edge */
+    graph.newEdge( nodes[ 7], nodes[ 7]);
+    /** Long edges */
+    graph.newEdge( nodes[ 0], nodes[ 10]);
+    graph.newEdge( nodes[ 2], nodes[ 11]);
+    graph.newEdge( nodes[ 10], nodes[ 11]);
+    graph.newEdge( nodes[ 9], nodes[ 11]);
+
+    return uTestPlacementEqual( &graph);
+}
+
+/**
+ * Check horizontal placement on a pseudo-random connected graph
+ */
+static bool uTestPlacementRandom()
+{
+    AuxGraph graph( true);
+    QVector< AuxNode *> nodes;
+
+    qsrand( 1);
+    for ( int i = 0; i < 80; i++)
+    {
+        AuxNode *node = static_cast< AuxNode *>( graph.newNode());
+        node->setWidth( 10 + qrand() % 60);
+        node->setHeight( 10 + qrand() % 30);
+        nodes << node;
+        
+        /** Spanning tree keeps graph connected */
+        if ( i > 0)
+            graph.newEdge( nodes[ qrand() % i], node);
+    }
+    for ( int i = 0; i < 80; i++)
+    {
+        int pred = qrand() % nodes.size();
+        int succ = qrand() % nodes.size();
+        if ( pred != succ)
+            graph.newEdge( nodes[ pred], nodes[ succ]);
+    }
+    return uTestPlacementEqual( &graph);
+}
+
+/**
+ * Check that long edges get one edge control per crossed rank after layout,
+ * so that every edge connects adjacent ranks
+ */
+static bool uTestEdgeControls()
+{
+    AuxGraph graph( true);
+    QVector< AuxNode *> nodes;
+
+    for ( int i = 0; i < 5; i++)
+    {
+        nodes << static_cast< AuxNode *>( graph.newNode());
+        if ( i > 0)
+            graph.newEdge( nodes[ i - 1], nodes[ i]);
+    }
+    graph.newEdge( nodes[ 0], nodes[ 3]);
+    graph.newEdge( nodes[ 4], nodes[ 1]);
+    
+    if ( !uTestPlacementEqual( &graph))
+        return false;
+
+    int control_num = 0;
+    for ( AuxNode *n = graph.firstNode(); isNotNullP( n); n = n->nextNode())
+    {
+        if ( !n->isEdgeControl())
+            continue;
+        control_num++;
+        assert( isNotNullP( n->firstPred()) && isNullP( n->firstPred()->nextPred()));
+        assert( isNotNullP( n->firstSucc()) && isNullP( n->firstSucc()->nextSucc()));
+        assert( n->level()->rank() == n->rank());
+        assert( n->level()->nodes().contains( n));
+    }
+    /** Loop makes some edges span several ranks whichever of its edges is inverted */
+    assert( control_num > 0);
+
+    for ( AuxEdge *e = graph.firstEdge(); isNotNullP( e); e = e->nextEdge())
+    {
+        assert( e->chain() == -1);
+        Rank pred_rank = e->pred()->rank();
+        Rank succ_rank = e->succ()->rank();
+        assert( pred_rank + 1 == succ_rank || succ_rank + 1 == pred_rank);
+    }
+    return true;
+}
+
+/**
+ * Check that parallel ranking gives the same layout as sequential one
+ */
+static bool uTestRankingParallel()
+{
+    AuxGraph graph( true);
+    QVector< AuxNode *> nodes;
+    QVector< Rank> ranks;
+    QVector< QPointF> positions;
+
+    /** Wide graph, so that frontiers are split between several tasks */
+    qsrand( 2);
+    for ( int i = 0; i < 3000; i++)
+    {
+        AuxNode *node = static_cast< AuxNode *>( graph.newNode());
+        node->setWidth( 10 + qrand() % 30);
+        node->setHeight( 10 + qrand() % 10);
+        nodes << node;
+        if ( i > 0)
+            graph.newEdge( nodes[ qrand() % i], node);
+    }
+    for ( int i = 0; i < 300; i++)
+    {
+        int pred = qrand() % nodes.size();
+        int succ = qrand() % nodes.size();
+        if ( pred != succ)
+            graph.newEdge( nodes[ pred], nodes[ succ]);
+    }
+    
+    graph.setParallelRankingMin( 0);
+    graph.doLayout();
+    foreach ( AuxNode *node, nodes)
+    {
+        ranks << node->rank();
+        positions << QPointF( node->modelX(), node->modelY());
+    }
+
+    graph.setParallelRankingMin( nodes.size() + 1);
+    graph.doLayout();
+    for ( int i = 0; i < nodes.size(); i++)
+    {
+        assert( nodes[ i]->rank() == ranks[ i]);
+        assert( nodes[ i]->modelX() == positions[ i].x());
+        assert( nodes[ i]->modelY() == positions[ i].y());
+    }
+    return true;
+}
+
+/**
+ * Check that greedy cycle breaking makes graph acyclic and inverts
+ * only one edge of a simple loop
+ */
+static bool uTestCycleBreakingGreedy()
+{
+    AuxGraph graph( true);
+    QVector< AuxNode *> nodes;
+
+    for ( int i = 0; i < 6; i++)
+    {
+        nodes << static_cast< AuxNode *>( graph.newNode());
+        if ( i > 0)
+            graph.newEdge( nodes[ i - 1], nodes[ i]);
+    }
+    graph.newEdge( nodes[ 5], nodes[ 0]);
+    graph.setCycleBreaking( CYCLE_BREAKING_GREEDY);
+    graph.doLayout();
+    assert( graph.invertedEdgesNum() == 1);
+
+    /** Pseudo-random graph with many loops */
+    AuxGraph rand_graph( true);
+    nodes.clear();
+    qsrand( 3);
+    for ( int i = 0; i < 80; i++)
+    {
+        AuxNode *node = static_cast< AuxNode *>( rand_graph.newNode());
+        node->setWidth( 10 + qrand() % 60);
+        node->setHeight( 10 + qrand() % 30);
+        nodes << node;
+        if ( i > 0)
+            rand_graph.newEdge( nodes[ qrand() % i], node);
+    }
+    for ( int i = 0; i < 80; i++)
+    {
+        int pred = qrand() % nodes.size();
+        int succ = qrand() % nodes.size();
+        if ( pred != succ)
+            rand_graph.newEdge( nodes[ pred], nodes[ succ]);
+    }
+    rand_graph.setCycleBreaking( CYCLE_BREAKING_GREEDY);
+    if ( !uTestPlacementEqual( &rand_graph))
+        return false;
+
+    /** Inverted edges go up, the rest go down */
+    for ( AuxEdge *e = rand_graph.firstEdge(); isNotNullP( e); e = e->nextEdge())
+    {
+        if ( e->isInverted())
+        {
+            assert( e->succ()->rank() + 1 == e->pred()->rank());
+        } else
+        {
+            assert( e->pred()->rank() + 1 == e->succ()->rank());
+        }
+    }
+    return true;
+}
+
+/**
+ * Check that layout of subgraph touches only given nodes and
+ * puts edge controls on long edges between them
+ */
+static bool uTestSubgraphLayout()
+{
+    AuxGraph graph( true);
+    QVector< AuxNode *> nodes;
+
+    for ( int i = 0; i < 8; i++)
+    {
+        AuxNode *node = static_cast< AuxNode *>( graph.newNode());
+        node->setX( 1000 + i);
+        node->setY( 2000 + i);
+        nodes << node;
+        if ( i > 0)
+            graph.newEdge( nodes[ i - 1], node);
+    }
+    graph.newEdge( nodes[ 0], nodes[ 3]);
+    graph.newEdge( nodes[ 7], nodes[ 1]);
+
+    QVector< AuxNode *> sub_nodes;
+    for ( int i = 0; i < 4; i++)
+    {
+        sub_nodes << nodes[ i];
+    }
+    graph.doLayoutSubgraph( sub_nodes);
+
+    /** First node keeps its position, nodes outside of subgraph are not moved */
+    assert( nodes[ 0]->modelX() == 1000 && nodes[ 0]->modelY() == 2000);
+    for ( int i = 4; i < 8; i++)
+    {
+        assert( nodes[ i]->modelX() == 1000 + i && nodes[ i]->modelY() == 2000 + i);
+    }
+    /** Nodes of chain go down */
+    for ( int i = 1; i < 4; i++)
+    {
+        assert( nodes[ i]->modelY() > nodes[ i - 1]->modelY());
+    }
+    /** Long edge got a control for each rank it crosses */
+    int control_num = 0;
+    for ( AuxNode *n = graph.firstNode(); isNotNullP( n); n = n->nextNode())
+    {
+        if ( n->isEdgeControl())
+            control_num++;
+    }
+    assert( control_num == 2);
+
+    /** Second layout reuses the controls */
+    graph.doLayoutSubgraph( sub_nodes);
+    assert( graph.nodeCount() == 10);
+    return true;
+}
+
+/**
+ * Check that stable node of graph with several components keeps its position,
+ * packing of components would move it
+ */
+static bool uTestStableComponents()
+{
+    AuxGraph graph( true);
+    AuxNode *top = static_cast< AuxNode *>( graph.newNode());
+    AuxNode *bottom = static_cast< AuxNode *>( graph.newNode());
+    AuxNode *stable = static_cast< AuxNode *>( graph.newNode());
+
+    graph.newEdge( top, bottom);
+    stable->setX( 5000);
+    stable->setY( 0);
+    stable->setStable( true);
+    graph.doLayout();
+
+    assert( stable->modelX() == 5000);
+    assert( bottom->modelY() > top->modelY());
+    return true;
+}
+
+/**
+ * Build grid graph for force-directed layout
+ */
+static void buildGrid( AuxGraph &graph, QVector< AuxNode *> &nodes, int side)
+{
+    for ( int i = 0; i < side * side; i++)
+    {
+        AuxNode *node = static_cast< AuxNode *>( graph.newNode());
+        node->setWidth( 20);
+        node->setHeight( 10);
+        nodes << node;
+    }
+    for ( int i = 0; i < side; i++)
+    {
+        for ( int j = 0; j < side; j++)
+        {
+            if ( j + 1 < side)
+                graph.newEdge( nodes[ i * side + j], nodes[ i * side + j + 1]);
+            if ( i + 1 < side)
+                graph.newEdge( nodes[ i * side + j], nodes[ ( i + 1) * side + j]);
+        }
+    }
+}
+
+/**
+ * Check force-directed layout: neighbours are close, nodes don't coincide,
+ * stable node keeps its position and the result is the same for the same graph
+ */
+static bool uTestForceLayout()
+{
+    const int side = 12;
+    AuxGraph graph( true);
+    AuxGraph graph2( true);
+    QVector< AuxNode *> nodes;
+    QVector< AuxNode *> nodes2;
+
+    buildGrid( graph, nodes, side);
+    buildGrid( graph2, nodes2, side);
+    graph.setLayoutEngine( LAYOUT_ENGINE_FORCE);
+    graph2.setLayoutEngine( LAYOUT_ENGINE_FORCE);
+    graph.doLayout();
+    graph2.doLayout();
+
+    /** No edge controls, graph is placed from origin */
+    assert( graph.nodeCount() == side * side);
+    qreal min_x = nodes[ 0]->modelX();
+    qreal min_y = nodes[ 0]->modelY();
+    for ( int i = 0; i < nodes.size(); i++)
+    {
+        assert( nodes[ i]->modelX() == nodes2[ i]->modelX());
+        assert( nodes[ i]->modelY() == nodes2[ i]->modelY());
+        min_x = qMin( min_x, nodes[ i]->modelX());
+        min_y = qMin( min_y, nodes[ i]->modelY());
+    }
+    assert( qAbs( min_x) < 1e-6 && qAbs( min_y) < 1e-6);
+
+    /** Edges are shorter than average distance between nodes */
+    qreal edge_len = 0;
+    int edge_num = 0;
+    for ( AuxEdge *e = graph.firstEdge(); isNotNullP( e); e = e->nextEdge())
+    {
+        edge_len += QLineF( e->pred()->modelX(), e->pred()->modelY(),
+                            e->succ()->modelX(), e->succ()->modelY()).length();
+        edge_num++;
+    }
+    qreal dist = 0;
+    int pair_num = 0;
+    for ( int i = 0; i < nodes.size(); i++)
+    {
+        for ( int j = i + 1; j < nodes.size(); j++)
+        {
+            qreal d = QLineF( nodes[ i]->modelX(), nodes[ i]->modelY(),
+                              nodes[ j]->modelX(), nodes[ j]->modelY()).length();
+            assert( d > 1);
+            dist += d;
+            pair_num++;
+        }
+    }
+    assert( edge_len / edge_num < dist / pair_num);
+
+    /** Stable node is not moved */
+    nodes[ 0]->setX( 5000);
+    nodes[ 0]->setY( 7000);
+    nodes[ 0]->setStable();
+    graph.setForceMultilevel( false);
+    graph.doLayout();
+    assert( nodes[ 0]->modelX() == 5000 && nodes[ 0]->modelY() == 7000);
+    assert( QLineF( nodes[ 0]->modelX(), nodes[ 0]->modelY(),
+                    nodes[ 1]->modelX(), nodes[ 1]->modelY()).length() < dist / pair_num);
+    return true;
+}
+
+/**
+ * Get coordinates of all nodes including edge controls in order of graph's node list
+ */
+static QVector< QPointF> nodePositions( AuxGraph &graph)
+{
+    QVector< QPointF> positions;
+
+    for ( AuxNode *n = graph.firstNode(); isNotNullP( n); n = n->nextNode())
+    {
+        positions << QPointF( n->modelX(), n->modelY());
+    }
+    return positions;
+}
+
+/**
+ * Check that deterministic layout gives the same coordinates on one and many threads,
+ * for concurrent and single-threaded runs and regardless of coordinates left by previous layout
+ */
+static bool uTestDeterministicLayout()
+{
+    QThreadPool *pool = QThreadPool::globalInstance();
+    int max_threads = pool->maxThreadCount();
+    int threads = qMax( 4, QThread::idealThreadCount());
+    AuxGraph graph( true);
+    QVector< AuxNode *> nodes;
+
+    /** Several components with long edges, cycles and self edges */
+    qsrand( 3);
+    for ( int c = 0; c < 4; c++)
+    {
+        int first = nodes.size();
+        for ( int i = 0; i < 100; i++)
+        {
+            AuxNode *node = static_cast< AuxNode *>( graph.newNode());
+            node->setWidth( 10 + qrand() % 40);
+            node->setHeight( 10 + qrand() % 20);
+            nodes << node;
+            if ( i > 0)
+                graph.newEdge( nodes[ first + qrand() % i], node);
+            if ( i % 7 == 0)
+                graph.newEdge( node, node);
+        }
+        for ( int i = 0; i < 60; i++)
+        {
+            graph.newEdge( nodes[ first + qrand() % 100], nodes[ first + qrand() % 100]);
+        }
+    }
+    graph.setDeterministic();
+    graph.setParallelRankingMin( 0);
+
+    pool->setMaxThreadCount( 1);
+    graph.doLayout();
+    QVector< QPointF> positions = nodePositions( graph);
+
+    /** Previous coordinates don't matter */
+    foreach ( AuxNode *node, nodes)
+    {
+        node->setX( qrand() % 1000);
+    }
+    pool->setMaxThreadCount( threads);
+    graph.doLayout();
+    assert( nodePositions( graph) == positions);
+
+    /**
+     * Concurrent layout gives the same result. Its watcher and timers need event dispatcher,
+     * unit tests run without application object so a temporary one is made for the check
+     */
+    static int app_argc = 0;
+    QCoreApplication *app = NULL;
+
+    if ( isNullP( QCoreApplication::instance()))
+        app = new QCoreApplication( app_argc, NULL);
+
+    QEventLoop loop;
+    QObject::connect( &graph, SIGNAL( layoutDone()), &loop, SLOT( quit()));
+    graph.setLayoutDeadline( LAYOUT_DEADLINE);
+    graph.doLayoutConcurrent();
+    loop.exec();
+    assert( nodePositions( graph) == positions);
+    delete app;
+
+    /** Force-directed layout accumulates forces in parallel for big graphs */
+    AuxGraph force_graph( true);
+    QVector< AuxNode *> force_nodes;
+
+    buildGrid( force_graph, force_nodes, 50);
+    force_graph.setLayoutEngine( LAYOUT_ENGINE_FORCE);
+    pool->setMaxThreadCount( 1);
+    force_graph.doLayout();
+    positions = nodePositions( force_graph);
+    pool->setMaxThreadCount( threads);
+    force_graph.doLayout();
+    assert( nodePositions( force_graph) == positions);
+
+    pool->setMaxThreadCount( max_threads);
+    return true;
+}
+
+/**
+ * Check layout metrics on graphs with known crossings
+ */
+static bool uTestLayoutMetrics()
+{
+    /** Complete bipartite graph K3,3 has 9 crossings in any order of nodes */
+    AuxGraph graph( true);
+    QVector< AuxNode *> upper;
+    QVector< AuxNode *> lower;
+
+    for ( int i = 0; i < 3; i++)
+    {
+        upper << static_cast< AuxNode *>( graph.newNode());
+        lower << static_cast< AuxNode *>( graph.newNode());
+    }
+    for ( int i = 0; i < 3; i++)
+    {
+        for ( int j = 0; j < 3; j++)
+        {
+            graph.newEdge( upper[ i], lower[ j]);
+        }
+    }
+    graph.doLayout();
+
+    LayoutMetrics metrics;
+    metrics.compute( &graph);
+    assert( metrics.node_num == 6);
+    assert( metrics.edge_num == 9);
+    assert( metrics.dummy_num == 0);
+    assert( metrics.inverted_num == 0);
+    assert( metrics.level_crossings.size() == 1);
+    assert( metrics.level_crossings[ 0] == 9);
+    assert( metrics.crossings == 9);
+    assert( metrics.total_edge_len > 0);
+    assert( metrics.max_edge_len <= metrics.total_edge_len);
+    assert( metrics.area > 0);
+    for ( int i = 0; i < LAYOUT_PHASE_NUM; i++)
+    {
+        assert( metrics.phase_time[ i] >= 0);
+    }
+
+    /** Long edge gets an edge control and edges that share an end don't cross */
+    AuxGraph chain_graph( true);
+    AuxNode *a = static_cast< AuxNode *>( chain_graph.newNode());
+    AuxNode *b = static_cast< AuxNode *>( chain_graph.newNode());
+    AuxNode *c = static_cast< AuxNode *>( chain_graph.newNode());
+
+    chain_graph.newEdge( a, b);
+    chain_graph.newEdge( b, c);
+    chain_graph.newEdge( a, c);
+    chain_graph.newEdge( c, a);
+    chain_graph.doLayout();
+    metrics.compute( &chain_graph);
+    assert( metrics.node_num == 3);
+    assert( metrics.edge_num == 4);
+    assert( metrics.dummy_num == 2);
+    assert( metrics.inverted_num == 1);
+    assert( metrics.crossings == 0);
+    assert( !metrics.toJSON().isEmpty());
+    return true;
+}
+
+/**
+ * Unit tests for Layout library
+ */
+bool uTestLayout()
+{
+    /**
+     * Check that group merging keeps placement unchanged
+     */
+    if ( !uTestPlacementSmall())
+        return false;
+
+    if ( !uTestPlacementRandom())
+        return false;
+
+    /**
+     * Check creation of edge controls from chains of long edges
+     */
+    if ( !uTestEdgeControls())
+        return false;
+
+    /**
+     * Check that parallel ranking doesn't change the result
+     */
+    if ( !uTestRankingParallel())
+        return false;
+
+    /**
+     * Check greedy cycle breaking
+     */
+    if ( !uTestCycleBreakingGreedy())
+        return false;
+
+    /**
+     * Check layout of subgraph
+     */
+    if ( !uTestSubgraphLayout())
+        return false;
+
+    /**
+     * Check that stable nodes are not moved by packing of components
+     */
+    if ( !uTestStableComponents())
+        return false;
+
+    /**
+     * Check force-directed layout
+     */
+    if ( !uTestForceLayout())
+        return false;
+
+    /**
+     * Check that layout doesn't depend on number of threads
+     */
+    if ( !uTestDeterministicLayout())
+        return false;
+
+    /**
+     * Check layout metrics
+     */
+    if ( !uTestLayoutMetrics())
+        return false;
+
+    return true;
+}
@@ -46,6 +46,10 @@ int main(int argc, char **argv)
     if ( !uTestGraph())
         return -1;
 
+    /** Test layout */
+    if ( !uTestLayout())
+        return -1;
+
     /** Test frontend */
     if ( !uTestFE())
         return -1;
@@ -38,3 +38,8 @@ bool uTestGUI(int argc, char **argv);
  * Frontend unit testing
  */
 bool uTestFE();
+
+/**
+ * Layout library unit testing
+ */
+bool uTestLayout();
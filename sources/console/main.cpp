@@ -42,23 +42,57 @@ static int doAll( int argc, char **argv)
     Conf conf;
     conf.addOption( new Option( OPT_STRING, "f", "file", "input graph description file name"));
     conf.addOption( new Option( OPT_STRING, "o", "output", "output image file name"));
+    conf.addOption( new Option( OPT_STRING, "c", "cycles", "cycle breaking algorithm for layout: dfs ( default) or greedy"));
+    conf.addOption( new Option( OPT_STRING, "e", "engine", "layout engine: layered ( default) or force"));
+    conf.addOption( new Option( "d", "deterministic", "layout depends only on graph, for regression runs", false));
+    conf.addOption( new Option( OPT_INT, "t", "threads", "maximal number of threads used by layout"));
+    conf.addOption( new Option( OPT_STRING, "m", "metrics", "file for layout metrics in JSON, - for standard output"));
     conf.readArgs( argc, argv);
     
     Option *fopt = conf.longOption("file");
     Option *out_opt = conf.longOption("output");
+    Option *cycles_opt = conf.longOption("cycles");
+    Option *engine_opt = conf.longOption("engine");
+    Option *det_opt = conf.longOption("deterministic");
+    Option *threads_opt = conf.longOption("threads");
+    Option *metrics_opt = conf.longOption("metrics");
     
     assertd( isNotNullP( fopt));
     assertd( isNotNullP( out_opt));
+    assertd( isNotNullP( cycles_opt));
+    assertd( isNotNullP( engine_opt));
+    assertd( isNotNullP( det_opt));
+    assertd( isNotNullP( threads_opt));
+    assertd( isNotNullP( metrics_opt));
     if ( fopt->isDefined())
     {
         QString xmlname = fopt->string();
         QString outname("image.png");
+        QString metrics_name;
+        CycleBreaking cycle_breaking = CYCLE_BREAKING_DFS;
+        LayoutEngine engine = LAYOUT_ENGINE_LAYERED;
         Renderer r;
         if ( out_opt->isDefined())
         {
             outname = out_opt->string();
         }
-        r.render( xmlname, outname);
+        if ( cycles_opt->isDefined() && cycles_opt->string() == "greedy")
+        {
+            cycle_breaking = CYCLE_BREAKING_GREEDY;
+        }
+        if ( engine_opt->isDefined() && engine_opt->string() == "force")
+        {
+            engine = LAYOUT_ENGINE_FORCE;
+        }
+        if ( threads_opt->isDefined() && threads_opt->intVal() > 0)
+        {
+            QThreadPool::globalInstance()->setMaxThreadCount( threads_opt->intVal());
+        }
+        if ( metrics_opt->isDefined())
+        {
+            metrics_name = metrics_opt->string();
+        }
+        r.render( xmlname, outname, cycle_breaking, engine, det_opt->isSet(), metrics_name);
     } else
     {
         conf.printOpts(); // Print options to console
@@ -22,7 +22,9 @@
 /**
  * Render picture for graph described in XML
  */
-bool Renderer::render( QString xmlname, QString outname)
+bool Renderer::render( QString xmlname, QString outname,
+                       CycleBreaking cycle_breaking, LayoutEngine engine, bool deterministic,
+                       QString metrics_name)
 {
     QTextStream sout( stdout);
     QTextStream serr( stdout);
@@ -47,25 +49,45 @@ bool Renderer::render( QString xmlname, QString outname)
      * Perform layout in single thread. 
      * Multi thread wouldn't work since we do not run QApplication::exec() and there is not event loop
      */
+    graph_view->graph()->setCycleBreaking( cycle_breaking);
+    graph_view->graph()->setLayoutEngine( engine);
+    graph_view->graph()->setDeterministic( deterministic);
     graph_view->graph()->doLayoutSingle();
+    sout << tr("Inverted edges: %1\n")
+            .arg( graph_view->graph()->invertedEdgesNum());
 
-    /** Get scene rectangle */
-    QRectF scene_rect( graph_view->scene()->itemsBoundingRect()
-                       .adjusted( -IMAGE_RECT_ADJUST, -IMAGE_RECT_ADJUST,
-                                   IMAGE_RECT_ADJUST, IMAGE_RECT_ADJUST));
+    /** Write layout metrics */
+    if ( !metrics_name.isEmpty())
+    {
+        LayoutMetrics metrics;
 
-    /** Render to image */
-	QImage image( scene_rect.width() * IMAGE_EXPORT_SCALE_FACTOR,
-		          scene_rect.height() * IMAGE_EXPORT_SCALE_FACTOR,
-				  QImage::Format_RGB32);
-    image.fill( graph_view->palette().base().color().rgb());
-    QPainter pp( &image);
-	pp.setRenderHints( graph_view->renderHints());
-    graph_view->scene()->render( &pp, image.rect(), scene_rect);
-    QImageWriter writer( outname);
-    
-    /** Write image to file */
-    if ( writer.canWrite() && writer.write( image))
+        metrics.compute( graph_view->graph());
+        if ( metrics_name == "-")
+        {
+            sout << metrics.toJSON();
+        } else
+        {
+            QFile metrics_file( metrics_name);
+
+            if ( !metrics_file.open( QFile::WriteOnly | QFile::Text))
+            {
+                serr << tr("Cannot write file %1:\n%2.\n")
+                        .arg( metrics_name)
+                        .arg( metrics_file.errorString());
+                return false;
+            }
+            QTextStream mout( &metrics_file);
+            mout << metrics.toJSON();
+        }
+    }
+
+    /**
+     * Render to image by tiles and write it to file. Bands of tiles are waited for
+     * as there is no event loop, BMP files are written band by band
+     */
+    ImageExport image_export( graph_view, outname, IMAGE_EXPORT_SCALE_FACTOR, IMAGE_RECT_ADJUST);
+
+    if ( image_export.run())
     {
         sout << tr("Rendered %1 to %2\n")
                 .arg( xmlname)
@@ -74,8 +96,8 @@ bool Renderer::render( QString xmlname, QString outname)
     } else
     {
         serr << tr("Cannot write file %1:\n%2\n")
-                .arg( xmlname)
-                .arg( writer.errorString());
+                .arg( outname)
+                .arg( image_export.errorString());
         return false;
     }
     return true;
@@ -32,8 +32,15 @@
 class Renderer: public QObject
 {
 public:
-    /** Render specified graph to specified image file */
-    bool render( QString xmlname, QString outname);
+    /**
+     * Render specified graph to specified image file using given layout engine and cycle breaking algorithm.
+     * Layout metrics are written in JSON to file metrics_name if it is given, "-" stands for standard output
+     */
+    bool render( QString xmlname, QString outname,
+                 CycleBreaking cycle_breaking = CYCLE_BREAKING_DFS,
+                 LayoutEngine engine = LAYOUT_ENGINE_LAYERED,
+                 bool deterministic = false,
+                 QString metrics_name = QString());
 };
 
 #endif /* RENDER_H */
\ No newline at end of file
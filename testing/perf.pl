@@ -44,6 +44,7 @@ sub initInfo
     my $info = {};
     
     $info->{results} = {};
+    $info->{inverted} = {};
     $info->{tests} = tests();
     $info->{cwd} = abs_path( getcwd());
     $info->{bindir} = abs_path( addPath( $info->{cwd}, "..\\bin"));
@@ -57,6 +58,9 @@ sub initInfo
     
     #iteration number for taking average runtime to get more stable results
     $info->{iterations} = 1;
+    
+    #cycle breaking algorithms of layout to compare
+    $info->{algorithms} = [ 'dfs', 'greedy'];
     return $info;
 }
 
@@ -130,34 +134,43 @@ sub checkTests
     return 1;
 }
 
-#Run tests and collect rutimes
+#Run tests with every cycle breaking algorithm and collect rutimes
 sub runTests
 {
     my ( $info) = @_;
     foreach my $test ( keys %{$info->{tests}})
     {
         my $filename = $info->{tests}->{$test};
-        runTest( $info, $test, $filename);
+        foreach my $algo ( @{$info->{algorithms}})
+        {
+            runTest( $info, $test, $filename, $algo);
+        }
     }
 }
 
-# Print runtimes for tests
+# Print runtimes and numbers of inverted edges for tests
 sub printResults
 {
     my ( $info) = @_;
     print "Results:\n";
     foreach my $test ( keys %{$info->{results}})
     {
-        print $test.": ".$info->{results}->{$test}."\n";
+        print $test.":";
+        foreach my $algo ( @{$info->{algorithms}})
+        {
+            print " ".$algo." ".$info->{results}->{$test}->{$algo}
+                  ." (inverted ".$info->{inverted}->{$test}->{$algo}.")";
+        }
+        print "\n";
     }
 }
 
 #Run one test and measure its run time
 sub runTest
 {
-    my ( $info, $test, $filename) = @_;
+    my ( $info, $test, $filename, $algo) = @_;
     my $outname = $test.".png";
-    my $cmd = $info->{showgraph}." -f ".addPath( $info->{testdir}, $filename)." -o ".$outname;
+    my $cmd = $info->{showgraph}." -f ".addPath( $info->{testdir}, $filename)." -o ".$outname." -c ".$algo;
     
     dprint( TESTS, "Running ".$cmd);
     
@@ -174,19 +187,25 @@ sub runTest
         }
         
         #run test
-        system $cmd;
+        my $output = `$cmd`;
         my $stop = gettimeofday();
         
         #check that file with picture is present
         if ( !(-f $outname))
         {
-            $info->{results}->{$test} = FAIL;
+            $info->{results}->{$test}->{$algo} = FAIL;
             return;
         }
         $runtime += $stop - $start;
+        
+        #number of edges inverted by layout
+        if ( $output =~ /Inverted edges: (\d+)/)
+        {
+            $info->{inverted}->{$test}->{$algo} = $1;
+        }
     }
     # Save arithmetic mean
-    $info->{results}->{$test} = $runtime / $info->{iterations};
+    $info->{results}->{$test}->{$algo} = $runtime / $info->{iterations};
 }
 
 #Print str if mode is enabled for print